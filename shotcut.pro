@@ -10,6 +10,12 @@ SUBDIRS = CuteLogger src translations
 cache()
 src.depends = CuteLogger
 
+# The unit tests and benchmarks are built with 'qmake -r CONFIG+=shotcut_tests'.
+shotcut_tests {
+    SUBDIRS += tests
+    tests.depends = CuteLogger
+}
+
 codespell.target = codespell
 codespell.commands = codespell -w -q 3 \
     -L shotcut,uint,seeked \
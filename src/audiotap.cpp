@@ -0,0 +1,159 @@
+/*
+ * Copyright (c) 2021 Meltytech, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "audiotap.h"
+#include "mltcontroller.h"
+#include <Logger.h>
+#include <string.h>
+#include <atomic>
+
+AudioTap::AudioTap()
+    : m_samples(kCapacity)
+    , m_writePosition(0)
+    , m_writeBegin(0)
+    , m_format(0)
+    , m_formatPosition(0)
+{
+}
+
+void AudioTap::write(const SharedFrame& frame)
+{
+    if (!frame.is_valid() || frame.get_audio_format() != mlt_audio_s16)
+        return;
+    int channels = frame.get_audio_channels();
+    int frequency = frame.get_audio_frequency();
+    int samples = frame.get_audio_samples();
+    if (channels <= 0 || channels > 0xff || frequency <= 0 || samples <= 0)
+        return;
+    const int16_t* src = frame.get_audio();
+    if (!src)
+        return;
+
+    // Only this thread changes the write position.
+    quint64 position = m_writePosition.load();
+    int format = channels | frequency << 8;
+    if (format != m_format.load()) {
+        // Readers check the format before and after the positions.
+        m_formatPosition.storeRelease(position);
+        m_format.storeRelease(format);
+    }
+
+    int count = samples * channels;
+    if (count > kCapacity) {
+        int keep = kCapacity / channels * channels;
+        src += count - keep;
+        count = keep;
+    }
+    int offset = int(position & (kCapacity - 1));
+    int head = qMin(count, kCapacity - offset);
+    int16_t* dst = m_samples.data();
+    // Announce the samples before they overwrite the ring, like a seqlock, so
+    // that a reader that copies while they land sees that it was lapped.
+    m_writeBegin.store(position + count);
+    std::atomic_thread_fence(std::memory_order_release);
+    memcpy(dst + offset, src, head * sizeof(int16_t));
+    memcpy(dst, src + head, (count - head) * sizeof(int16_t));
+    m_writePosition.storeRelease(position + count);
+}
+
+// Moves a reader's cursor and format to the current format and sets the end
+// of the samples that are ready for it. Returns whether there are any.
+bool AudioTap::pending(quint64& cursor, int& format, quint64& end) const
+{
+    int before, after;
+    quint64 formatPosition;
+    do {
+        before = m_format.loadAcquire();
+        formatPosition = m_formatPosition.loadAcquire();
+        end = m_writePosition.loadAcquire();
+        after = m_format.loadAcquire();
+    } while (before != after);
+
+    if (!after)
+        return false;
+    if (cursor < formatPosition || format != after) {
+        // Samples of an older format are of no use anymore.
+        cursor = qMax(cursor, formatPosition);
+        format = after;
+    }
+    if (end - cursor > quint64(kCapacity)) {
+        LOG_DEBUG() << "skipping" << (end - cursor) << "samples";
+        cursor = end;
+    }
+    return end > cursor;
+}
+
+void AudioTap::copy(quint64 from, int count, int16_t* dst) const
+{
+    int offset = int(from & (kCapacity - 1));
+    int head = qMin(count, kCapacity - offset);
+    const int16_t* src = m_samples.constData();
+    memcpy(dst, src + offset, head * sizeof(int16_t));
+    memcpy(dst + head, src, (count - head) * sizeof(int16_t));
+}
+
+// Returns whether the samples from \a from on were not overwritten yet,
+// including by a write that is still in progress. Call after copying.
+bool AudioTap::isIntact(quint64 from) const
+{
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return m_writeBegin.load() - from <= quint64(kCapacity);
+}
+
+AudioTapReader::AudioTapReader(AudioTap* tap)
+    : m_tap(tap)
+    , m_cursor(tap->m_writePosition.loadAcquire())
+    , m_format(0)
+    , m_convertFilter(MLT.profile(), "audioconvert")
+{
+}
+
+Mlt::Frame AudioTapReader::read()
+{
+    quint64 end = 0;
+    if (!m_tap->pending(m_cursor, m_format, end))
+        return Mlt::Frame(nullptr);
+
+    int channels = m_format & 0xff;
+    int frequency = m_format >> 8;
+    int samples = int(end - m_cursor) / channels;
+    if (!samples)
+        return Mlt::Frame(nullptr);
+    int count = samples * channels;
+    int size = count * sizeof(int16_t);
+    int16_t* audio = static_cast<int16_t*>(mlt_pool_alloc(size));
+    m_tap->copy(m_cursor, count, audio);
+    if (!m_tap->isIntact(m_cursor)) {
+        // The writer lapped this reader while copying.
+        mlt_pool_release(audio);
+        m_cursor = end;
+        return Mlt::Frame(nullptr);
+    }
+    m_cursor += count;
+
+    mlt_frame init = mlt_frame_init(nullptr);
+    Mlt::Frame frame(init);
+    mlt_frame_close(init);
+    frame.set("audio", audio, size, mlt_pool_release);
+    frame.set("audio_format", mlt_audio_s16);
+    frame.set("audio_channels", channels);
+    frame.set("audio_frequency", frequency);
+    frame.set("audio_samples", samples);
+    // Lets filters ask for other formats, such as float.
+    m_convertFilter.process(frame);
+    return frame;
+}
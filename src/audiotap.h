@@ -0,0 +1,101 @@
+/*
+ * Copyright (c) 2021 Meltytech, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef AUDIOTAP_H
+#define AUDIOTAP_H
+
+#include "sharedframe.h"
+#include <QAtomicInteger>
+#include <QAtomicInt>
+#include <QVector>
+#include <MltFilter.h>
+#include <stdint.h>
+
+/*!
+  \class AudioTap
+  \brief The AudioTap passes the audio of the displayed frames to the audio
+  scopes without dropping or copying frames.
+
+  \threadsafe
+
+  AudioTap is a lock-free ring of interleaved signed 16-bit samples with one
+  writer and any number of readers. The frame renderer calls write() for
+  every frame it shows. Each AudioTapReader has its own position in the ring
+  and gets all of the samples written since its last read as one contiguous
+  block, however many frames that spans.
+
+  The ring holds several seconds of audio. A reader that falls further behind
+  than that (e.g. a hidden scope) skips ahead to the newest samples.
+*/
+
+class AudioTap
+{
+public:
+    AudioTap();
+
+    //! Appends the audio of \a frame. Must only be called by one thread.
+    void write(const SharedFrame& frame);
+
+private:
+    friend class AudioTapReader;
+
+    // Capacity in samples; a power of two so that positions wrap by masking.
+    enum { kCapacity = 1 << 20 };
+
+    bool pending(quint64& cursor, int& format, quint64& end) const;
+    void copy(quint64 from, int count, int16_t* dst) const;
+    bool isIntact(quint64 from) const;
+
+    QVector<int16_t> m_samples;
+    //! Total samples written, which only grows.
+    QAtomicInteger<quint64> m_writePosition;
+    //! The write position after the write in progress, set before copying.
+    QAtomicInteger<quint64> m_writeBegin;
+    //! Channels in the low 8 bits and frequency above them.
+    QAtomicInt m_format;
+    //! The write position at the last change of m_format.
+    QAtomicInteger<quint64> m_formatPosition;
+};
+
+/*!
+  \class AudioTapReader
+  \brief The AudioTapReader reads the audio of an AudioTap from one scope.
+
+  A reader is used by only one thread at a time. It starts at the newest
+  samples.
+*/
+
+class AudioTapReader
+{
+public:
+    explicit AudioTapReader(AudioTap* tap);
+
+    /*!
+      Returns a new frame with all of the samples that were written since the
+      last call, or an invalid frame if there are none. The frame can be
+      processed by MLT filters and asked for any audio format.
+    */
+    Mlt::Frame read();
+
+private:
+    AudioTap* m_tap;
+    quint64 m_cursor;
+    int m_format;
+    Mlt::Filter m_convertFilter;
+};
+
+#endif // AUDIOTAP_H
@@ -43,6 +43,7 @@ AppendCommand::AppendCommand(MultitrackModel &model, int trackIndex, const QStri
     , m_skipProxy(skipProxy)
 {
     setText(QObject::tr("Append to track"));
+    m_undoHelper.limitToTracks({m_trackIndex});
 }
 
 void AppendCommand::redo()
@@ -89,6 +90,8 @@ InsertCommand::InsertCommand(MultitrackModel &model, int trackIndex,
     , m_rippleAllTracks(Settings.timelineRippleAllTracks())
 {
     setText(QObject::tr("Insert into track"));
+    if (!m_rippleAllTracks)
+        m_undoHelper.limitToTracks({m_trackIndex});
 }
 
 void InsertCommand::redo()
@@ -133,6 +136,7 @@ OverwriteCommand::OverwriteCommand(MultitrackModel &model, int trackIndex,
     , m_seek(seek)
 {
     setText(QObject::tr("Overwrite onto track"));
+    m_undoHelper.limitToTracks({m_trackIndex});
 }
 
 void OverwriteCommand::redo()
@@ -177,6 +181,7 @@ LiftCommand::LiftCommand(MultitrackModel &model, int trackIndex,
 {
     setText(QObject::tr("Lift from track"));
     m_undoHelper.setHints(UndoHelper::RestoreTracks);
+    m_undoHelper.limitToTracks({m_trackIndex});
 }
 
 void LiftCommand::redo()
@@ -204,6 +209,8 @@ RemoveCommand::RemoveCommand(MultitrackModel &model, int trackIndex,
 {
     setText(QObject::tr("Remove from track"));
     m_undoHelper.setHints(UndoHelper::RestoreTracks);
+    if (!m_rippleAllTracks)
+        m_undoHelper.limitToTracks({m_trackIndex});
 }
 
 void RemoveCommand::redo()
@@ -252,6 +259,7 @@ MergeCommand::MergeCommand(MultitrackModel& model, int trackIndex, int clipIndex
     , m_undoHelper(m_model)
 {
     setText(QObject::tr("Merge adjacent clips"));
+    m_undoHelper.limitToTracks({m_trackIndex});
 }
 
 void MergeCommand::redo()
@@ -486,6 +494,8 @@ void TrimClipInCommand::redo()
         } else {
             m_undoHelper->setHints(UndoHelper::RestoreTracks);
         }
+        if (!m_ripple || !m_rippleAllTracks)
+            m_undoHelper->limitToTracks({m_trackIndex});
         m_undoHelper->recordBeforeState();
         m_model.trimClipIn(m_trackIndex, m_clipIndex, m_delta, m_ripple, m_rippleAllTracks);
         m_undoHelper->recordAfterState();
@@ -534,6 +544,8 @@ void TrimClipOutCommand::redo()
         m_undoHelper.reset(new UndoHelper(m_model));
         if (!m_ripple)
             m_undoHelper->setHints(UndoHelper::SkipXML);
+        if (!m_ripple || !m_rippleAllTracks)
+            m_undoHelper->limitToTracks({m_trackIndex});
         m_undoHelper->recordBeforeState();
         m_clipIndex = m_model.trimClipOut(m_trackIndex, m_clipIndex, m_delta, m_ripple, m_rippleAllTracks);
         m_undoHelper->recordAfterState();
@@ -572,6 +584,7 @@ SplitCommand::SplitCommand(MultitrackModel &model, int trackIndex,
     , m_undoHelper(m_model)
 {
     setText(QObject::tr("Split clip"));
+    m_undoHelper.limitToTracks({m_trackIndex});
 }
 
 void SplitCommand::redo()
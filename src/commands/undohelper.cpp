@@ -49,13 +49,13 @@ void UndoHelper::recordBeforeState()
         QScopedPointer<Mlt::Producer> trackProducer(m_model.tractor()->track(mltIndex));
         Mlt::Playlist playlist(*trackProducer);
 
+        bool inScope = isTrackInScope(i);
+
         for (int j = 0; j < playlist.count(); ++j) {
             QScopedPointer<Mlt::Producer> clip(playlist.get_clip(j));
             QUuid uid = MLT.ensureHasUuid(*clip);
             m_insertedOrder << uid;
             Info& info = m_state[uid];
-            if (!(m_hints & SkipXML))
-                info.xml = MLT.XML(&clip->parent());
             Mlt::ClipInfo clipInfo;
             playlist.clip_info(j, &clipInfo);
             info.frame_in = clipInfo.frame_in;
@@ -63,6 +63,8 @@ void UndoHelper::recordBeforeState()
             info.oldTrackIndex = i;
             info.oldClipIndex = j;
             info.isBlank = playlist.is_blank(j);
+            if (!(m_hints & SkipXML) && inScope && !info.isBlank)
+                info.xml = MLT.XML(&clip->parent());
         }
     }
 }
@@ -107,7 +109,7 @@ void UndoHelper::recordAfterState()
                     m_affectedTracks << info.newTrackIndex;
                 }
 
-                if (!(m_hints & SkipXML) && !info.isBlank) {
+                if (!(m_hints & SkipXML) && !info.isBlank && isTrackInScope(i)) {
                     QString newXml = MLT.XML(&clip->parent());
                     if (info.xml != newXml) {
                         UNDOLOG << "Modified xml:" << uid;
@@ -138,6 +140,16 @@ void UndoHelper::recordAfterState()
         info.changes = Removed;
         m_affectedTracks << info.oldTrackIndex;
     }
+
+    /* Clips on tracks outside of the scope have no XML from before the
+     * change, so undo cannot restore those tracks. Commands that may change
+     * other tracks, such as rippling all tracks, must not limit the scope. */
+    if (!(m_hints & SkipXML) && !m_trackScope.isEmpty()) {
+        QSet<int> unscopedTracks = m_affectedTracks - m_trackScope;
+        if (!unscopedTracks.isEmpty())
+            LOG_WARNING() << "tracks" << unscopedTracks << "changed outside of the undo scope" << m_trackScope;
+        Q_ASSERT(unscopedTracks.isEmpty());
+    }
 }
 
 void UndoHelper::undoChanges()
@@ -284,6 +296,18 @@ void UndoHelper::setHints(OptimizationHints hints)
     m_hints = hints;
 }
 
+/* Only serialize clips on these tracks. The caller guarantees the command
+ * does not change any other track. An empty set means all tracks. */
+void UndoHelper::limitToTracks(const QSet<int>& trackIndices)
+{
+    m_trackScope = trackIndices;
+}
+
+bool UndoHelper::isTrackInScope(int trackIndex) const
+{
+    return m_trackScope.isEmpty() || m_trackScope.contains(trackIndex);
+}
+
 void UndoHelper::debugPrintState()
 {
     qDebug("timeline state: {");
@@ -40,8 +40,10 @@ public:
     void recordAfterState();
     void undoChanges();
     void setHints(OptimizationHints hints);
+    void limitToTracks(const QSet<int>& trackIndices);
 
 private:
+    bool isTrackInScope(int trackIndex) const;
     void debugPrintState();
     void restoreAffectedTracks();
     void fixTransitions(Mlt::Playlist playlist, int clipIndex, Mlt::Producer clip);
@@ -84,6 +86,7 @@ private:
     QList<QUuid> m_clipsAdded;
     QList<QUuid> m_insertedOrder;
     QSet<int> m_affectedTracks;
+    QSet<int> m_trackScope;
     MultitrackModel & m_model;
     OptimizationHints m_hints;
 };
@@ -27,6 +27,8 @@
 #include "widgets/scopes/videowaveformscopewidget.h"
 #include "widgets/scopes/videozoomscopewidget.h"
 #include "docks/scopedock.h"
+#include "dialogs/scopestatisticsdialog.h"
+#include "glwidget.h"
 #include "settings.h"
 #include <Logger.h>
 #include <QMainWindow>
@@ -34,30 +36,60 @@
 
 ScopeController::ScopeController(QMainWindow* mainWindow, QMenu* menu)
   : QObject(mainWindow)
+  , m_audioAnalyzer(static_cast<Mlt::GLWidget*>(MLT.videoWidget())->audioTap())
+  , m_mainWindow(mainWindow)
+  , m_statisticsDialog(nullptr)
 {
     LOG_DEBUG() << "begin";
+    m_videoAnalyzer.setQuality(VideoScopeAnalyzer::Quality(Settings.videoScopeQuality()));
     QMenu* scopeMenu = menu->addMenu(tr("Scopes"));
-    createScopeDock<AudioLoudnessScopeWidget>(mainWindow, scopeMenu);
-    createScopeDock<AudioPeakMeterScopeWidget>(mainWindow, scopeMenu);
-    createScopeDock<AudioSpectrumScopeWidget>(mainWindow, scopeMenu);
+    createAudioScopeDock<AudioLoudnessScopeWidget>(mainWindow, scopeMenu);
+    createAudioScopeDock<AudioPeakMeterScopeWidget>(mainWindow, scopeMenu);
+    createAudioScopeDock<AudioSpectrumScopeWidget>(mainWindow, scopeMenu);
     createScopeDock<AudioWaveformScopeWidget>(mainWindow, scopeMenu);
     if (!Settings.playerGPU()) {
-        createScopeDock<VideoHistogramScopeWidget>(mainWindow, scopeMenu);
-        createScopeDock<VideoRgbParadeScopeWidget>(mainWindow, scopeMenu);
-        createScopeDock<VideoRgbWaveformScopeWidget>(mainWindow, scopeMenu);
-        createScopeDock<VideoVectorScopeWidget>(mainWindow, scopeMenu);
-        createScopeDock<VideoWaveformScopeWidget>(mainWindow, scopeMenu);
+        createVideoScopeDock<VideoHistogramScopeWidget>(mainWindow, scopeMenu);
+        createVideoScopeDock<VideoRgbParadeScopeWidget>(mainWindow, scopeMenu);
+        createVideoScopeDock<VideoRgbWaveformScopeWidget>(mainWindow, scopeMenu);
+        createVideoScopeDock<VideoVectorScopeWidget>(mainWindow, scopeMenu);
+        createVideoScopeDock<VideoWaveformScopeWidget>(mainWindow, scopeMenu);
         createScopeDock<VideoZoomScopeWidget>(mainWindow, scopeMenu);
     }
+    scopeMenu->addSeparator();
+    scopeMenu->addAction(tr("Statistics..."), this, SLOT(showStatistics()));
     LOG_DEBUG() << "end";
 }
 
 template<typename ScopeTYPE> void ScopeController::createScopeDock(QMainWindow* mainWindow, QMenu* menu)
 {
-    ScopeWidget* scopeWidget = new ScopeTYPE();
-    ScopeDock* scopeDock = new ScopeDock(this, scopeWidget);
+    addScopeDock(new ScopeTYPE(), mainWindow, menu);
+}
+
+template<typename ScopeTYPE> void ScopeController::createAudioScopeDock(QMainWindow* mainWindow, QMenu* menu)
+{
+    addScopeDock(new ScopeTYPE(&m_audioAnalyzer), mainWindow, menu);
+}
+
+template<typename ScopeTYPE> void ScopeController::createVideoScopeDock(QMainWindow* mainWindow, QMenu* menu)
+{
+    addScopeDock(new ScopeTYPE(&m_videoAnalyzer), mainWindow, menu, &m_videoAnalyzer);
+}
+
+void ScopeController::addScopeDock(ScopeWidget* scopeWidget, QMainWindow* mainWindow, QMenu* menu,
+                                   VideoScopeAnalyzer* analyzer)
+{
+    m_scopeWidgets << scopeWidget;
+    ScopeDock* scopeDock = new ScopeDock(this, scopeWidget, analyzer);
     scopeDock->hide();
     menu->addAction(scopeDock->toggleViewAction());
     mainWindow->addDockWidget(Qt::RightDockWidgetArea, scopeDock);
 }
 
+void ScopeController::showStatistics()
+{
+    if (!m_statisticsDialog)
+        m_statisticsDialog = new ScopeStatisticsDialog(m_scopeWidgets, m_mainWindow);
+    m_statisticsDialog->show();
+    m_statisticsDialog->raise();
+    m_statisticsDialog->activateWindow();
+}
@@ -19,13 +19,18 @@
 #ifndef SCOPECONTROLLER_H
 #define SCOPECONTROLLER_H
 
+#include <QList>
 #include <QObject>
 #include <QString>
 #include "sharedframe.h"
+#include "widgets/scopes/audioscopeanalyzer.h"
+#include "widgets/scopes/videoscopeanalyzer.h"
 
 class QMainWindow;
 class QMenu;
 class QWidget;
+class ScopeStatisticsDialog;
+class ScopeWidget;
 
 class ScopeController Q_DECL_FINAL : public QObject
 {
@@ -37,9 +42,21 @@ public:
 signals:
     void newFrame(const SharedFrame& frame);
 
+private slots:
+    void showStatistics();
+
 private:
     template<typename ScopeTYPE> void createScopeDock(QMainWindow* mainWindow, QMenu* menu);
-
+    template<typename ScopeTYPE> void createAudioScopeDock(QMainWindow* mainWindow, QMenu* menu);
+    template<typename ScopeTYPE> void createVideoScopeDock(QMainWindow* mainWindow, QMenu* menu);
+    void addScopeDock(ScopeWidget* scopeWidget, QMainWindow* mainWindow, QMenu* menu,
+                      VideoScopeAnalyzer* analyzer = nullptr);
+
+    AudioScopeAnalyzer m_audioAnalyzer;
+    VideoScopeAnalyzer m_videoAnalyzer;
+    QMainWindow* m_mainWindow;
+    QList<ScopeWidget*> m_scopeWidgets;
+    ScopeStatisticsDialog* m_statisticsDialog;
 };
 
 #endif // SCOPECONTROLLER_H
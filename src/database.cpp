@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2013-2018 Meltytech, LLC
+ * Copyright (c) 2013-2021 Meltytech, LLC
  *
  * This program is free software: you can redistribute it and/or modify
  * it under the terms of the GNU General Public License as published by
@@ -17,29 +17,69 @@
 
 #include "database.h"
 #include "models/playlistmodel.h"
+#include "models/audiopeakfile.h"
 #include "mainwindow.h"
 #include "settings.h"
 #include <QtSql>
 #include <QDir>
+#include <QThreadStorage>
 #include <Logger.h>
 
 struct DatabaseJob {
-    enum Type {
-        PutThumbnail,
-        GetThumbnail
-    } type;
-
-    QImage image;
     QString hash;
-    bool result {false};
-    bool completed {false};
+    QImage image;
 };
 
+// How long writes and access times are batched into one transaction.
+static const int kCommitIntervalMs = 1000;
+// How often old thumbnails are deleted while thumbnails are being added.
+static const int kEvictionIntervalMs = 60 * 1000;
+// The number of thumbnails to keep in the database.
+static const int kMaxThumbnails = 10000;
+// The size of the in-memory cache of decoded thumbnails in KiB.
+static const int kMemoryCacheSize = 64 * 1024;
+
 static QMutex g_mutex;
 static Database* instance = nullptr;
 static bool g_isShutdown = false;
 
-Database::Database(QObject *parent) : QObject(parent)
+static QString databaseFileName()
+{
+    return QDir(Settings.appDataLocation()).filePath("db.sqlite3");
+}
+
+// A read-only connection that belongs to one thread, which in WAL mode can
+// read while the worker is writing. It is removed when its thread finishes.
+class ReaderConnection
+{
+public:
+    ReaderConnection()
+        : m_name(QString("reader-%1").arg(quintptr(this)))
+    {
+        QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE", m_name);
+        db.setDatabaseName(databaseFileName());
+        db.setConnectOptions("QSQLITE_OPEN_READONLY;QSQLITE_BUSY_TIMEOUT=1000");
+        if (!db.open())
+            LOG_ERROR() << "database open failed for reading" << db.lastError();
+    }
+
+    ~ReaderConnection()
+    {
+        QSqlDatabase::database(m_name, false).close();
+        QSqlDatabase::removeDatabase(m_name);
+    }
+
+    QSqlDatabase database() const { return QSqlDatabase::database(m_name, false); }
+
+private:
+    QString m_name;
+};
+
+static QThreadStorage<ReaderConnection*> g_readers;
+
+Database::Database(QObject *parent)
+    : QObject(parent)
+    , m_cache(kMemoryCacheSize)
 {
     m_worker.moveToThread(&m_thread);
     connect(this, &Database::start, &m_worker, &Worker::run);
@@ -75,76 +115,89 @@ bool Worker::upgradeVersion1()
 
 void Worker::doJob(DatabaseJob * job)
 {
-    if (!m_commitTimer->isActive())
+    beginTransaction();
+
+    QByteArray ba;
+    QBuffer buffer(&ba);
+    buffer.open(QIODevice::WriteOnly);
+    job->image.save(&buffer, "PNG");
+
+    QSqlQuery query;
+    query.prepare("INSERT OR REPLACE INTO thumbnails VALUES (:hash, datetime('now'), :image);");
+    query.bindValue(":hash", job->hash);
+    query.bindValue(":image", ba);
+    bool result = query.exec();
+    if (!result)
+        LOG_ERROR() << query.lastError();
+    emit failing(!result);
+    m_isEvictionNeeded = true;
+}
+
+void Worker::beginTransaction()
+{
+    if (!m_transactionTime.isValid()) {
         QSqlDatabase::database().transaction();
-    m_commitTimer->start();
-
-    if (job->type == DatabaseJob::PutThumbnail) {
-        QByteArray ba;
-        QBuffer buffer(&ba);
-        buffer.open(QIODevice::WriteOnly);
-        job->image.save(&buffer, "PNG");
-
-        QSqlQuery query;
-        query.prepare("DELETE FROM thumbnails WHERE hash = :hash;");
-        query.bindValue(":hash", job->hash);
-        query.exec();
-        query.prepare("INSERT INTO thumbnails VALUES (:hash, datetime('now'), :image);");
-        query.bindValue(":hash", job->hash);
-        query.bindValue(":image", ba);
-        job->result = query.exec();
-        if (!job->result)
-            LOG_ERROR() << query.lastError();
-        emit failing(!job->result);
-    } else if (job->type == DatabaseJob::GetThumbnail) {
-        QImage result;
-        QSqlQuery query;
-        query.prepare("SELECT image FROM thumbnails WHERE hash = :hash;");
-        query.bindValue(":hash", job->hash);
-        if (query.exec() && query.first()) {
-            result.loadFromData(query.value(0).toByteArray(), "PNG");
-            QSqlQuery update;
-            update.prepare("UPDATE thumbnails SET accessed = datetime('now') WHERE hash = :hash ;");
-            update.bindValue(":hash", job->hash);
-            auto isFailing = !update.exec();
-            emit failing(isFailing);
-            if (isFailing)
-                LOG_ERROR() << update.lastError();
-        }
-        job->image = result;
+        m_transactionTime.start();
     }
-    deleteOldThumbnails();
-    job->completed = true;
 }
 
 void Worker::commitTransaction()
 {
-    QSqlDatabase::database().commit();
+    if (m_transactionTime.isValid()) {
+        QSqlDatabase::database().commit();
+        m_transactionTime.invalidate();
+    }
+}
+
+void Worker::updateAccessed()
+{
+    QSet<QString> accessed;
+    m_mutex.lock();
+    accessed.swap(m_accessed);
+    m_mutex.unlock();
+    if (accessed.isEmpty())
+        return;
+
+    beginTransaction();
+    QVariantList hashes;
+    hashes.reserve(accessed.size());
+    foreach (const QString& hash, accessed)
+        hashes << hash;
+    QSqlQuery update;
+    update.prepare("UPDATE thumbnails SET accessed = datetime('now') WHERE hash = ?;");
+    update.addBindValue(hashes);
+    auto isFailing = !update.execBatch();
+    emit failing(isFailing);
+    if (isFailing)
+        LOG_ERROR() << update.lastError();
 }
 
 bool Database::putThumbnail(const QString& hash, const QImage& image)
 {
     if (!m_isOpened) return false;
-    DatabaseJob job;
-    job.type = DatabaseJob::PutThumbnail;
-    job.hash = hash;
-    job.image = image;
-    m_worker.submitAndWaitForJob(&job);
-    return job.result;
+    cacheThumbnail(hash, image);
+    // The worker encodes and stores it later, and the cache serves it until then.
+    DatabaseJob* job = new DatabaseJob;
+    job->hash = hash;
+    job->image = image;
+    m_worker.submitJob(job);
+    return true;
 }
 
-void Worker::submitAndWaitForJob(DatabaseJob * job)
+void Worker::submitJob(DatabaseJob * job)
 {
-    job->completed = false;
     QMutexLocker locker(&m_mutex);
     m_jobs.append(job);
     if (m_jobs.size() == 1) {
         //worker was idle until now
         m_waitForNewJob.wakeAll();
     }
-    while (!job->completed) {
-        m_waitForFinished.wait(&m_mutex);
-    }
+}
+
+void Worker::touch(const QString& hash)
+{
+    QMutexLocker locker(&m_mutex);
+    m_accessed.insert(hash);
 }
 
 void Worker::quit()
@@ -157,11 +210,32 @@ void Worker::quit()
 QImage Database::getThumbnail(const QString &hash)
 {
     if (!m_isOpened) return QImage();
-    DatabaseJob job;
-    job.type = DatabaseJob::GetThumbnail;
-    job.hash = hash;
-    m_worker.submitAndWaitForJob(&job);
-    return job.image;
+    m_cacheMutex.lock();
+    QImage* cached = m_cache.object(hash);
+    QImage result = cached? *cached : QImage();
+    m_cacheMutex.unlock();
+    if (cached) {
+        m_worker.touch(hash);
+        return result;
+    }
+
+    if (!g_readers.hasLocalData())
+        g_readers.setLocalData(new ReaderConnection);
+    QSqlQuery query(g_readers.localData()->database());
+    query.prepare("SELECT image FROM thumbnails WHERE hash = :hash;");
+    query.bindValue(":hash", hash);
+    if (query.exec() && query.first()) {
+        result.loadFromData(query.value(0).toByteArray(), "PNG");
+        m_worker.touch(hash);
+        cacheThumbnail(hash, result);
+    }
+    return result;
+}
+
+void Database::cacheThumbnail(const QString& hash, const QImage& image)
+{
+    QMutexLocker locker(&m_cacheMutex);
+    m_cache.insert(hash, new QImage(image), qMax(1, image.bytesPerLine() * image.height() / 1024));
 }
 
 bool Database::isShutdown() const
@@ -185,9 +259,11 @@ void Database::shutdown()
 void Worker::deleteOldThumbnails()
 {
     QSqlQuery query;
-    // OFFSET is the number of thumbnails to cache.
-    if (!query.exec("DELETE FROM thumbnails WHERE hash IN (SELECT hash FROM thumbnails ORDER BY accessed DESC LIMIT -1 OFFSET 10000);"))
+    if (!query.exec(QString("DELETE FROM thumbnails WHERE hash IN (SELECT hash FROM thumbnails ORDER BY accessed DESC LIMIT -1 OFFSET %1);")
+                    .arg(kMaxThumbnails)))
         LOG_ERROR() << query.lastError();
+    m_isEvictionNeeded = false;
+    m_evictionTime.start();
 }
 
 void Worker::run()
@@ -197,23 +273,21 @@ void Worker::run()
         dir.mkpath(dir.path());
 
     QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE");
-    db.setDatabaseName(dir.filePath("db.sqlite3"));
+    db.setDatabaseName(databaseFileName());
     auto result = db.open();
-    emit opened(result);
     if (!result) {
+        emit opened(result);
         LOG_ERROR() << "database open failed";
         return;
     }
 
-    m_commitTimer = new QTimer();
-    m_commitTimer->setSingleShot(true);
-    m_commitTimer->setInterval(5000);
-    connect(m_commitTimer, SIGNAL(timeout()),
-            this, SLOT(commitTransaction()));
+    // Let the reader connections read while this one writes.
+    QSqlQuery query;
+    if (!query.exec("PRAGMA journal_mode=WAL;") || !query.exec("PRAGMA synchronous=NORMAL;"))
+        LOG_WARNING() << "Failed to enable write-ahead logging" << query.lastError();
 
     // Initialize version table, if needed.
     int version = 0;
-    QSqlQuery query;
     if (query.exec("CREATE TABLE version (version INTEGER);")) {
         if (!query.exec("INSERT INTO version VALUES (0);"))
             LOG_ERROR() << "Failed to create version table.";
@@ -226,27 +300,36 @@ void Worker::run()
     if (version < 1 && upgradeVersion1())
         version = 1;
     LOG_DEBUG() << "Database version is" << version;
+    emit opened(result);
 
-    while (!m_quit) {
-        DatabaseJob * newJob = nullptr;
+    deleteOldThumbnails();
+    // Audio peak files are not in the database but are cached alongside it.
+    AudioPeakFile::deleteOldFiles();
+    bool isQuitting = false;
+    while (!isQuitting) {
+        QList<DatabaseJob*> jobs;
         m_mutex.lock();
-        if (m_jobs.isEmpty())
-            m_waitForNewJob.wait(&m_mutex, 1000);
-        else
-            newJob = m_jobs.takeFirst();
+        if (m_jobs.isEmpty() && !m_quit)
+            m_waitForNewJob.wait(&m_mutex, kCommitIntervalMs);
+        jobs.swap(m_jobs);
+        // Finish the jobs that are already submitted before quitting.
+        isQuitting = m_quit;
         m_mutex.unlock();
-        if (newJob) {
-            doJob(newJob);
-            m_waitForFinished.wakeAll();
+        foreach (DatabaseJob* job, jobs) {
+            doJob(job);
+            delete job;
+        }
+        if (jobs.isEmpty() || isQuitting
+                || (m_transactionTime.isValid() && m_transactionTime.elapsed() > kCommitIntervalMs)) {
+            updateAccessed();
+            if (m_isEvictionNeeded && m_evictionTime.elapsed() > kEvictionIntervalMs)
+                deleteOldThumbnails();
+            commitTransaction();
         }
     }
-    if (m_commitTimer->isActive())
-        commitTransaction();
-    delete m_commitTimer;
 
     QString connection = QSqlDatabase::database().connectionName();
     QSqlDatabase::database().close();
 //    QSqlDatabase::removeDatabase(connection);
     LOG_DEBUG() << "database closed";
 }
-
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2013-2018 Meltytech, LLC
+ * Copyright (c) 2013-2021 Meltytech, LLC
  *
  * This program is free software: you can redistribute it and/or modify
  * it under the terms of the GNU General Public License as published by
@@ -22,16 +22,19 @@
 #include <QImage>
 #include <QMutex>
 #include <QWaitCondition>
+#include <QElapsedTimer>
+#include <QCache>
+#include <QSet>
 
 struct DatabaseJob;
-class QTimer;
 
 class Worker : public QObject
 {
     Q_OBJECT
 
 public:
-    void submitAndWaitForJob(DatabaseJob * job);
+    void submitJob(DatabaseJob * job);
+    void touch(const QString& hash);
     void quit();
 
 signals:
@@ -41,19 +44,21 @@ signals:
 public slots:
     void run();
 
-private slots:
-    void commitTransaction();
-
 private:
     bool upgradeVersion1();
     void doJob(DatabaseJob * job);
+    void beginTransaction();
+    void commitTransaction();
+    void updateAccessed();
     void deleteOldThumbnails();
 
     QList<DatabaseJob*> m_jobs;
+    QSet<QString> m_accessed;
     QMutex m_mutex;
-    QWaitCondition m_waitForFinished;
     QWaitCondition m_waitForNewJob;
-    QTimer* m_commitTimer {nullptr};
+    QElapsedTimer m_transactionTime;
+    QElapsedTimer m_evictionTime;
+    bool m_isEvictionNeeded {true};
     bool m_quit {false};
 };
 
@@ -79,8 +84,12 @@ private slots:
     void onFailing(bool failing) { m_isFailing = failing; }
 
 private:
+    void cacheThumbnail(const QString& hash, const QImage& image);
+
     Worker m_worker;
     QThread m_thread;
+    QCache<QString, QImage> m_cache;
+    QMutex m_cacheMutex;
     bool m_isFailing {false};
     bool m_isOpened {false};
 };
@@ -0,0 +1,116 @@
+/*
+ * Copyright (c) 2021 Meltytech, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "scopestatisticsdialog.h"
+#include "widgets/scopes/scopewidget.h"
+
+#include <QDialogButtonBox>
+#include <QHeaderView>
+#include <QPushButton>
+#include <QTableWidget>
+#include <QVBoxLayout>
+
+enum {
+    ColumnReceived = 0,
+    ColumnDropped,
+    ColumnRefreshes,
+    ColumnRate,
+    ColumnMean,
+    ColumnMax,
+    ColumnDurationBins
+};
+
+ScopeStatisticsDialog::ScopeStatisticsDialog(const QList<ScopeWidget*>& scopes, QWidget* parent)
+    : QDialog(parent)
+    , m_scopes(scopes)
+    , m_table(new QTableWidget(scopes.size(), ColumnDurationBins + ScopeStatistics::DurationBinCount))
+{
+    setWindowTitle(tr("Scope Statistics"));
+
+    QStringList labels;
+    labels << tr("Frames") << tr("Dropped") << tr("Refreshes") << tr("Rate (Hz)")
+           << tr("Mean (ms)") << tr("Max (ms)");
+    int limit = 0;
+    for (int i = 0; i < ScopeStatistics::DurationBinCount; i++) {
+        if (ScopeStatistics::durationBinLimit(i))
+            limit = ScopeStatistics::durationBinLimit(i);
+        labels << (ScopeStatistics::durationBinLimit(i)? tr("< %1 ms") : tr("%1+ ms")).arg(limit);
+    }
+    m_table->setHorizontalHeaderLabels(labels);
+    labels.clear();
+    foreach (ScopeWidget* scope, m_scopes)
+        labels << scope->getTitle();
+    m_table->setVerticalHeaderLabels(labels);
+    m_table->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    m_table->setSelectionMode(QAbstractItemView::NoSelection);
+    m_table->horizontalHeader()->setSectionResizeMode(QHeaderView::ResizeToContents);
+    for (int row = 0; row < m_table->rowCount(); row++) {
+        for (int column = 0; column < m_table->columnCount(); column++) {
+            QTableWidgetItem* item = new QTableWidgetItem;
+            item->setTextAlignment(Qt::AlignRight | Qt::AlignVCenter);
+            m_table->setItem(row, column, item);
+        }
+    }
+
+    QVBoxLayout* layout = new QVBoxLayout(this);
+    layout->addWidget(m_table);
+    QDialogButtonBox* buttonBox = new QDialogButtonBox(QDialogButtonBox::Close);
+    QPushButton* resetButton = buttonBox->addButton(tr("Reset"), QDialogButtonBox::ResetRole);
+    connect(resetButton, SIGNAL(clicked()), this, SLOT(resetStatistics()));
+    connect(buttonBox, SIGNAL(rejected()), this, SLOT(reject()));
+    layout->addWidget(buttonBox);
+    resize(900, 320);
+
+    connect(&m_timer, SIGNAL(timeout()), this, SLOT(updateTable()));
+    m_timer.setInterval(1000);
+}
+
+void ScopeStatisticsDialog::showEvent(QShowEvent* event)
+{
+    updateTable();
+    m_timer.start();
+    QDialog::showEvent(event);
+}
+
+void ScopeStatisticsDialog::hideEvent(QHideEvent* event)
+{
+    m_timer.stop();
+    QDialog::hideEvent(event);
+}
+
+void ScopeStatisticsDialog::updateTable()
+{
+    for (int row = 0; row < m_scopes.size(); row++) {
+        ScopeStatistics statistics = m_scopes[row]->statistics();
+        double meanMs = statistics.refreshCount? statistics.totalRefreshNsecs / 1000000.0 / statistics.refreshCount : 0.0;
+        m_table->item(row, ColumnReceived)->setText(QString::number(statistics.framesReceived));
+        m_table->item(row, ColumnDropped)->setText(QString::number(statistics.framesDropped));
+        m_table->item(row, ColumnRefreshes)->setText(QString::number(statistics.refreshCount));
+        m_table->item(row, ColumnRate)->setText(QString::number(statistics.refreshRate, 'f', 1));
+        m_table->item(row, ColumnMean)->setText(QString::number(meanMs, 'f', 2));
+        m_table->item(row, ColumnMax)->setText(QString::number(statistics.maxRefreshNsecs / 1000000.0, 'f', 2));
+        for (int i = 0; i < ScopeStatistics::DurationBinCount; i++)
+            m_table->item(row, ColumnDurationBins + i)->setText(QString::number(statistics.durationBins[i]));
+    }
+}
+
+void ScopeStatisticsDialog::resetStatistics()
+{
+    foreach (ScopeWidget* scope, m_scopes)
+        scope->resetStatistics();
+    updateTable();
+}
@@ -0,0 +1,54 @@
+/*
+ * Copyright (c) 2021 Meltytech, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SCOPESTATISTICSDIALOG_H
+#define SCOPESTATISTICSDIALOG_H
+
+#include <QDialog>
+#include <QList>
+#include <QTimer>
+
+class QTableWidget;
+class ScopeWidget;
+
+/*!
+  \class ScopeStatisticsDialog
+  \brief Shows the ScopeStatistics of every scope and updates them every second.
+*/
+
+class ScopeStatisticsDialog : public QDialog
+{
+    Q_OBJECT
+
+public:
+    explicit ScopeStatisticsDialog(const QList<ScopeWidget*>& scopes, QWidget* parent = 0);
+
+protected:
+    void showEvent(QShowEvent* event) Q_DECL_OVERRIDE;
+    void hideEvent(QHideEvent* event) Q_DECL_OVERRIDE;
+
+private slots:
+    void updateTable();
+    void resetStatistics();
+
+private:
+    QList<ScopeWidget*> m_scopes;
+    QTableWidget* m_table;
+    QTimer m_timer;
+};
+
+#endif // SCOPESTATISTICSDIALOG_H
@@ -25,6 +25,7 @@
 #include "settings.h"
 #include "qmltypes/qmlapplication.h"
 #include "jobs/encodejob.h"
+#include "jobs/chunkedencodejob.h"
 #include "shotcut_mlt_properties.h"
 #include "util.h"
 #include "dialogs/listselectiondialog.h"
@@ -73,12 +74,17 @@ EncodeDock::EncodeDock(QWidget *parent) :
     // On 32-bit process, limit multi-threading to mitigate running out of memory.
     ui->parallelCheckbox->setChecked(false);
     ui->parallelCheckbox->setHidden(true);
+    ui->chunkedCheckbox->setChecked(false);
+    ui->chunkedCheckbox->setHidden(true);
 #else
     ui->parallelCheckbox->setChecked(Settings.encodeParallelProcessing());
+    ui->chunkedCheckbox->setChecked(Settings.encodeChunked());
     ui->videoCodecThreadsSpinner->setMaximum(QThread::idealThreadCount());
 #endif
-    if (QThread::idealThreadCount() < 3)
+    if (QThread::idealThreadCount() < 3) {
         ui->parallelCheckbox->setHidden(true);
+        ui->chunkedCheckbox->setHidden(true);
+    }
     toggleViewAction()->setIcon(windowIcon());
 
     connect(ui->videoBitrateCombo, SIGNAL(currentIndexChanged(int)), this, SLOT(on_videoBufferDurationChanged()));
@@ -883,7 +889,8 @@ void EncodeDock::collectProperties(QDomElement& node, int realtime)
     delete p;
 }
 
-MeltJob* EncodeDock::createMeltJob(Mlt::Producer* service, const QString& target, int realtime, int pass)
+MeltJob* EncodeDock::createMeltJob(Mlt::Producer* service, const QString& target, int realtime, int pass,
+                                   int chunkCount)
 {
     QString caption = tr("Export File");
     if (Util::warnIfNotWritable(target, this, caption))
@@ -985,7 +992,11 @@ MeltJob* EncodeDock::createMeltJob(Mlt::Producer* service, const QString& target
 
     int frameRateNum = consumerNode.hasAttribute("frame_rate_num")? consumerNode.attribute("frame_rate_num").toInt() : MLT.profile().frame_rate_num();
     int frameRateDen = consumerNode.hasAttribute("frame_rate_den")? consumerNode.attribute("frame_rate_den").toInt() : MLT.profile().frame_rate_den();
-    MeltJob* job = new EncodeJob(QDir::toNativeSeparators(target), dom.toString(2), frameRateNum, frameRateDen);
+    MeltJob* job;
+    if (chunkCount > 1)
+        job = new ChunkedEncodeJob(QDir::toNativeSeparators(target), dom.toString(2), frameRateNum, frameRateDen, chunkCount);
+    else
+        job = new EncodeJob(QDir::toNativeSeparators(target), dom.toString(2), frameRateNum, frameRateDen);
     job->setUseMultiConsumer(
             ui->widthSpinner->value() != MLT.profile().width() ||
             ui->heightSpinner->value() != MLT.profile().height() ||
@@ -1132,26 +1143,46 @@ void EncodeDock::enqueueMelt(const QStringList& targets, int realtime)
                 if (job) {
                     JOBS.add(job);
                     if (pass) {
-                        job = createMeltJob(producer.data(), targets[i], realtime, 2);
-                        if (job)
-                            JOBS.add(job);
+                        MeltJob* secondJob = createMeltJob(producer.data(), targets[i], realtime, 2);
+                        if (secondJob) {
+                            // The second pass reads the statistics of the first.
+                            secondJob->setDependency(job);
+                            JOBS.add(secondJob);
+                        }
                     }
                 }
             }
         }
     } else {
-        MeltJob* job = createMeltJob(service, targets[0], realtime, pass);
+        MeltJob* job = createMeltJob(service, targets[0], realtime, pass, pass? 1 : chunkCount());
         if (job) {
             JOBS.add(job);
             if (pass) {
-                job = createMeltJob(service, targets[0], realtime, 2);
-                if (job)
-                    JOBS.add(job);
+                MeltJob* secondJob = createMeltJob(service, targets[0], realtime, 2);
+                if (secondJob) {
+                    secondJob->setDependency(job);
+                    JOBS.add(secondJob);
+                }
             }
         }
     }
 }
 
+// Returns how many segments to export at the same time, or 1 to export in one piece.
+int EncodeDock::chunkCount() const
+{
+    const QString& codec = ui->videoCodecCombo->currentText();
+    // Hardware encoders have few sessions, and image sequences are numbered by frame.
+    if (!ui->chunkedCheckbox->isChecked() || ui->chunkedCheckbox->isHidden()
+            || ui->disableVideoCheckbox->isChecked()
+            || codec.contains("nvenc") || codec.endsWith("_amf") || codec.endsWith("_qsv")
+            || codec.endsWith("_videotoolbox") || codec.endsWith("_vaapi")
+            || ui->formatCombo->currentText() == "image2")
+        return 1;
+    // Each segment has an encoder with a few threads.
+    return qBound(2, QThread::idealThreadCount() / 4, 8);
+}
+
 void EncodeDock::encode(const QString& target)
 {
     bool isMulti = true;
@@ -2016,6 +2047,11 @@ void EncodeDock::on_parallelCheckbox_clicked(bool checked)
     Settings.setEncodeParallelProcessing(checked);
 }
 
+void EncodeDock::on_chunkedCheckbox_clicked(bool checked)
+{
+    Settings.setEncodeChunked(checked);
+}
+
 bool EncodeDock::detectHardwareEncoders()
 {
     MAIN.showStatusMessage(tr("Detecting hardware encoders..."));
@@ -125,6 +125,8 @@ private slots:
 
     void on_parallelCheckbox_clicked(bool checked);
 
+    void on_chunkedCheckbox_clicked(bool checked);
+
 private:
     enum {
         RateControlAverage = 0,
@@ -150,10 +152,12 @@ private:
     void loadPresets();
     Mlt::Properties* collectProperties(int realtime);
     void collectProperties(QDomElement& node, int realtime);
-    MeltJob* createMeltJob(Mlt::Producer* service, const QString& target, int realtime, int pass = 0);
+    MeltJob* createMeltJob(Mlt::Producer* service, const QString& target, int realtime, int pass = 0,
+                           int chunkCount = 1);
     void runMelt(const QString& target, int realtime = -1);
     void enqueueAnalysis();
     void enqueueMelt(const QStringList& targets, int realtime);
+    int chunkCount() const;
     void encode(const QString& target);
     void resetOptions();
     Mlt::Producer* fromProducer() const;
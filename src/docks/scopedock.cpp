@@ -21,14 +21,25 @@
 #include "controllers/scopecontroller.h"
 #include "mltcontroller.h"
 
+#include "settings.h"
+
 #include <Logger.h>
 #include <QtWidgets/QScrollArea>
 #include <QAction>
+#include <QActionGroup>
+#include <QHBoxLayout>
+#include <QLabel>
+#include <QMenu>
+#include <QToolButton>
+#include <QVBoxLayout>
 
-ScopeDock::ScopeDock(ScopeController* scopeController, ScopeWidget* scopeWidget) :
+ScopeDock::ScopeDock(ScopeController* scopeController, ScopeWidget* scopeWidget, VideoScopeAnalyzer* analyzer) :
     QDockWidget()
   , m_scopeController(scopeController)
   , m_scopeWidget(scopeWidget)
+  , m_analyzer(analyzer)
+  , m_statusLabel(nullptr)
+  , m_refreshRate(0.0)
 {
     LOG_DEBUG() << "begin";
     setObjectName(m_scopeWidget->objectName() + "Dock");
@@ -36,7 +47,18 @@ ScopeDock::ScopeDock(ScopeController* scopeController, ScopeWidget* scopeWidget)
     scrollArea->setFrameShape(QFrame::NoFrame);
     scrollArea->setWidgetResizable(true);
     scrollArea->setWidget(m_scopeWidget);
-    QDockWidget::setWidget(scrollArea);
+    if (m_analyzer) {
+        QWidget* widget = new QWidget();
+        QVBoxLayout* vlayout = new QVBoxLayout(widget);
+        vlayout->setContentsMargins(0, 0, 0, 0);
+        vlayout->setSpacing(0);
+        vlayout->addWidget(scrollArea, 1);
+        vlayout->addWidget(createStatusBar());
+        QDockWidget::setWidget(widget);
+        connect(m_scopeWidget, SIGNAL(refreshRateChanged(qreal)), this, SLOT(onRefreshRateChanged(qreal)));
+    } else {
+        QDockWidget::setWidget(scrollArea);
+    }
     QDockWidget::setWindowTitle(m_scopeWidget->getTitle());
 
     connect(toggleViewAction(), SIGNAL(toggled(bool)), this, SLOT(onActionToggled(bool)));
@@ -60,5 +82,94 @@ void ScopeDock::onActionToggled(bool checked)
         MLT.refreshConsumer();
     } else {
         disconnect(m_scopeController, SIGNAL(newFrame(const SharedFrame&)), m_scopeWidget, SLOT(onNewFrame(const SharedFrame&)));
+        LOG_INFO() << m_scopeWidget->objectName() << m_scopeWidget->statistics().toString();
+    }
+}
+
+QWidget* ScopeDock::createStatusBar()
+{
+    QWidget* statusBar = new QWidget();
+    QHBoxLayout* hlayout = new QHBoxLayout(statusBar);
+    hlayout->setContentsMargins(4, 2, 4, 2);
+
+    // Create quality menu
+    QMenu* qualityMenu = new QMenu(this);
+    QActionGroup* qualityGroup = new QActionGroup(this);
+    QAction* action;
+    action = qualityMenu->addAction(tr("Full Quality"));
+    action->setData(VideoScopeAnalyzer::FullQuality);
+    qualityGroup->addAction(action);
+    action = qualityMenu->addAction(tr("Half Quality"));
+    action->setData(VideoScopeAnalyzer::HalfQuality);
+    qualityGroup->addAction(action);
+    action = qualityMenu->addAction(tr("Quarter Quality"));
+    action->setData(VideoScopeAnalyzer::QuarterQuality);
+    qualityGroup->addAction(action);
+    action = qualityMenu->addAction(tr("Adaptive Quality"));
+    action->setData(VideoScopeAnalyzer::AdaptiveQuality);
+    qualityGroup->addAction(action);
+    foreach (QAction* qualityAction, qualityGroup->actions()) {
+        qualityAction->setCheckable(true);
+    }
+    connect(qualityGroup, SIGNAL(triggered(QAction*)), this, SLOT(onQualityTriggered(QAction*)));
+    // The quality is shared by all video scopes, so it may have been changed in another dock.
+    connect(qualityMenu, &QMenu::aboutToShow, this, [=]() {
+        foreach (QAction* qualityAction, qualityGroup->actions()) {
+            qualityAction->setChecked(qualityAction->data().toInt() == m_analyzer->quality());
+        }
+    });
+
+    QToolButton* configButton = new QToolButton(statusBar);
+    configButton->setToolTip(tr("Scope Quality"));
+    configButton->setIcon(QIcon::fromTheme("show-menu", QIcon(":/icons/oxygen/32x32/actions/show-menu.png")));
+    configButton->setAutoRaise(true);
+    configButton->setPopupMode(QToolButton::InstantPopup);
+    configButton->setMenu(qualityMenu);
+    hlayout->addWidget(configButton);
+
+    m_statusLabel = new QLabel(statusBar);
+    m_statusLabel->setToolTip(tr("Analysis quality and refresh rate of the scope"));
+    hlayout->addWidget(m_statusLabel);
+    hlayout->addStretch();
+    updateStatus();
+    return statusBar;
+}
+
+void ScopeDock::onQualityTriggered(QAction* action)
+{
+    int quality = action->data().toInt();
+    m_analyzer->setQuality(VideoScopeAnalyzer::Quality(quality));
+    Settings.setVideoScopeQuality(quality);
+    updateStatus();
+}
+
+void ScopeDock::onRefreshRateChanged(qreal fps)
+{
+    m_refreshRate = fps;
+    updateStatus();
+}
+
+void ScopeDock::updateStatus()
+{
+    QString quality;
+    switch (m_analyzer->sampleStep()) {
+    case 1:
+        quality = tr("Full");
+        break;
+    case 2:
+        quality = tr("Half");
+        break;
+    default:
+        quality = tr("Quarter");
+        break;
+    }
+    if (m_analyzer->quality() == VideoScopeAnalyzer::AdaptiveQuality) {
+        quality = tr("Adaptive (%1)").arg(quality);
+    }
+    if (m_refreshRate > 0.0) {
+        m_statusLabel->setText(tr("%1, %2 fps").arg(quality).arg(m_refreshRate, 0, 'f', 1));
+    } else {
+        m_statusLabel->setText(quality);
     }
 }
+
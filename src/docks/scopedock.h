@@ -24,13 +24,22 @@
 #include <QObject>
 
 class ScopeController;
+class VideoScopeAnalyzer;
+class QAction;
+class QLabel;
 
 class ScopeDock Q_DECL_FINAL : public QDockWidget
 {
    Q_OBJECT
 
 public:
-   explicit ScopeDock(ScopeController* scopeController, ScopeWidget* scopeWidget);
+   /*!
+     Constructs a dock for \a scopeWidget. If \a analyzer is given, a bar
+     below the scope lets the user choose the analysis quality and shows it
+     along with the refresh rate that the scope achieves.
+   */
+   explicit ScopeDock(ScopeController* scopeController, ScopeWidget* scopeWidget,
+                      VideoScopeAnalyzer* analyzer = nullptr);
 
 protected:
    void resizeEvent(QResizeEvent*) Q_DECL_OVERRIDE;
@@ -38,11 +47,18 @@ protected:
 private:
    ScopeController* m_scopeController;
    ScopeWidget* m_scopeWidget;
+   VideoScopeAnalyzer* m_analyzer;
+   QLabel* m_statusLabel;
+   qreal m_refreshRate;
 
    void setWidget(QWidget * widget); // Private to disallow use
+   QWidget* createStatusBar();
 
 private slots:
    void onActionToggled(bool checked);
+   void onQualityTriggered(QAction* action);
+   void onRefreshRateChanged(qreal fps);
+   void updateStatus();
 };
 
 #endif // SCOPEDOCK_H
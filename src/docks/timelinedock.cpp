@@ -20,6 +20,7 @@
 #include "models/audiolevelstask.h"
 #include "models/multitrackmodel.h"
 #include "qmltypes/thumbnailprovider.h"
+#include "qmltypes/filmstripprovider.h"
 #include "mainwindow.h"
 #include "commands/timelinecommands.h"
 #include "qmltypes/qmlutilities.h"
@@ -61,6 +62,7 @@ TimelineDock::TimelineDock(QWidget *parent) :
     importPath.cd("modules");
     m_quickView.engine()->addImportPath(importPath.path());
     m_quickView.engine()->addImageProvider(QString("thumbnail"), new ThumbnailProvider);
+    m_quickView.engine()->addImageProvider(QString("filmstrip"), new FilmstripProvider);
     QmlUtilities::setCommonProperties(m_quickView.rootContext());
     m_quickView.rootContext()->setContextProperty("view", new QmlView(&m_quickView));
     m_quickView.rootContext()->setContextProperty("timeline", this);
@@ -1034,6 +1036,8 @@ bool TimelineDock::trimClipIn(int trackIndex, int clipIndex, int oldClipIndex, i
             } else {
                 m_undoHelper->setHints(UndoHelper::RestoreTracks);
             }
+            if (!ripple || !Settings.timelineRippleAllTracks())
+                m_undoHelper->limitToTracks({trackIndex});
             m_undoHelper->recordBeforeState();
         }
         clipIndex = m_model.trimClipIn(trackIndex, clipIndex, delta, ripple, Settings.timelineRippleAllTracks());
@@ -1082,6 +1086,8 @@ bool TimelineDock::trimClipOut(int trackIndex, int clipIndex, int delta, bool ri
         if (!m_undoHelper) {
             m_undoHelper.reset(new UndoHelper(m_model));
             if (ripple) m_undoHelper->setHints(UndoHelper::SkipXML);
+            if (!ripple || !Settings.timelineRippleAllTracks())
+                m_undoHelper->limitToTracks({trackIndex});
             m_undoHelper->recordBeforeState();
         }
         m_model.trimClipOut(trackIndex, clipIndex, delta, ripple, Settings.timelineRippleAllTracks());
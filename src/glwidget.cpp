@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2011-2020 Meltytech, LLC
+ * Copyright (c) 2011-2021 Meltytech, LLC
  *
  * GL shader based on BSD licensed code from Peter Bengtsson:
  * http://www.fourcc.org/source/YUV420P-OpenGL-GLSLang.c
@@ -21,6 +21,7 @@
 #include <QtWidgets>
 #include <QOpenGLFunctions_1_1>
 #include <QOpenGLFunctions_3_2_Core>
+#include <QOpenGLExtraFunctions>
 #include <QUrl>
 #include <QOffscreenSurface>
 #include <QtQml>
@@ -32,6 +33,7 @@
 #include "qmltypes/qmlutilities.h"
 #include "qmltypes/qmlfilter.h"
 #include "mainwindow.h"
+#include "shotcut_mlt_properties.h"
 
 #define USE_GL_SYNC // Use glFinish() if not defined.
 
@@ -96,6 +98,7 @@ GLWidget::GLWidget(QObject *parent)
     connect(quickWindow(), SIGNAL(sceneGraphInitialized()), SLOT(initializeGL()), Qt::DirectConnection);
     connect(quickWindow(), SIGNAL(sceneGraphInitialized()), SLOT(setBlankScene()), Qt::QueuedConnection);
     connect(quickWindow(), SIGNAL(beforeRendering()), SLOT(paintGL()), Qt::DirectConnection);
+    connect(quickWindow(), SIGNAL(sceneGraphInvalidated()), SLOT(cleanupGL()), Qt::DirectConnection);
     connect(&m_refreshTimer, SIGNAL(timeout()), SLOT(onRefreshTimeout()));
     connect(this, SIGNAL(rectChanged()), SIGNAL(zoomChanged()));
     LOG_DEBUG() << "end";
@@ -105,6 +108,13 @@ GLWidget::~GLWidget()
 {
     LOG_DEBUG() << "begin";
     stop();
+    // The scene graph is invalidated after this destructor, so clean up now.
+    disconnect(quickWindow(), SIGNAL(sceneGraphInvalidated()), this, SLOT(cleanupGL()));
+    QOpenGLContext* context = quickWindow()->openglContext();
+    if (context && m_offscreenSurface.isValid() && context->makeCurrent(&m_offscreenSurface)) {
+        cleanupGL();
+        context->doneCurrent();
+    }
     delete m_glslManager;
     delete m_threadStartEvent;
     delete m_threadStopEvent;
@@ -177,12 +187,11 @@ void GLWidget::initializeGL()
         m_shareContext->setShareContext(quickWindow()->openglContext());
         m_shareContext->create();
     }
-    m_frameRenderer = new FrameRenderer(quickWindow()->openglContext(), &m_offscreenSurface);
+    m_frameRenderer = new FrameRenderer(quickWindow()->openglContext(), &m_offscreenSurface, &m_audioTap);
     quickWindow()->openglContext()->makeCurrent(quickWindow());
 
     connect(m_frameRenderer, SIGNAL(frameDisplayed(const SharedFrame&)), SLOT(onFrameDisplayed(const SharedFrame&)), Qt::QueuedConnection);
     connect(m_frameRenderer, SIGNAL(frameDisplayed(const SharedFrame&)), SIGNAL(frameDisplayed(const SharedFrame&)), Qt::QueuedConnection);
-    connect(m_frameRenderer, SIGNAL(textureReady(GLuint,GLuint,GLuint)), SLOT(updateTexture(GLuint,GLuint,GLuint)), Qt::DirectConnection);
     connect(m_frameRenderer, SIGNAL(imageReady()), SIGNAL(imageReady()));
 
     m_initSem.release();
@@ -290,64 +299,205 @@ void GLWidget::createShader()
     m_texCoordLocation = m_shader->attributeLocation("texCoord");
 }
 
-static void uploadTextures(QOpenGLContext* context, SharedFrame& frame, GLuint texture[])
+TextureUploader::TextureUploader()
+    : m_isPixelBufferSupported(-1)
+    , m_pixelBufferIndex(0)
+    , m_statsFrameCount(0)
+    , m_statsUploadNsecs(0)
+    , m_statsMaxUploadNsecs(0)
+{
+    for (int i = 0; i < PixelBufferCount; ++i) {
+        m_pixelBuffer[i] = 0;
+        m_pixelBufferFence[i] = 0;
+    }
+}
+
+void TextureUploader::upload(QOpenGLContext* context, SharedFrame& frame, GLuint texture[])
 {
     int width = frame.get_image_width();
     int height = frame.get_image_height();
     const uint8_t* image = frame.get_image(mlt_image_yuv420p);
     QOpenGLFunctions* f = context->functions();
+    QElapsedTimer timer;
+    timer.start();
+
+    if (m_isPixelBufferSupported < 0) {
+        // Pixel buffers need mapping buffer ranges and fences, which are core in 3.2 and ES 3.0.
+        QPair<int, int> version = context->format().version();
+        m_isPixelBufferSupported = context->isOpenGLES()? version >= qMakePair(3, 0) : version >= qMakePair(3, 2);
+        LOG_INFO() << "OpenGL pixel buffer upload?" << bool(m_isPixelBufferSupported);
+    }
 
     // The planes of pixel data may not be a multiple of the default 4 bytes.
     f->glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
 
-    // Upload each plane of YUV to a texture.
-    if (texture[0])
-        f->glDeleteTextures(3, texture);
-    check_error(f);
-    f->glGenTextures(3, texture);
-    check_error(f);
+    // Keep the textures while the size does not change; only their contents are replaced.
+    if (m_textureSizes.value(texture[0]) != QSize(width, height))
+        allocateTextures(f, width, height, texture);
+
+    // Copy the image into a pixel buffer so that the texture uploads can proceed
+    // asynchronously. The offsets of the planes are then relative to the buffer.
+    int ySize = width * height;
+    int uvSize = width/2 * height/2;
+    const uint8_t* pixels = image;
+    if (m_isPixelBufferSupported)
+        pixels = fillPixelBuffer(context, image, ySize + 2 * uvSize);
 
+    // Upload each plane of YUV to a texture.
     f->glBindTexture  (GL_TEXTURE_2D, texture[0]);
     check_error(f);
-    f->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    check_error(f);
-    f->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    check_error(f);
-    f->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    check_error(f);
-    f->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-    check_error(f);
-    f->glTexImage2D   (GL_TEXTURE_2D, 0, GL_LUMINANCE, width, height, 0,
-                    GL_LUMINANCE, GL_UNSIGNED_BYTE, image);
+    f->glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height,
+                       GL_LUMINANCE, GL_UNSIGNED_BYTE, pixels);
     check_error(f);
 
     f->glBindTexture  (GL_TEXTURE_2D, texture[1]);
     check_error(f);
-    f->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    check_error(f);
-    f->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    f->glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width/2, height/2,
+                       GL_LUMINANCE, GL_UNSIGNED_BYTE, pixels + ySize);
     check_error(f);
-    f->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    check_error(f);
-    f->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+    f->glBindTexture  (GL_TEXTURE_2D, texture[2]);
     check_error(f);
-    f->glTexImage2D   (GL_TEXTURE_2D, 0, GL_LUMINANCE, width/2, height/2, 0,
-                    GL_LUMINANCE, GL_UNSIGNED_BYTE, image + width * height);
+    f->glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width/2, height/2,
+                       GL_LUMINANCE, GL_UNSIGNED_BYTE, pixels + ySize + uvSize);
     check_error(f);
 
-    f->glBindTexture  (GL_TEXTURE_2D, texture[2]);
+    if (m_isPixelBufferSupported) {
+        QOpenGLExtraFunctions* ef = context->extraFunctions();
+        ef->glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        // The buffer may be refilled once the uploads from it are complete.
+        m_pixelBufferFence[m_pixelBufferIndex] = ef->glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        check_error(ef);
+        m_pixelBufferIndex = (m_pixelBufferIndex + 1) % PixelBufferCount;
+    }
+    updateStats(timer.nsecsElapsed());
+}
+
+void TextureUploader::allocateTextures(QOpenGLFunctions* f, int width, int height, GLuint texture[])
+{
+    if (texture[0]) {
+        m_textureSizes.remove(texture[0]);
+        f->glDeleteTextures(3, texture);
+    }
     check_error(f);
-    f->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    f->glGenTextures(3, texture);
     check_error(f);
-    f->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+    for (int i = 0; i < 3; ++i) {
+        int planeWidth = i? width/2 : width;
+        int planeHeight = i? height/2 : height;
+        f->glBindTexture  (GL_TEXTURE_2D, texture[i]);
+        check_error(f);
+        f->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        check_error(f);
+        f->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        check_error(f);
+        f->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        check_error(f);
+        f->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        check_error(f);
+        f->glTexImage2D   (GL_TEXTURE_2D, 0, GL_LUMINANCE, planeWidth, planeHeight, 0,
+                           GL_LUMINANCE, GL_UNSIGNED_BYTE, 0);
+        check_error(f);
+    }
+    m_textureSizes.insert(texture[0], QSize(width, height));
+}
+
+const uint8_t* TextureUploader::fillPixelBuffer(QOpenGLContext* context, const uint8_t* image, int size)
+{
+    QOpenGLExtraFunctions* f = context->extraFunctions();
+    int i = m_pixelBufferIndex;
+
+    if (!m_pixelBuffer[i]) {
+        f->glGenBuffers(1, &m_pixelBuffer[i]);
+        check_error(f);
+    }
+    // Wait only for the uploads from this buffer, which were issued two frames ago.
+    if (m_pixelBufferFence[i]) {
+        f->glClientWaitSync(m_pixelBufferFence[i], GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+        f->glDeleteSync(m_pixelBufferFence[i]);
+        m_pixelBufferFence[i] = 0;
+    }
+    f->glBindBuffer(GL_PIXEL_UNPACK_BUFFER, m_pixelBuffer[i]);
     check_error(f);
-    f->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    // Orphan the previous storage, which lets the driver avoid a stall.
+    f->glBufferData(GL_PIXEL_UNPACK_BUFFER, size, 0, GL_STREAM_DRAW);
     check_error(f);
-    f->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    void* data = f->glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size,
+                                     GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
     check_error(f);
-    f->glTexImage2D   (GL_TEXTURE_2D, 0, GL_LUMINANCE, width/2, height/2, 0,
-                    GL_LUMINANCE, GL_UNSIGNED_BYTE, image + width * height + width/2 * height/2);
+    if (data) {
+        memcpy(data, image, size);
+        f->glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+        check_error(f);
+        return 0;
+    }
+    // Mapping failed, so upload from client memory.
+    f->glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    return image;
+}
+
+GLsync TextureUploader::createFence(QOpenGLContext* context)
+{
+    if (m_isPixelBufferSupported <= 0)
+        return 0;
+    QOpenGLExtraFunctions* f = context->extraFunctions();
+    GLsync fence = f->glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
     check_error(f);
+    // Flush so that another context waiting for the fence does not wait forever.
+    f->glFlush();
+    return fence;
+}
+
+void TextureUploader::cleanup(QOpenGLContext* context)
+{
+    if (m_isPixelBufferSupported > 0) {
+        QOpenGLExtraFunctions* f = context->extraFunctions();
+        for (int i = 0; i < PixelBufferCount; ++i) {
+            if (m_pixelBufferFence[i])
+                f->glDeleteSync(m_pixelBufferFence[i]);
+            if (m_pixelBuffer[i])
+                f->glDeleteBuffers(1, &m_pixelBuffer[i]);
+            m_pixelBufferFence[i] = 0;
+            m_pixelBuffer[i] = 0;
+        }
+    }
+    m_textureSizes.clear();
+}
+
+void TextureUploader::updateStats(qint64 uploadNsecs)
+{
+    if (!m_statsTime.isValid())
+        m_statsTime.start();
+    ++m_statsFrameCount;
+    m_statsUploadNsecs += uploadNsecs;
+    m_statsMaxUploadNsecs = qMax(m_statsMaxUploadNsecs, uploadNsecs);
+    qint64 elapsed = m_statsTime.elapsed();
+    if (elapsed >= 10000) {
+        LOG_DEBUG() << "uploaded" << m_statsFrameCount << "frames at"
+                    << (1000.0 * m_statsFrameCount / elapsed) << "fps; upload ms average"
+                    << (m_statsUploadNsecs / m_statsFrameCount / 1.0e6) << "maximum"
+                    << (m_statsMaxUploadNsecs / 1.0e6);
+        m_statsTime.restart();
+        m_statsFrameCount = 0;
+        m_statsUploadNsecs = 0;
+        m_statsMaxUploadNsecs = 0;
+    }
+}
+
+void GLWidget::cleanupGL()
+{
+    LOG_DEBUG() << "begin";
+    // The context is current while the scene graph is invalidated.
+    QOpenGLContext* context = quickWindow()->openglContext();
+    QMutexLocker locker(&m_mutex);
+    m_textureUploader.cleanup(context);
+    // Without a frame renderer or GPU effects, the textures belong to this uploader.
+    if (!(Settings.playerGPU() || context->supportsThreadedOpenGL()) && m_texture[0]) {
+        context->functions()->glDeleteTextures(3, m_texture);
+        m_texture[0] = m_texture[1] = m_texture[2] = 0;
+    }
+    LOG_DEBUG() << "end";
 }
 
 void GLWidget::paintGL()
@@ -374,13 +524,22 @@ void GLWidget::paintGL()
             m_mutex.unlock();
             return;
         }
-        uploadTextures(quickWindow()->openglContext(), m_sharedFrame, m_texture);
+        m_textureUploader.upload(quickWindow()->openglContext(), m_sharedFrame, m_texture);
         m_mutex.unlock();
     } else if (m_glslManager) {
         m_mutex.lock();
         if (m_sharedFrame.is_valid()) {
             m_texture[0] = *((GLuint*) m_sharedFrame.get_image(mlt_image_glsl_texture));
         }
+    } else if (m_frameRenderer) {
+        // Draw the latest textures uploaded by the frame renderer, and let the
+        // GPU wait for their upload without blocking here.
+        GLsync fence = m_frameRenderer->acquireDisplayTextures(m_texture);
+        if (fence) {
+            QOpenGLExtraFunctions* ef = quickWindow()->openglContext()->extraFunctions();
+            ef->glWaitSync(fence, 0, GL_TIMEOUT_IGNORED);
+            ef->glDeleteSync(fence);
+        }
     }
 
     if (!m_texture[0]) {
@@ -472,6 +631,9 @@ void GLWidget::paintGL()
     if (m_glslManager) {
         glFinish(); check_error(f);
         m_mutex.unlock();
+    } else if (m_frameRenderer && m_frameRenderer->context()) {
+        // Tell the frame renderer when the GPU is done drawing its textures.
+        m_frameRenderer->releaseDisplayTextures(quickWindow()->openglContext());
     }
 }
 
@@ -819,25 +981,24 @@ void GLWidget::setSnapToGrid(bool snap)
     emit snapToGridChanged();
 }
 
-void GLWidget::updateTexture(GLuint yName, GLuint uName, GLuint vName)
-{
-    m_texture[0] = yName;
-    m_texture[1] = uName;
-    m_texture[2] = vName;
-}
-
 // MLT consumer-frame-show event handler
 void GLWidget::on_frame_show(mlt_consumer, void* self, mlt_frame frame_ptr)
 {
     Mlt::Frame frame(frame_ptr);
+    GLWidget* widget = static_cast<GLWidget*>(self);
     if (frame.get_int("rendered")) {
-        GLWidget* widget = static_cast<GLWidget*>(self);
         int timeout = (widget->consumer()->get_int("real_time") > 0)? 0: 1000;
         if (widget->m_frameRenderer && widget->m_frameRenderer->semaphore()->tryAcquire(1, timeout)) {
             QMetaObject::invokeMethod(widget->m_frameRenderer, "showFrame", Qt::QueuedConnection, Q_ARG(Mlt::Frame, frame));
-        } else if (!Settings.playerRealtime()) {
-            LOG_WARNING() << "GLWidget dropped frame" << frame.get_position();
+            widget->countFrame(false);
+        } else {
+            if (!Settings.playerRealtime())
+                LOG_WARNING() << "GLWidget dropped frame" << frame.get_position();
+            widget->countFrame(true);
         }
+    } else {
+        // The consumer dropped it to keep up; this feeds the render thread count.
+        widget->countFrame(true);
     }
 }
 
@@ -869,18 +1030,24 @@ void RenderThread::run()
     }
 }
 
-FrameRenderer::FrameRenderer(QOpenGLContext* shareContext, QSurface* surface)
+FrameRenderer::FrameRenderer(QOpenGLContext* shareContext, QSurface* surface, AudioTap* audioTap)
      : QThread(0)
      , m_semaphore(3)
      , m_context(0)
      , m_surface(surface)
+     , m_audioTap(audioTap)
      , m_previousMSecs(QDateTime::currentMSecsSinceEpoch())
      , m_imageRequested(false)
+     , m_displaySequence(0)
+     , m_displaySet(-1)
+     , m_paintingSet(-1)
+     , m_displayFence(0)
+     , m_paintedFence(0)
      , m_gl32(0)
 {
     Q_ASSERT(shareContext);
-    m_renderTexture[0] = m_renderTexture[1] = m_renderTexture[2] = 0;
-    m_displayTexture[0] = m_displayTexture[1] = m_displayTexture[2] = 0;
+    for (int i = 0; i < TextureSetCount; ++i)
+        m_textureSets[i][0] = m_textureSets[i][1] = m_textureSets[i][2] = 0;
     if (Settings.playerGPU() || shareContext->supportsThreadedOpenGL()) {
         m_context = new QOpenGLContext;
         m_context->setFormat(shareContext->format());
@@ -902,6 +1069,8 @@ FrameRenderer::~FrameRenderer()
 
 void FrameRenderer::showFrame(Mlt::Frame frame)
 {
+    // Number the frames in the order shown so that the scopes can tell them apart.
+    frame.set(kDisplaySequenceProperty, int64_t(++m_displaySequence));
     if (!Settings.playerGPU()) {
         m_displayFrame = SharedFrame(frame);
     }
@@ -969,17 +1138,34 @@ void FrameRenderer::showFrame(Mlt::Frame frame)
             m_context->makeCurrent(m_surface);
             QOpenGLFunctions* f = m_context->functions();
 
-            uploadTextures(m_context, m_displayFrame, m_renderTexture);
+            // Upload into the set that the GUI thread is neither drawing nor
+            // about to draw, after the GPU finishes its earlier draws from it.
+            int set = 0;
+            m_textureMutex.lock();
+            while (set == m_displaySet || set == m_paintingSet)
+                ++set;
+            if (m_paintedFence)
+                m_context->extraFunctions()->glWaitSync(m_paintedFence, 0, GL_TIMEOUT_IGNORED);
+            m_textureMutex.unlock();
+
+            m_textureUploader.upload(m_context, m_displayFrame, m_textureSets[set]);
             f->glBindTexture(GL_TEXTURE_2D, 0);
             check_error(f);
-            f->glFinish();
-
-            for (int i = 0; i < 3; ++i)
-                qSwap(m_renderTexture[i], m_displayTexture[i]);
-            emit textureReady(m_displayTexture[0], m_displayTexture[1], m_displayTexture[2]);
+            // The GUI thread waits for the fence before drawing the textures.
+            GLsync fence = m_textureUploader.createFence(m_context);
+            if (!fence)
+                f->glFinish();
+
+            m_textureMutex.lock();
+            if (m_displayFence)
+                m_context->extraFunctions()->glDeleteSync(m_displayFence);
+            m_displayFence = fence;
+            m_displaySet = set;
+            m_textureMutex.unlock();
             m_context->doneCurrent();
         }
     }
+    m_audioTap->write(m_displayFrame);
     emit frameDisplayed(m_displayFrame);
 
     if (m_imageRequested) {
@@ -995,6 +1181,30 @@ void FrameRenderer::requestImage()
     m_imageRequested = true;
 }
 
+GLsync FrameRenderer::acquireDisplayTextures(GLuint texture[])
+{
+    QMutexLocker locker(&m_textureMutex);
+    if (m_displaySet < 0)
+        return 0;
+    for (int i = 0; i < 3; ++i)
+        texture[i] = m_textureSets[m_displaySet][i];
+    m_paintingSet = m_displaySet;
+    GLsync fence = m_displayFence;
+    m_displayFence = 0;
+    return fence;
+}
+
+void FrameRenderer::releaseDisplayTextures(QOpenGLContext* context)
+{
+    GLsync fence = m_textureUploader.createFence(context);
+    if (!fence)
+        context->functions()->glFinish();
+    QMutexLocker locker(&m_textureMutex);
+    if (m_paintedFence)
+        context->extraFunctions()->glDeleteSync(m_paintedFence);
+    m_paintedFence = fence;
+}
+
 SharedFrame FrameRenderer::getDisplayFrame()
 {
     return m_displayFrame;
@@ -1003,13 +1213,22 @@ SharedFrame FrameRenderer::getDisplayFrame()
 void FrameRenderer::cleanup()
 {
     LOG_DEBUG() << "begin";
-    if (m_renderTexture[0] && m_renderTexture[1] && m_renderTexture[2]) {
+    QMutexLocker locker(&m_textureMutex);
+    if (m_displaySet >= 0) {
         m_context->makeCurrent(m_surface);
-        m_context->functions()->glDeleteTextures(3, m_renderTexture);
-        if (m_displayTexture[0] && m_displayTexture[1] && m_displayTexture[2])
-            m_context->functions()->glDeleteTextures(3, m_displayTexture);
+        QOpenGLExtraFunctions* f = m_context->extraFunctions();
+        m_textureUploader.cleanup(m_context);
+        if (m_displayFence)
+            f->glDeleteSync(m_displayFence);
+        if (m_paintedFence)
+            f->glDeleteSync(m_paintedFence);
+        for (int i = 0; i < TextureSetCount; ++i) {
+            if (m_textureSets[i][0])
+                f->glDeleteTextures(3, m_textureSets[i]);
+            m_textureSets[i][0] = m_textureSets[i][1] = m_textureSets[i][2] = 0;
+        }
         m_context->doneCurrent();
-        m_renderTexture[0] = m_renderTexture[1] = m_renderTexture[2] = 0;
-        m_displayTexture[0] = m_displayTexture[1] = m_displayTexture[2] = 0;
+        m_displayFence = m_paintedFence = 0;
+        m_displaySet = m_paintingSet = -1;
     }
 }
@@ -29,8 +29,12 @@
 #include <QThread>
 #include <QRectF>
 #include <QTimer>
+#include <QHash>
+#include <QSize>
+#include <QElapsedTimer>
 #include "mltcontroller.h"
 #include "sharedframe.h"
+#include "audiotap.h"
 
 class QOpenGLFunctions_3_2_Core;
 class QOpenGLTexture;
@@ -45,6 +49,32 @@ class FrameRenderer;
 
 typedef void* ( *thread_function_t )( void* );
 
+class TextureUploader
+{
+public:
+    TextureUploader();
+    void upload(QOpenGLContext* context, SharedFrame& frame, GLuint texture[]);
+    GLsync createFence(QOpenGLContext* context);
+    void cleanup(QOpenGLContext* context);
+
+private:
+    enum { PixelBufferCount = 3 };
+
+    void allocateTextures(QOpenGLFunctions* f, int width, int height, GLuint texture[]);
+    const uint8_t* fillPixelBuffer(QOpenGLContext* context, const uint8_t* image, int size);
+    void updateStats(qint64 uploadNsecs);
+
+    QHash<GLuint, QSize> m_textureSizes;
+    int m_isPixelBufferSupported;
+    GLuint m_pixelBuffer[PixelBufferCount];
+    GLsync m_pixelBufferFence[PixelBufferCount];
+    int m_pixelBufferIndex;
+    QElapsedTimer m_statsTime;
+    int m_statsFrameCount;
+    qint64 m_statsUploadNsecs;
+    qint64 m_statsMaxUploadNsecs;
+};
+
 class GLWidget : public QQuickWidget, public Controller, protected QOpenGLFunctions
 {
     Q_OBJECT
@@ -91,6 +121,7 @@ public:
     void requestImage() const;
     bool snapToGrid() const { return m_snapToGrid; }
     int maxTextureSize() const { return m_maxTextureSize; }
+    AudioTap* audioTap() { return &m_audioTap; }
 
 public slots:
     void onFrameDisplayed(const SharedFrame& frame);
@@ -143,20 +174,22 @@ private:
     QOffscreenSurface m_offscreenSurface;
     QOpenGLContext* m_shareContext;
     SharedFrame m_sharedFrame;
+    AudioTap m_audioTap;
     QMutex m_mutex;
     QUrl m_savedQmlSource;
     bool m_snapToGrid;
     QTimer m_refreshTimer;
     bool m_scrubAudio;
     GLint m_maxTextureSize;
+    TextureUploader m_textureUploader;
 
     static void on_frame_show(mlt_consumer, void* self, mlt_frame frame);
 
 private slots:
     void initializeGL();
     void resizeGL(int width, int height);
-    void updateTexture(GLuint yName, GLuint uName, GLuint vName);
     void paintGL();
+    void cleanupGL();
     void onRefreshTimeout();
 
 protected:
@@ -188,7 +221,7 @@ class FrameRenderer : public QThread
 {
     Q_OBJECT
 public:
-    FrameRenderer(QOpenGLContext* shareContext, QSurface* surface);
+    FrameRenderer(QOpenGLContext* shareContext, QSurface* surface, AudioTap* audioTap);
     ~FrameRenderer();
     QSemaphore* semaphore() { return &m_semaphore; }
     QOpenGLContext* context() const { return m_context; }
@@ -196,12 +229,13 @@ public:
     Q_INVOKABLE void showFrame(Mlt::Frame frame);
     void requestImage();
     QImage image() const { return m_image; }
+    GLsync acquireDisplayTextures(GLuint texture[]);
+    void releaseDisplayTextures(QOpenGLContext* context);
 
 public slots:
     void cleanup();
 
 signals:
-    void textureReady(GLuint yName, GLuint uName = 0, GLuint vName = 0);
     void frameDisplayed(const SharedFrame& frame);
     void imageReady();
 
@@ -210,13 +244,21 @@ private:
     SharedFrame m_displayFrame;
     QOpenGLContext* m_context;
     QSurface* m_surface;
+    AudioTap* m_audioTap;
     qint64 m_previousMSecs;
     bool m_imageRequested;
     QImage m_image;
-
-public:
-    GLuint m_renderTexture[3];
-    GLuint m_displayTexture[3];
+    qint64 m_displaySequence;
+    TextureUploader m_textureUploader;
+    // Three sets of textures let the renderer upload into one while the GUI
+    // thread draws another and a third waits to be drawn.
+    enum { TextureSetCount = 3 };
+    GLuint m_textureSets[TextureSetCount][3];
+    int m_displaySet;
+    int m_paintingSet;
+    GLsync m_displayFence;
+    GLsync m_paintedFence;
+    QMutex m_textureMutex;
     QOpenGLFunctions_3_2_Core* m_gl32;
 };
 
@@ -19,9 +19,14 @@
 #include <QtWidgets>
 #include <Logger.h>
 #include "settings.h"
+#include "util.h"
 #ifdef Q_OS_WIN
 #include "windowstools.h"
 #endif
+#include <algorithm>
+
+// Disks slow down when more jobs read and write at once.
+static const int kMaxIoJobs = 2;
 
 JobQueue::JobQueue(QObject *parent) :
     QStandardItemModel(0, COLUMN_COUNT, parent),
@@ -41,10 +46,8 @@ void JobQueue::cleanup()
 {
     QMutexLocker locker(&m_mutex);
     foreach (AbstractJob* job, m_jobs) {
-        if (job->state() == QProcess::Running) {
+        if (job->isRunning())
             job->stop();
-            break;
-        }
     }
     qDeleteAll(m_jobs);
 }
@@ -87,6 +90,11 @@ void JobQueue::onProgressUpdated(QStandardItem* standardItem, int percent)
             if (percent > 2)
                 remaining = job->estimateRemaining(percent).toString();
             standardItem->setText(QString("%1% (%2)").arg(percent).arg(remaining));
+#ifdef Q_OS_WIN
+            // The taskbar button follows the oldest of the running jobs.
+            if (job != firstRunningJob())
+                return;
+#endif
         }
     }
 #ifdef Q_OS_WIN
@@ -123,28 +131,94 @@ void JobQueue::onFinished(AbstractJob* job, bool isSuccess, QString time)
             item->setIcon(icon);
     }
 #ifdef Q_OS_WIN
-    WindowsTaskbarButton::getInstance().resetProgress();
+    if (!firstRunningJob())
+        WindowsTaskbarButton::getInstance().resetProgress();
 #endif
 
     startNextJob();
 }
 
+// Starts the pending jobs that fit in what the running jobs leave of the CPU
+// and memory budget. A job that runs alone always starts, however costly.
 void JobQueue::startNextJob()
 {
     if (m_paused) return;
-    QMutexLocker locker(&m_mutex);
-    if (!m_jobs.isEmpty()) {
-        foreach(AbstractJob* job, m_jobs) {
-            // if there is already a job started or running, then exit
-            if (job->ran() && job->state() != QProcess::NotRunning)
-                break;
-            // otherwise, start first non-started job and exit
-            if (!job->ran()) {
-                job->start();
-                break;
+    QList<AbstractJob*> canceled;
+    {
+        QMutexLocker locker(&m_mutex);
+        const int cpuBudget = qMax(1, Settings.jobsCpuBudget());
+        const int memoryBudget = Settings.jobsMemoryBudget();
+        int running = 0;
+        int cpuUsed = 0;
+        int memoryUsed = 0;
+        int ioRunning = 0;
+        QList<AbstractJob*> pending;
+        foreach (AbstractJob* job, m_jobs) {
+            if (job->isRunning()) {
+                ++running;
+                cpuUsed += qMin(job->cpuCost(), cpuBudget);
+                memoryUsed += job->memoryCost();
+                if (job->resourceClass() == AbstractJob::ResourceIo)
+                    ++ioRunning;
+            } else if (!job->ran()) {
+                pending << job;
+            }
+        }
+        // Higher priority first, otherwise in the order they were added.
+        std::stable_sort(pending.begin(), pending.end(), [](AbstractJob* a, AbstractJob* b) {
+            return a->priority() > b->priority();
+        });
+
+        bool isCpuReserved = false;
+        int isMemoryLow = -1;
+        foreach (AbstractJob* job, pending) {
+            AbstractJob* dependency = job->dependency();
+            if (dependency && !dependency->succeeded()) {
+                if (dependency->ran() && !dependency->isRunning())
+                    canceled << job;
+                continue;
+            }
+            const int cpuCost = qMin(job->cpuCost(), cpuBudget);
+            const bool isIo = job->resourceClass() == AbstractJob::ResourceIo;
+            if (running > 0) {
+                // Do not let smaller jobs keep a waiting one from the CPU.
+                if (cpuCost > 0 && (isCpuReserved || cpuUsed + cpuCost > cpuBudget)) {
+                    isCpuReserved = true;
+                    continue;
+                }
+                if (isIo && ioRunning >= kMaxIoJobs)
+                    continue;
+                if (memoryBudget > 0) {
+                    if (memoryUsed + job->memoryCost() > memoryBudget)
+                        continue;
+                } else {
+                    if (isMemoryLow < 0)
+                        isMemoryLow = Util::isMemoryLow()? 1 : 0;
+                    if (isMemoryLow)
+                        break;
+                }
             }
+            LOG_DEBUG() << "starting job" << job->label() << "with" << running << "running";
+            job->start();
+            ++running;
+            cpuUsed += cpuCost;
+            memoryUsed += job->memoryCost();
+            if (isIo)
+                ++ioRunning;
         }
     }
+    // This finishes the jobs, which comes back here.
+    foreach (AbstractJob* job, canceled)
+        job->cancel();
+}
+
+AbstractJob* JobQueue::firstRunningJob() const
+{
+    foreach (AbstractJob* job, m_jobs) {
+        if (job->isRunning())
+            return job;
+    }
+    return nullptr;
 }
 
 AbstractJob* JobQueue::jobFromIndex(const QModelIndex& index) const
@@ -171,7 +245,7 @@ bool JobQueue::isPaused() const
 bool JobQueue::hasIncomplete() const
 {
     foreach (AbstractJob* job, m_jobs) {
-        if (!job->ran() || job->state() == QProcess::Running)
+        if (!job->ran() || job->isRunning())
             return true;
     }
     return false;
@@ -195,7 +269,7 @@ void JobQueue::removeFinished()
     QMutexLocker locker(&m_mutex);
     auto row = 0;
     foreach (AbstractJob* job, m_jobs) {
-        if (job->ran() && job->state() != QProcess::Running) {
+        if (job->ran() && !job->isRunning()) {
             removeRow(row);
             m_jobs.removeOne(job);
             delete job;
@@ -28,6 +28,7 @@ class JobQueue : public QStandardItemModel
 protected:
     JobQueue(QObject *parent);
     void startNextJob();
+    AbstractJob* firstRunningJob() const;
 
 public:
     enum ColumnRole {
@@ -18,6 +18,7 @@
 #include "abstractjob.h"
 #include "postjobaction.h"
 #include <QApplication>
+#include <QThread>
 #include <QTimer>
 #include <Logger.h>
 #ifdef Q_OS_WIN
@@ -31,18 +32,23 @@ AbstractJob::AbstractJob(const QString& name)
     , m_killed(false)
     , m_label(name)
     , m_startingPercent(0)
+    , m_priority(0)
+    , m_succeeded(false)
 {
     setObjectName(name);
+    setResourceClass(ResourceCpu);
     connect(this, SIGNAL(finished(int, QProcess::ExitStatus)), this, SLOT(onFinished(int, QProcess::ExitStatus)));
     connect(this, SIGNAL(readyRead()), this, SLOT(onReadyRead()));
     connect(this, SIGNAL(started()), this, SLOT(onStarted()));
     connect(this, SIGNAL(progressUpdated(QStandardItem*, int)), SLOT(onProgressUpdated(QStandardItem*, int)));
+    connect(this, SIGNAL(finished(AbstractJob*, bool, QString)), SLOT(onJobFinished(AbstractJob*, bool)));
 }
 
 void AbstractJob::start()
 {
     m_killed = false;
     m_ran = true;
+    m_succeeded = false;
     m_estimateTime.start();
     m_totalTime.start();
     emit progressUpdated(m_item, 0);
@@ -68,6 +74,11 @@ bool AbstractJob::stopped() const
     return m_killed;
 }
 
+bool AbstractJob::isRunning() const
+{
+    return state() != QProcess::NotRunning;
+}
+
 void AbstractJob::appendToLog(const QString& s)
 {
     m_log.append(s);
@@ -98,6 +109,55 @@ void AbstractJob::setPostJobAction(PostJobAction* action)
     m_postJobAction.reset(action);
 }
 
+void AbstractJob::setResourceClass(ResourceClass resourceClass)
+{
+    m_resourceClass = resourceClass;
+    switch (resourceClass) {
+    case ResourceCpu:
+        m_cpuCost = QThread::idealThreadCount();
+        m_memoryCost = 1024;
+        break;
+    case ResourceIo:
+        m_cpuCost = 0;
+        m_memoryCost = 128;
+        break;
+    case ResourceLight:
+        m_cpuCost = 1;
+        m_memoryCost = 512;
+        break;
+    }
+}
+
+void AbstractJob::setCpuCost(int cores)
+{
+    m_cpuCost = qMax(0, cores);
+}
+
+void AbstractJob::setMemoryCost(int mebibytes)
+{
+    m_memoryCost = qMax(0, mebibytes);
+}
+
+void AbstractJob::setPriority(int priority)
+{
+    m_priority = priority;
+}
+
+void AbstractJob::setDependency(AbstractJob* job)
+{
+    m_dependency = job;
+}
+
+void AbstractJob::cancel()
+{
+    if (m_ran)
+        return;
+    m_ran = true;
+    m_killed = true;
+    m_log.append(QString("Canceled because the job before it did not succeed\n"));
+    emit finished(this, false);
+}
+
 void AbstractJob::stop()
 {
     closeWriteChannel();
@@ -153,6 +213,11 @@ void AbstractJob::onStarted()
 #endif
 }
 
+void AbstractJob::onJobFinished(AbstractJob*, bool isSuccess)
+{
+    m_succeeded = isSuccess;
+}
+
 void AbstractJob::onProgressUpdated(QStandardItem*, int percent)
 {
     // Start timer on first reported percentage > 0.
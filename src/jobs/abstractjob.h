@@ -23,6 +23,7 @@
 #include <QModelIndex>
 #include <QList>
 #include <QTime>
+#include <QPointer>
 
 class QAction;
 class QStandardItem;
@@ -31,6 +32,16 @@ class AbstractJob : public QProcess
 {
     Q_OBJECT
 public:
+    /*!
+      What a job mostly uses. The JobQueue runs jobs at the same time while
+      their costs fit in the budget of the machine.
+    */
+    enum ResourceClass {
+        ResourceCpu,   //!< encoding and transcoding, which use every core
+        ResourceIo,    //!< remuxing and copying, which mostly wait for the disk
+        ResourceLight  //!< analysis and other jobs that use about one core
+    };
+
     explicit AbstractJob(const QString& name);
     virtual ~AbstractJob() {}
 
@@ -38,6 +49,8 @@ public:
     QStandardItem* standardItem();
     bool ran() const;
     bool stopped() const;
+    //! Returns whether the job started and has not finished yet.
+    virtual bool isRunning() const;
     void appendToLog(const QString&);
     QString log() const;
     QString label() const { return m_label; }
@@ -47,6 +60,24 @@ public:
     QTime estimateRemaining(int percent);
     QTime time() const { return m_totalTime; }
     void setPostJobAction(PostJobAction* action);
+    ResourceClass resourceClass() const { return m_resourceClass; }
+    //! Sets the resource class and resets the costs to those of the class.
+    void setResourceClass(ResourceClass resourceClass);
+    //! Returns how many cores the job is expected to keep busy.
+    int cpuCost() const { return m_cpuCost; }
+    void setCpuCost(int cores);
+    //! Returns how much memory the job is expected to use in MiB.
+    int memoryCost() const { return m_memoryCost; }
+    void setMemoryCost(int mebibytes);
+    int priority() const { return m_priority; }
+    //! Jobs with a higher priority start before the ones added earlier.
+    void setPriority(int priority);
+    AbstractJob* dependency() const { return m_dependency; }
+    //! The job does not start before \a job succeeded.
+    void setDependency(AbstractJob* job);
+    bool succeeded() const { return m_succeeded; }
+    //! Finishes a job that has not started without running it.
+    void cancel();
 
 public slots:
     virtual void start();
@@ -68,6 +99,7 @@ protected slots:
 
 private slots:
     void onProgressUpdated(QStandardItem*, int percent);
+    void onJobFinished(AbstractJob*, bool isSuccess);
 
 private:
     bool m_ran;
@@ -78,6 +110,12 @@ private:
     int m_startingPercent;
     QTime m_totalTime;
     QScopedPointer<PostJobAction> m_postJobAction;
+    ResourceClass m_resourceClass;
+    int m_cpuCost;
+    int m_memoryCost;
+    int m_priority;
+    QPointer<AbstractJob> m_dependency;
+    bool m_succeeded;
 };
 
 #endif // ABSTRACTJOB_H
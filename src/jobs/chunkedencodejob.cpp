@@ -0,0 +1,393 @@
+/*
+ * Copyright (c) 2021 Meltytech, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "chunkedencodejob.h"
+#include "util.h"
+#include <Logger.h>
+#include <MltProfile.h>
+#include <MltProperties.h>
+
+#include <QApplication>
+#include <QDir>
+#include <QFileInfo>
+#include <QTemporaryFile>
+#include <QTextStream>
+#include <QThread>
+#include <QTime>
+#include <QTimer>
+
+// Segments shorter than this are not worth another process.
+static const int kMinimumChunkSeconds = 10;
+// The audio is cheap to encode compared with the video.
+static const int kAudioWeightDivisor = 20;
+
+ChunkedEncodeJob::ChunkedEncodeJob(const QString& name, const QString& xml, int frameRateNum,
+                                   int frameRateDen, int chunkCount)
+    : EncodeJob(name, xml, frameRateNum, frameRateDen)
+    , m_chunkCount(chunkCount)
+    , m_isRunning(false)
+    , m_finishedCount(0)
+    , m_partsPercent(0)
+{
+}
+
+ChunkedEncodeJob::~ChunkedEncodeJob()
+{
+    clearParts();
+}
+
+bool ChunkedEncodeJob::isRunning() const
+{
+    return m_isRunning || EncodeJob::isRunning();
+}
+
+void ChunkedEncodeJob::start()
+{
+    clearParts();
+    if (!prepareParts()) {
+        LOG_INFO() << "exporting without chunks";
+        clearParts();
+        EncodeJob::start();
+        return;
+    }
+    LOG_INFO() << "exporting in" << m_parts.size() << "parts";
+    appendToLog(QString("Exporting in %1 parts\n").arg(m_parts.size()));
+    m_isRunning = true;
+    m_finishedCount = 0;
+    m_partsPercent = 0;
+    foreach (Part* part, m_parts) {
+        part->process = new QProcess(this);
+        connect(part->process, SIGNAL(readyRead()), SLOT(onPartReadyRead()));
+        connect(part->process, SIGNAL(finished(int, QProcess::ExitStatus)),
+                SLOT(onPartFinished(int, QProcess::ExitStatus)));
+        // A part that fails to start does not emit finished().
+        connect(part->process, SIGNAL(errorOccurred(QProcess::ProcessError)),
+                SLOT(onPartErrorOccurred(QProcess::ProcessError)));
+        startMelt(part->process, meltArguments(part->xml->fileName()));
+    }
+    AbstractJob::start();
+}
+
+void ChunkedEncodeJob::stop()
+{
+    foreach (Part* part, m_parts) {
+        if (part->process && part->process->state() != QProcess::NotRunning) {
+            part->process->terminate();
+            QTimer::singleShot(2000, part->process, SLOT(kill()));
+        }
+    }
+    EncodeJob::stop();
+}
+
+void ChunkedEncodeJob::onFinished(int exitCode, QProcess::ExitStatus exitStatus)
+{
+    if (!m_isRunning) {
+        // This ran as a plain EncodeJob.
+        EncodeJob::onFinished(exitCode, exitStatus);
+        return;
+    }
+    // The concatenation finished.
+    m_isRunning = false;
+    clearParts();
+    AbstractJob::onFinished(exitCode, exitStatus);
+}
+
+void ChunkedEncodeJob::onPartReadyRead()
+{
+    Part* part = partFor(sender());
+    if (!part)
+        return;
+    QString msg;
+    do {
+        msg = part->process->readLine();
+        int index = msg.indexOf("percentage:");
+        if (index > -1) {
+            part->percent = msg.mid(index + 11).toInt();
+            updateProgress();
+        } else if (!msg.isEmpty()) {
+            appendToLog(QString("[%1] %2").arg(m_parts.indexOf(part) + 1).arg(msg));
+        }
+    } while (!msg.isEmpty());
+}
+
+void ChunkedEncodeJob::onPartFinished(int exitCode, QProcess::ExitStatus exitStatus)
+{
+    Part* part = partFor(sender());
+    if (!part || !m_isRunning)
+        return;
+    QString rest = part->process->readAll();
+    if (!rest.isEmpty())
+        appendToLog(QString("[%1] %2").arg(m_parts.indexOf(part) + 1).arg(rest));
+    if (stopped()) {
+        foreach (Part* other, m_parts) {
+            if (other->process->state() != QProcess::NotRunning)
+                return;
+        }
+        // AbstractJob reports the stop when its own process ends, but
+        // none was started yet.
+        m_isRunning = false;
+        LOG_INFO() << "job stopped";
+        appendToLog(QString("Stopped by user at %1\n")
+                    .arg(QTime::fromMSecsSinceStartOfDay(time().elapsed()).toString()));
+        clearParts();
+        emit finished(this, false);
+    } else if (exitStatus != QProcess::NormalExit || exitCode != 0) {
+        fail(QString("Part %1 failed with exit code %2\n").arg(m_parts.indexOf(part) + 1).arg(exitCode));
+    } else {
+        part->percent = 100;
+        updateProgress();
+        if (++m_finishedCount == m_parts.size())
+            concatenate();
+    }
+}
+
+void ChunkedEncodeJob::onPartErrorOccurred(QProcess::ProcessError error)
+{
+    Part* part = partFor(sender());
+    if (!part || !m_isRunning || error != QProcess::FailedToStart)
+        return;
+    fail(QString("Part %1 failed to start: %2\n").arg(m_parts.indexOf(part) + 1)
+         .arg(part->process->errorString()));
+}
+
+bool ChunkedEncodeJob::prepareParts()
+{
+    QDomDocument dom(xmlPath());
+    if (!dom.setContent(xml()))
+        return false;
+    QDomElement root = dom.documentElement();
+    QDomElement consumer = root.firstChildElement("consumer");
+    // melt plays the last service of the document.
+    QDomElement service = root.lastChildElement();
+    while (!service.isNull() && service.tagName() != "tractor" && service.tagName() != "playlist"
+           && service.tagName() != "producer" && service.tagName() != "chain")
+        service = service.previousSiblingElement();
+    if (consumer.isNull() || service.isNull()
+            || !service.hasAttribute("in") || !service.hasAttribute("out"))
+        return false;
+    // There is nothing to split without video, and image sequences are
+    // numbered by frame.
+    if (consumer.attribute("vn").toInt() || consumer.attribute("target").contains('%'))
+        return false;
+
+    Mlt::Profile profile;
+    QDomElement profileElement = root.firstChildElement("profile");
+    int frameRateNum = profileElement.attribute("frame_rate_num").toInt();
+    int frameRateDen = profileElement.attribute("frame_rate_den").toInt();
+    if (frameRateNum > 0 && frameRateDen > 0)
+        profile.set_frame_rate(frameRateNum, frameRateDen);
+    Mlt::Properties properties;
+    properties.set("_profile", profile.get_profile(), 0);
+    int in = properties.time_to_frames(service.attribute("in").toUtf8().constData());
+    int out = properties.time_to_frames(service.attribute("out").toUtf8().constData());
+    int length = out - in + 1;
+    int chunkCount = qMin(m_chunkCount, int(length / (kMinimumChunkSeconds * profile.fps())));
+    if (chunkCount < 2)
+        return false;
+
+    // Start every segment on a keyframe of the unsplit encode.
+    int gop = qMax(1, consumer.attribute("g").toInt());
+    QList<int> boundaries;
+    boundaries << in;
+    for (int i = 1; i < chunkCount; i++) {
+        int boundary = in + qRound(double(length) * i / chunkCount / gop) * gop;
+        if (boundary > boundaries.last() && boundary <= out)
+            boundaries << boundary;
+    }
+    boundaries << out + 1;
+    if (boundaries.size() < 3)
+        return false;
+
+    // The segments are joined without the consumer, so pass on its options
+    // that apply to the container.
+    m_muxerArguments.clear();
+    if (consumer.hasAttribute("f"))
+        m_muxerArguments << "-f" << consumer.attribute("f");
+    if (consumer.hasAttribute("movflags"))
+        m_muxerArguments << "-movflags" << consumer.attribute("movflags");
+    QDomNamedNodeMap attributes = consumer.attributes();
+    for (int i = 0; i < attributes.count(); i++) {
+        QDomAttr attribute = attributes.item(i).toAttr();
+        QString name = attribute.name();
+        // meta.attr.<key>.markup as written by the avformat consumer
+        if (name.startsWith("meta.attr.") && name.endsWith(".markup") && !name.contains(".stream.")) {
+            QString key = name.mid(10, name.size() - 10 - 7);
+            m_muxerArguments << "-metadata" << QString("%1=%2").arg(key, attribute.value());
+        }
+    }
+    int threads = consumer.attribute("threads").toInt();
+    for (int i = 0; i + 1 < boundaries.size(); i++) {
+        QDomDocument chunk = dom.cloneNode(true).toDocument();
+        QDomElement chunkConsumer = chunk.documentElement().firstChildElement("consumer");
+        chunkConsumer.removeAttribute("acodec");
+        chunkConsumer.setAttribute("an", 1);
+        // The chunks share the cores instead of each using all of them.
+        chunkConsumer.setAttribute("real_time", -1);
+        if (threads <= 0)
+            chunkConsumer.setAttribute("threads", qMax(1, QThread::idealThreadCount() / (boundaries.size() - 1)));
+        if (!addPart(chunk, boundaries[i], boundaries[i + 1] - 1, false, boundaries[i + 1] - boundaries[i]))
+            return false;
+    }
+    if (!consumer.attribute("an").toInt() && consumer.hasAttribute("acodec")) {
+        QDomDocument audio = dom.cloneNode(true).toDocument();
+        QDomElement audioConsumer = audio.documentElement().firstChildElement("consumer");
+        audioConsumer.removeAttribute("vcodec");
+        audioConsumer.setAttribute("vn", 1);
+        audioConsumer.setAttribute("real_time", -1);
+        if (!addPart(audio, in, out, true, qMax(1, length / kAudioWeightDivisor)))
+            return false;
+    }
+    return true;
+}
+
+// Adds a part that renders the range from \a in to \a out of \a dom.
+bool ChunkedEncodeJob::addPart(const QDomDocument& dom, int in, int out, bool isAudio, int weight)
+{
+    QDomElement root = dom.documentElement();
+    QDomElement service = root.lastChildElement();
+    while (service.tagName() != "tractor" && service.tagName() != "playlist"
+           && service.tagName() != "producer" && service.tagName() != "chain")
+        service = service.previousSiblingElement();
+    service.setAttribute("in", in);
+    service.setAttribute("out", out);
+
+    // Keep the parts next to the target; the temporary folder may be too small.
+    QFileInfo info(objectName());
+    QString templateName = QString("%1/%2.XXXXXX.%3").arg(QDir::fromNativeSeparators(info.path()))
+            .arg(info.completeBaseName()).arg(info.suffix());
+    QScopedPointer<QTemporaryFile> output(new QTemporaryFile(templateName, this));
+    if (!output->open()) {
+        LOG_WARNING() << "failed to create" << templateName;
+        return false;
+    }
+    output->close();
+    root.firstChildElement("consumer").setAttribute("target", output->fileName());
+
+    QScopedPointer<QTemporaryFile> xml(Util::writableTemporaryFile(objectName(), "shotcut-XXXXXX.mlt"));
+    xml->setParent(this);
+    xml->open();
+    xml->write(dom.toString(2).toUtf8());
+    xml->close();
+
+    Part* part = new Part;
+    part->process = nullptr;
+    part->xml = xml.take();
+    part->output = output.take();
+    part->isAudio = isAudio;
+    part->weight = weight;
+    part->percent = 0;
+    m_parts << part;
+    return true;
+}
+
+ChunkedEncodeJob::Part* ChunkedEncodeJob::partFor(QObject* process)
+{
+    foreach (Part* part, m_parts) {
+        if (part->process == process)
+            return part;
+    }
+    return nullptr;
+}
+
+void ChunkedEncodeJob::updateProgress()
+{
+    qint64 done = 0;
+    qint64 total = 0;
+    foreach (Part* part, m_parts) {
+        done += qint64(part->percent) * part->weight;
+        total += part->weight;
+    }
+    // Leave the last percent for the concatenation.
+    int percent = total? qMin(99, int(done / total)) : 0;
+    if (percent != m_partsPercent) {
+        m_partsPercent = percent;
+        emit progressUpdated(m_item, percent);
+    }
+}
+
+// Joins the video parts and muxes the audio part with the FFmpeg concat
+// demuxer in this job's own process.
+void ChunkedEncodeJob::concatenate()
+{
+    m_concatList.reset(Util::writableTemporaryFile(objectName(), "shotcut-XXXXXX.txt"));
+    m_concatList->open();
+    QTextStream stream(m_concatList.data());
+    Part* audio = nullptr;
+    foreach (Part* part, m_parts) {
+        if (part->isAudio) {
+            audio = part;
+        } else {
+            QString path = QDir::fromNativeSeparators(part->output->fileName());
+            stream << "file '" << path.replace("'", "'\\''") << "'\n";
+        }
+    }
+    stream.flush();
+    m_concatList->close();
+
+    QStringList args;
+    args << "-hide_banner" << "-y";
+    args << "-f" << "concat" << "-safe" << "0" << "-i" << m_concatList->fileName();
+    if (audio) {
+        args << "-i" << audio->output->fileName();
+        args << "-map" << "0:v" << "-map" << "1:a";
+    }
+    args << "-c" << "copy";
+    args << m_muxerArguments;
+    args << objectName();
+
+    QFileInfo ffmpegPath(qApp->applicationDirPath(), "ffmpeg");
+    setReadChannel(QProcess::StandardError);
+    LOG_DEBUG() << ffmpegPath.absoluteFilePath() + " " + args.join(' ');
+#ifdef Q_OS_WIN
+    QProcess::start(ffmpegPath.absoluteFilePath(), args);
+#else
+    args.prepend(ffmpegPath.absoluteFilePath());
+    args.prepend("3");
+    args.prepend("-n");
+    QProcess::start("nice", args);
+#endif
+}
+
+void ChunkedEncodeJob::fail(const QString& message)
+{
+    LOG_INFO() << "job failed:" << message;
+    appendToLog(message);
+    m_isRunning = false;
+    clearParts();
+    emit finished(this, false);
+}
+
+void ChunkedEncodeJob::clearParts()
+{
+    foreach (Part* part, m_parts) {
+        if (part->process) {
+            part->process->disconnect(this);
+            if (part->process->state() != QProcess::NotRunning) {
+                part->process->kill();
+                part->process->waitForFinished(1000);
+            }
+            // This may be called from a signal of the process.
+            part->process->deleteLater();
+        }
+        // The temporary files are removed with their objects.
+        delete part->xml;
+        delete part->output;
+        delete part;
+    }
+    m_parts.clear();
+    m_concatList.reset();
+}
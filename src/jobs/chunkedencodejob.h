@@ -0,0 +1,92 @@
+/*
+ * Copyright (c) 2021 Meltytech, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef CHUNKEDENCODEJOB_H
+#define CHUNKEDENCODEJOB_H
+
+#include "encodejob.h"
+#include <QDomDocument>
+#include <QList>
+#include <QScopedPointer>
+
+/*!
+  \class ChunkedEncodeJob
+  \brief The ChunkedEncodeJob exports a timeline in parts that are encoded at
+  the same time.
+
+  The range of the job XML is cut into up to chunkCount segments, on a
+  multiple of the GOP size where one is set so that the keyframes land where
+  a single encode would put them. Each segment is rendered without audio by
+  its own melt process with the in and out points of the XML set to its
+  range, and the audio is rendered by one more melt process. When all of them
+  succeeded, the FFmpeg concat demuxer joins the segments and muxes the audio
+  without encoding again, with the movflags and metadata of the consumer.
+
+  If the XML can not be split, e.g. because it has no in and out points or
+  writes an image sequence, the job runs as a plain EncodeJob.
+*/
+
+class ChunkedEncodeJob : public EncodeJob
+{
+    Q_OBJECT
+public:
+    ChunkedEncodeJob(const QString& name, const QString& xml, int frameRateNum, int frameRateDen,
+                     int chunkCount);
+    virtual ~ChunkedEncodeJob();
+    bool isRunning() const Q_DECL_OVERRIDE;
+
+public slots:
+    void start() Q_DECL_OVERRIDE;
+    void stop() Q_DECL_OVERRIDE;
+
+protected slots:
+    void onFinished(int exitCode, QProcess::ExitStatus exitStatus) Q_DECL_OVERRIDE;
+
+private slots:
+    void onPartReadyRead();
+    void onPartFinished(int exitCode, QProcess::ExitStatus exitStatus);
+    void onPartErrorOccurred(QProcess::ProcessError error);
+
+private:
+    struct Part {
+        QProcess* process;
+        QTemporaryFile* xml;
+        QTemporaryFile* output;
+        bool isAudio;
+        int weight;
+        int percent;
+    };
+
+    bool prepareParts();
+    bool addPart(const QDomDocument& dom, int in, int out, bool isAudio, int weight);
+    Part* partFor(QObject* process);
+    void updateProgress();
+    void concatenate();
+    void fail(const QString& message);
+    void clearParts();
+
+    int m_chunkCount;
+    QList<Part*> m_parts;
+    QScopedPointer<QTemporaryFile> m_concatList;
+    //! The muxer options of the consumer for the concatenation
+    QStringList m_muxerArguments;
+    bool m_isRunning;
+    int m_finishedCount;
+    int m_partsPercent;
+};
+
+#endif // CHUNKEDENCODEJOB_H
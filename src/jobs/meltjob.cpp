@@ -94,20 +94,41 @@ void MeltJob::start()
         });
         return;
     }
-    QString shotcutPath = qApp->applicationDirPath();
-    QFileInfo meltPath(shotcutPath, "melt");
-    setReadChannel(QProcess::StandardError);
+    QStringList args;
+    if (m_args.size() > 0) {
+        args << "-verbose";
+        args << "-progress2";
+        args << "-abort";
+        args.append(m_args);
+    } else {
+        args = meltArguments(xmlPath());
+    }
+#ifdef Q_OS_WIN
+    if (m_isStreaming) args << "-getc";
+#endif
+    startMelt(this, args);
+    AbstractJob::start();
+}
+
+QStringList MeltJob::meltArguments(const QString& path) const
+{
     QStringList args;
     args << "-verbose";
     args << "-progress2";
     args << "-abort";
-    if (m_args.size() > 0) {
-        args.append(m_args);
-    } else if (m_useMultiConsumer) {
-        args << QUrl::toPercentEncoding(xmlPath()) + "?multi:1";
+    if (m_useMultiConsumer) {
+        args << QUrl::toPercentEncoding(path) + "?multi:1";
     } else {
-        args << QUrl::toPercentEncoding(xmlPath());
+        args << QUrl::toPercentEncoding(path);
     }
+    return args;
+}
+
+void MeltJob::startMelt(QProcess* process, QStringList args)
+{
+    QString shotcutPath = qApp->applicationDirPath();
+    QFileInfo meltPath(shotcutPath, "melt");
+    process->setReadChannel(QProcess::StandardError);
     LOG_DEBUG() << meltPath.absoluteFilePath() << args;
 #ifndef Q_OS_MAC
     QProcessEnvironment env = QProcessEnvironment::systemEnvironment();
@@ -115,18 +136,16 @@ void MeltJob::start()
     // fractional or otherwise.
     env.insert("QT_AUTO_SCREEN_SCALE_FACTOR", "1");
     env.insert("QT_SCALE_FACTOR_ROUNDING_POLICY", "PassThrough");
-    setProcessEnvironment(env);
+    process->setProcessEnvironment(env);
 #endif
 #ifdef Q_OS_WIN
-    if (m_isStreaming) args << "-getc";
-    QProcess::start(meltPath.absoluteFilePath(), args);
+    process->start(meltPath.absoluteFilePath(), args);
 #else
     args.prepend(meltPath.absoluteFilePath());
     args.prepend("3");
     args.prepend("-n");
-    QProcess::start("nice", args);
+    process->start("nice", args);
 #endif
-    AbstractJob::start();
 }
 
 QString MeltJob::xml()
@@ -45,6 +45,11 @@ protected slots:
     void onReadyRead();
 
 protected:
+    //! Returns the arguments for melt to run the job XML file at \a path.
+    QStringList meltArguments(const QString& path) const;
+    //! Starts melt with \a args in \a process at a low priority.
+    static void startMelt(QProcess* process, QStringList args);
+
     QScopedPointer<QTemporaryFile> m_xml;
 
 private:
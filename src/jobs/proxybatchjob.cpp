@@ -0,0 +1,280 @@
+/*
+ * Copyright (c) 2021 Meltytech, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "proxybatchjob.h"
+#include "postjobaction.h"
+#include <Logger.h>
+
+#include <QApplication>
+#include <QFile>
+#include <QFileInfo>
+#include <QTime>
+#include <QTimer>
+
+ProxyBatchJob::ProxyBatchJob(const QString& name, int workerCount, int threadCount)
+    : AbstractJob(name)
+    , m_workerCount(qMax(1, workerCount))
+    , m_threadCount(qMax(1, threadCount))
+    , m_isRunning(false)
+    , m_nextIndex(0)
+    , m_runningCount(0)
+    , m_failedCount(0)
+    , m_previousPercent(0)
+{
+    setResourceClass(ResourceCpu);
+    setCpuCost(m_workerCount * m_threadCount);
+    setMemoryCost(m_workerCount * 256);
+    qRegisterMetaType<QProcess::ProcessError>("QProcess::ProcessError");
+}
+
+ProxyBatchJob::~ProxyBatchJob()
+{
+    clearProcesses();
+    foreach (Proxy* proxy, m_proxies) {
+        if (!proxy->isDone)
+            QFile::remove(proxy->fileName);
+        delete proxy->action;
+        delete proxy;
+    }
+}
+
+bool ProxyBatchJob::isRunning() const
+{
+    return m_isRunning;
+}
+
+void ProxyBatchJob::addProxy(const QString& fileName, const QStringList& args, double seconds, PostJobAction* action)
+{
+    Proxy* proxy = new Proxy;
+    proxy->fileName = fileName;
+    proxy->args = args;
+    proxy->seconds = qMax(1.0, seconds);
+    proxy->action = action;
+    proxy->process = nullptr;
+    proxy->percent = 0.0;
+    proxy->isDone = false;
+    m_proxies << proxy;
+}
+
+void ProxyBatchJob::start()
+{
+    clearProcesses();
+    AbstractJob::start();
+    appendToLog(QString("Making %1 proxies with %2 processes of %3 threads\n")
+                .arg(m_proxies.size()).arg(m_workerCount).arg(m_threadCount));
+    m_isRunning = true;
+    m_nextIndex = 0;
+    m_runningCount = 0;
+    m_failedCount = 0;
+    m_previousPercent = 0;
+    foreach (Proxy* proxy, m_proxies) {
+        proxy->percent = proxy->isDone? 100.0 : 0.0;
+    }
+    for (int i = 0; i < m_workerCount; i++)
+        startNextProxy();
+    // The JobQueue is still starting this job.
+    if (!m_runningCount)
+        QMetaObject::invokeMethod(this, "finish", Qt::QueuedConnection);
+}
+
+void ProxyBatchJob::stop()
+{
+    foreach (Proxy* proxy, m_proxies) {
+        if (proxy->process && proxy->process->state() != QProcess::NotRunning) {
+            proxy->process->terminate();
+            QTimer::singleShot(2000, proxy->process, SLOT(kill()));
+        }
+    }
+    AbstractJob::stop();
+    if (m_isRunning && !m_runningCount)
+        finish();
+}
+
+void ProxyBatchJob::onProxyReadyRead()
+{
+    Proxy* proxy = proxyFor(sender());
+    if (!proxy)
+        return;
+    QString msg;
+    do {
+        msg = proxy->process->readLine();
+        // The progress lines may be separated by carriage returns only.
+        int index = msg.lastIndexOf("time=");
+        if (msg.startsWith("frame=") && index > -1) {
+            QStringList time = msg.mid(index + 5).section(' ', 0, 0).split(':');
+            if (time.size() == 3) {
+                double seconds = time[0].toInt() * 3600 + time[1].toInt() * 60 + time[2].toDouble();
+                proxy->percent = qBound(0.0, 100.0 * seconds / proxy->seconds, 100.0);
+                updateProgress();
+            }
+        } else if (!msg.trimmed().isEmpty()) {
+            appendToLog(QString("[%1] %2").arg(m_proxies.indexOf(proxy) + 1).arg(msg));
+        }
+    } while (!msg.isEmpty());
+}
+
+void ProxyBatchJob::onProxyFinished(int exitCode, QProcess::ExitStatus exitStatus)
+{
+    Proxy* proxy = proxyFor(sender());
+    if (!proxy || !m_isRunning)
+        return;
+    --m_runningCount;
+    QString rest = proxy->process->readAll();
+    if (!rest.trimmed().isEmpty())
+        appendToLog(QString("[%1] %2").arg(m_proxies.indexOf(proxy) + 1).arg(rest));
+    proxy->process->disconnect(this);
+    proxy->process->deleteLater();
+    proxy->process = nullptr;
+    int number = m_proxies.indexOf(proxy) + 1;
+    if (stopped()) {
+        QFile::remove(proxy->fileName);
+    } else if (exitStatus == QProcess::NormalExit && exitCode == 0) {
+        appendToLog(QString("[%1] Completed successfully\n").arg(number));
+        proxy->isDone = true;
+        proxy->percent = 100.0;
+        if (proxy->action)
+            proxy->action->doAction();
+        updateProgress();
+        startNextProxy();
+    } else {
+        LOG_INFO() << "proxy failed with" << exitCode << proxy->fileName;
+        appendToLog(QString("[%1] Failed with exit code %2\n").arg(number).arg(exitCode));
+        QFile::remove(proxy->fileName);
+        ++m_failedCount;
+        // Count it as done for the progress; running the job again retries it.
+        proxy->percent = 100.0;
+        updateProgress();
+        startNextProxy();
+    }
+    if (!m_runningCount)
+        finish();
+}
+
+void ProxyBatchJob::onProxyErrorOccurred(QProcess::ProcessError error)
+{
+    Proxy* proxy = proxyFor(sender());
+    if (!proxy || !m_isRunning || error != QProcess::FailedToStart)
+        return;
+    --m_runningCount;
+    int number = m_proxies.indexOf(proxy) + 1;
+    LOG_WARNING() << "proxy failed to start" << proxy->process->errorString() << proxy->fileName;
+    appendToLog(QString("[%1] Failed to start: %2\n").arg(number).arg(proxy->process->errorString()));
+    proxy->process->disconnect(this);
+    proxy->process->deleteLater();
+    proxy->process = nullptr;
+    if (!stopped()) {
+        ++m_failedCount;
+        // Count it as done for the progress; running the job again retries it.
+        proxy->percent = 100.0;
+        updateProgress();
+        startNextProxy();
+    }
+    if (!m_runningCount)
+        finish();
+}
+
+void ProxyBatchJob::startNextProxy()
+{
+    if (stopped())
+        return;
+    while (m_nextIndex < m_proxies.size() && m_proxies[m_nextIndex]->isDone)
+        ++m_nextIndex;
+    if (m_nextIndex >= m_proxies.size())
+        return;
+    Proxy* proxy = m_proxies[m_nextIndex++];
+    proxy->process = new QProcess(this);
+    proxy->process->setReadChannel(QProcess::StandardError);
+    connect(proxy->process, SIGNAL(readyReadStandardError()), SLOT(onProxyReadyRead()));
+    connect(proxy->process, SIGNAL(finished(int, QProcess::ExitStatus)),
+            SLOT(onProxyFinished(int, QProcess::ExitStatus)));
+    // A process that fails to start emits only errorOccurred(), possibly from start().
+    connect(proxy->process, SIGNAL(errorOccurred(QProcess::ProcessError)),
+            SLOT(onProxyErrorOccurred(QProcess::ProcessError)), Qt::QueuedConnection);
+
+    QStringList args = proxy->args;
+    QFileInfo ffmpegPath(qApp->applicationDirPath(), "ffmpeg");
+    LOG_DEBUG() << ffmpegPath.absoluteFilePath() + " " + args.join(' ');
+#ifdef Q_OS_WIN
+    proxy->process->start(ffmpegPath.absoluteFilePath(), args);
+#else
+    args.prepend(ffmpegPath.absoluteFilePath());
+    args.prepend("3");
+    args.prepend("-n");
+    proxy->process->start("nice", args);
+#endif
+    ++m_runningCount;
+}
+
+ProxyBatchJob::Proxy* ProxyBatchJob::proxyFor(QObject* process)
+{
+    foreach (Proxy* proxy, m_proxies) {
+        if (proxy->process == process)
+            return proxy;
+    }
+    return nullptr;
+}
+
+void ProxyBatchJob::updateProgress()
+{
+    double done = 0.0;
+    double total = 0.0;
+    foreach (Proxy* proxy, m_proxies) {
+        done += proxy->percent * proxy->seconds;
+        total += proxy->seconds;
+    }
+    int percent = total > 0.0? qMin(99, int(done / total)) : 0;
+    if (percent != m_previousPercent) {
+        m_previousPercent = percent;
+        emit progressUpdated(m_item, percent);
+    }
+}
+
+// Reports the batch like AbstractJob reports a process that ended.
+void ProxyBatchJob::finish()
+{
+    m_isRunning = false;
+    const QTime& time = QTime::fromMSecsSinceStartOfDay(this->time().elapsed());
+    if (stopped()) {
+        LOG_INFO() << "job stopped";
+        appendToLog(QString("Stopped by user at %1\n").arg(time.toString()));
+        emit finished(this, false);
+    } else if (m_failedCount) {
+        LOG_INFO() << "job failed with" << m_failedCount << "proxies";
+        appendToLog(QString("%1 of %2 proxies failed\n").arg(m_failedCount).arg(m_proxies.size()));
+        emit finished(this, false);
+    } else {
+        LOG_INFO() << "job succeeeded";
+        appendToLog(QString("Completed successfully in %1\n").arg(time.toString()));
+        emit progressUpdated(m_item, 100);
+        emit finished(this, true);
+    }
+}
+
+void ProxyBatchJob::clearProcesses()
+{
+    foreach (Proxy* proxy, m_proxies) {
+        if (proxy->process) {
+            proxy->process->disconnect(this);
+            if (proxy->process->state() != QProcess::NotRunning) {
+                proxy->process->kill();
+                proxy->process->waitForFinished(1000);
+            }
+            proxy->process->deleteLater();
+            proxy->process = nullptr;
+        }
+    }
+}
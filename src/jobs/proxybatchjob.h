@@ -0,0 +1,89 @@
+/*
+ * Copyright (c) 2021 Meltytech, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PROXYBATCHJOB_H
+#define PROXYBATCHJOB_H
+
+#include "abstractjob.h"
+#include <QList>
+#include <QStringList>
+
+/*!
+  \class ProxyBatchJob
+  \brief The ProxyBatchJob makes the proxies for many clips as one job.
+
+  The proxies are made in the order they were added by up to a number of
+  FFmpeg processes at the same time, each limited to a number of threads.
+  The progress and the estimated time are those of the whole batch, weighted
+  by the duration of each clip. A proxy that fails does not stop the others;
+  the post job action of each proxy runs when that proxy is done.
+*/
+
+class ProxyBatchJob : public AbstractJob
+{
+    Q_OBJECT
+public:
+    ProxyBatchJob(const QString& name, int workerCount, int threadCount);
+    virtual ~ProxyBatchJob();
+    bool isRunning() const Q_DECL_OVERRIDE;
+
+    /*!
+      Adds a proxy that FFmpeg makes at \a fileName from \a args, which should
+      limit it to threadCount() threads. The \a seconds of the clip weigh its
+      progress, and the job owns the \a action.
+    */
+    void addProxy(const QString& fileName, const QStringList& args, double seconds, PostJobAction* action);
+    int count() const { return m_proxies.size(); }
+    int threadCount() const { return m_threadCount; }
+
+public slots:
+    void start() Q_DECL_OVERRIDE;
+    void stop() Q_DECL_OVERRIDE;
+
+private slots:
+    void onProxyReadyRead();
+    void onProxyFinished(int exitCode, QProcess::ExitStatus exitStatus);
+    void onProxyErrorOccurred(QProcess::ProcessError error);
+    void finish();
+
+private:
+    struct Proxy {
+        QString fileName;
+        QStringList args;
+        double seconds;
+        PostJobAction* action;
+        QProcess* process;
+        double percent;
+        bool isDone;
+    };
+
+    void startNextProxy();
+    Proxy* proxyFor(QObject* process);
+    void updateProgress();
+    void clearProcesses();
+
+    int m_workerCount;
+    int m_threadCount;
+    QList<Proxy*> m_proxies;
+    bool m_isRunning;
+    int m_nextIndex;
+    int m_runningCount;
+    int m_failedCount;
+    int m_previousPercent;
+};
+
+#endif // PROXYBATCHJOB_H
@@ -28,8 +28,10 @@ QImageJob::QImageJob(const QString& destFilePath, const QString& srcFilePath, co
     , m_srcFilePath(srcFilePath)
     , m_destFilePath(destFilePath)
     , m_height(height)
+    , m_isRunning(false)
 {
     setLabel(tr("Make proxy for %1").arg(Util::baseName(srcFilePath)));
+    setResourceClass(ResourceLight);
 }
 
 QImageJob::~QImageJob()
@@ -42,6 +44,7 @@ QImageJob::~QImageJob()
 void QImageJob::start()
 {
     AbstractJob::start();
+    m_isRunning = true;
     QtConcurrent::run([=]() {
         appendToLog(QString("Reading source image \"%1\"\n").arg(m_srcFilePath));
         QImageReader reader;
@@ -64,3 +67,15 @@ void QImageJob::start()
         }
     });
 }
+
+// There is no process, so the job is running while the image is converted.
+bool QImageJob::isRunning() const
+{
+    return m_isRunning;
+}
+
+void QImageJob::onFinished(int exitCode, QProcess::ExitStatus exitStatus)
+{
+    m_isRunning = false;
+    AbstractJob::onFinished(exitCode, exitStatus);
+}
@@ -29,11 +29,16 @@ public:
     virtual ~QImageJob();
     void start();
     void execute();
+    bool isRunning() const Q_DECL_OVERRIDE;
+
+protected slots:
+    void onFinished(int exitCode, QProcess::ExitStatus exitStatus = QProcess::NormalExit) Q_DECL_OVERRIDE;
 
 private:
     QString m_srcFilePath;
     QString m_destFilePath;
     int m_height;
+    bool m_isRunning;
 };
 
 #endif // QIMAGEJOB_H
@@ -0,0 +1,239 @@
+/*
+ * Copyright (c) 2021 Meltytech, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LOCKFREEDATAQUEUE_H
+#define LOCKFREEDATAQUEUE_H
+
+#include <QAtomicInt>
+#include <QAtomicInteger>
+#include <QScopedArrayPointer>
+#include <QSemaphore>
+#include <QThread>
+
+/*!
+  \class LockFreeDataQueue
+  \brief The LockFreeDataQueue is a DataQueue that does not lock a mutex to
+  pass an item.
+
+  \threadsafe
+
+  LockFreeDataQueue has the same interface and overflow modes as DataQueue
+  and can replace it where many items are passed between threads, such as
+  frames to the scopes. Any number of threads may push() and pop().
+
+  The items are kept in a bounded ring in which every slot carries a sequence
+  number (D. Vyukov's bounded MPMC queue). A thread claims a slot with one
+  compare-and-swap of the head or tail and publishes it by advancing the
+  slot's sequence. Two QSemaphore count the free and the filled slots; they
+  only make a thread sleep when it has to wait (an empty queue in pop(), a
+  full queue in push() in OverflowModeWait) and otherwise are a single atomic
+  operation.
+*/
+
+template <class T>
+class LockFreeDataQueue
+{
+public:
+    //! Overflow behavior modes.
+    typedef enum {
+        OverflowModeDiscardOldest = 0, //!< Discard oldest items
+        OverflowModeDiscardNewest,     //!< Discard newest items
+        OverflowModeWait               //!< Wait for space to be free
+    } OverflowMode;
+
+    /*!
+      Constructs a LockFreeDataQueue.
+
+      The \a size will be the maximum queue size and the \a mode will dictate
+      overflow behavior.
+    */
+    explicit LockFreeDataQueue(int maxSize, OverflowMode mode);
+
+    //! Destructs a LockFreeDataQueue.
+    virtual ~LockFreeDataQueue();
+
+    /*!
+      Pushes an item into the queue.
+
+      If the queue is full and overflow mode is OverflowModeWait then this
+      function will block until pop() is called.
+    */
+    void push(const T& item);
+
+    /*!
+      Pops an item from the queue.
+
+      If the queue is empty then this  function will block. If blocking is
+      undesired, then check the return of count() before calling pop().
+    */
+    T pop();
+
+    //! Returns the number of items in the queue.
+    int count() const;
+
+    //! Returns how many items were discarded because the queue was full.
+    int discardedCount() const;
+
+private:
+    struct Slot {
+        QAtomicInteger<quintptr> sequence;
+        T item;
+    };
+
+    void enqueue(const T& item);
+    T dequeue();
+
+    QScopedArrayPointer<Slot> m_slots;
+    quintptr m_mask;
+    OverflowMode m_mode;
+    QSemaphore m_freeSlots;
+    QSemaphore m_usedSlots;
+    QAtomicInt m_discardedCount;
+    // Producers and consumers each write only their own position. Keep them
+    // apart so that they do not share a cache line.
+    char m_padding0[64];
+    QAtomicInteger<quintptr> m_tail;
+    char m_padding1[64];
+    QAtomicInteger<quintptr> m_head;
+    char m_padding2[64];
+};
+
+template <class T>
+LockFreeDataQueue<T>::LockFreeDataQueue(int maxSize, OverflowMode mode)
+  : m_mask(0)
+  , m_mode(mode)
+  , m_freeSlots(maxSize)
+  , m_usedSlots(0)
+  , m_discardedCount(0)
+  , m_tail(0)
+  , m_head(0)
+{
+    // The ring is a power of two so that positions map to slots by masking.
+    // The semaphores keep it to maxSize items.
+    quintptr capacity = 1;
+    while (capacity < quintptr(maxSize))
+        capacity <<= 1;
+    m_mask = capacity - 1;
+    m_slots.reset(new Slot[capacity]);
+    for (quintptr i = 0; i < capacity; i++)
+        m_slots[i].sequence.store(i);
+}
+
+template <class T>
+LockFreeDataQueue<T>::~LockFreeDataQueue()
+{
+}
+
+template <class T>
+void LockFreeDataQueue<T>::push(const T& item)
+{
+    while (!m_freeSlots.tryAcquire()) {
+        switch (m_mode) {
+        case OverflowModeDiscardOldest:
+            // Make room unless a consumer just did.
+            if (m_usedSlots.tryAcquire()) {
+                dequeue();
+                m_freeSlots.release();
+                m_discardedCount.ref();
+            }
+            break;
+        case OverflowModeDiscardNewest:
+            // This item is the newest so discard it and exit
+            m_discardedCount.ref();
+            return;
+        case OverflowModeWait:
+            m_freeSlots.acquire();
+            enqueue(item);
+            m_usedSlots.release();
+            return;
+        }
+    }
+    enqueue(item);
+    m_usedSlots.release();
+}
+
+template <class T>
+T LockFreeDataQueue<T>::pop()
+{
+    m_usedSlots.acquire();
+    T item = dequeue();
+    m_freeSlots.release();
+    return item;
+}
+
+template <class T>
+int LockFreeDataQueue<T>::count() const
+{
+    return m_usedSlots.available();
+}
+
+template <class T>
+int LockFreeDataQueue<T>::discardedCount() const
+{
+    return m_discardedCount.load();
+}
+
+// The caller owns a free slot, so the ring has room for the item. A slot can
+// still be briefly busy while the consumer that claimed it copies the item.
+template <class T>
+void LockFreeDataQueue<T>::enqueue(const T& item)
+{
+    quintptr position = m_tail.load();
+    forever {
+        Slot& slot = m_slots[position & m_mask];
+        qintptr difference = qintptr(slot.sequence.loadAcquire() - position);
+        if (difference == 0) {
+            if (m_tail.testAndSetRelaxed(position, position + 1, position)) {
+                slot.item = item;
+                slot.sequence.storeRelease(position + 1);
+                return;
+            }
+        } else if (difference < 0) {
+            QThread::yieldCurrentThread();
+            position = m_tail.load();
+        } else {
+            position = m_tail.load();
+        }
+    }
+}
+
+// The caller owns a used slot, so an item is or soon will be published.
+template <class T>
+T LockFreeDataQueue<T>::dequeue()
+{
+    quintptr position = m_head.load();
+    forever {
+        Slot& slot = m_slots[position & m_mask];
+        qintptr difference = qintptr(slot.sequence.loadAcquire() - (position + 1));
+        if (difference == 0) {
+            if (m_head.testAndSetRelaxed(position, position + 1, position)) {
+                T item = slot.item;
+                // Do not hold on to the item (e.g. a frame) in the ring.
+                slot.item = T();
+                slot.sequence.storeRelease(position + m_mask + 1);
+                return item;
+            }
+        } else if (difference < 0) {
+            QThread::yieldCurrentThread();
+            position = m_head.load();
+        } else {
+            position = m_head.load();
+        }
+    }
+}
+
+#endif // LOCKFREEDATAQUEUE_H
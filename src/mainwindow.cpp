@@ -78,6 +78,7 @@
 #include "dialogs/longuitask.h"
 #include "dialogs/systemsyncdialog.h"
 #include "proxymanager.h"
+#include "producerpool.h"
 #ifdef Q_OS_WIN
 #include "windowstools.h"
 #endif
@@ -502,8 +503,6 @@ MainWindow::MainWindow()
 
     connect(&m_network, SIGNAL(finished(QNetworkReply*)), SLOT(onUpgradeCheckFinished(QNetworkReply*)));
 
-    QThreadPool::globalInstance()->setMaxThreadCount(qMin(4, QThreadPool::globalInstance()->maxThreadCount()));
-
     ProxyManager::removePending();
 
     LOG_DEBUG() << "end";
@@ -2527,7 +2526,9 @@ void MainWindow::closeEvent(QCloseEvent* event)
                 onMultitrackClosed();
         }
         QThreadPool::globalInstance()->clear();
+        MLT.backgroundThreadPool().clear();
         AudioLevelsTask::closeAll();
+        ProducerPool::singleton().clear();
         event->accept();
         emit aboutToShutDown();
         if (m_exitCode == EXIT_SUCCESS) {
@@ -4648,14 +4649,15 @@ void MainWindow::on_actionUseProxy_triggered(bool checked)
                     dialog.setDefaultButton(QMessageBox::Yes);
                     dialog.setEscapeButton(QMessageBox::No);
                     if (dialog.exec() == QMessageBox::Yes) {
+                        QList<Mlt::Producer> producers;
                         Mlt::Producer producer(playlist());
-                        if (producer.is_valid()) {
-                            ProxyManager::generateIfNotExistsAll(producer);
-                        }
+                        if (producer.is_valid())
+                            producers << producer;
                         producer = multitrack();
-                        if (producer.is_valid()) {
-                            ProxyManager::generateIfNotExistsAll(producer);
-                        }
+                        if (producer.is_valid())
+                            producers << producer;
+                        // Start with the proxies of the clips around the playhead.
+                        ProxyManager::generateIfNotExistsAll(producers, m_timelineDock->position());
                     }
                 }
             } else if (fileName != untitledFileName()) {
@@ -0,0 +1,30 @@
+# Finds MLT. This is shared by src.pro and the tests.
+
+mac {
+    # QMake from Qt 5.1.0 on OSX is messing with the environment in which it runs
+    # pkg-config such that the PKG_CONFIG_PATH env var is not set.
+    isEmpty(MLT_PREFIX) {
+        MLT_PREFIX = /opt/local
+    }
+    isEmpty(PREFIX) {
+        INCLUDEPATH += $$MLT_PREFIX/include/mlt++
+        INCLUDEPATH += $$MLT_PREFIX/include/mlt
+        LIBS += -L$$MLT_PREFIX/lib -lmlt++ -lmlt
+    } else {
+        INCLUDEPATH += $$PREFIX/Contents/Frameworks/include/mlt++
+        INCLUDEPATH += $$PREFIX/Contents/Frameworks/include/mlt
+        LIBS += -L$$PREFIX/Contents/Frameworks -lmlt++ -lmlt
+    }
+}
+win32 {
+    isEmpty(MLT_PATH) {
+        MLT_PATH = $$clean_path($$PWD/../../..)
+        message("MLT_PATH not set; using $$MLT_PATH. You can change this with 'qmake MLT_PATH=...'")
+    }
+    INCLUDEPATH += $$MLT_PATH\\include\\mlt++ $$MLT_PATH\\include\\mlt
+    LIBS += -L$$MLT_PATH\\lib -lmlt++ -lmlt
+}
+unix:!mac {
+    CONFIG += link_pkgconfig
+    PKGCONFIG += mlt++
+}
@@ -24,6 +24,8 @@
 #include <QSaveFile>
 #include <QTextStream>
 #include <QThreadPool>
+#include <QThread>
+#include <QtMath>
 #include <Logger.h>
 #include <Mlt.h>
 #include <cmath>
@@ -890,7 +892,7 @@ QImage Controller::image(Producer& producer, int frameNumber, int width, int hei
 
 void Controller::updateAvformatCaching(int trackCount)
 {
-    int i = QThreadPool::globalInstance()->maxThreadCount() + trackCount * 2;
+    int i = backgroundThreadPool().maxThreadCount() + trackCount * 2;
     mlt_service_cache_set_size(nullptr, "producer_avformat", qMax(4, i));
 }
 
@@ -916,16 +918,71 @@ int Controller::realTime() const
         if (Settings.playerGPU()) {
             return -1;
         } 
+        realtime = -renderThreadCount();
+    }
+    return realtime;
+}
+
+int Controller::renderThreadCount() const
+{
 #if QT_POINTER_SIZE == 4
-        // Limit to 1 rendering thread on 32-bit process to reduce memory usage.
-        int threadCount = 1;
+    // Limit to 1 rendering thread on 32-bit process to reduce memory usage.
+    return 1;
 #else
-        int threadCount = QThread::idealThreadCount();
-#endif
-        threadCount = threadCount > 2? qMin(threadCount - 1, 4) : 1;
-        realtime = -threadCount;
+    if (Settings.playerRenderThreads() > 0)
+        return Settings.playerRenderThreads();
+
+    int cores = QThread::idealThreadCount();
+    if (cores <= 2)
+        return 1;
+    // Leave one core for the user interface and audio.
+    int available = cores - 1;
+    // Start with two threads per 720p worth of pixels but no fewer than before.
+    int pixels = m_previewProfile.width() * m_previewProfile.height();
+    int threadCount = qMax(4, 2 * qCeil(pixels / double(1280 * 720)));
+
+    // Adjust by the frames dropped since the consumer was last configured.
+    int shown = m_shownFrameCount.fetchAndStoreRelaxed(0);
+    int dropped = m_droppedFrameCount.fetchAndStoreRelaxed(0);
+    if (shown + dropped >= 100) {
+        double dropRate = double(dropped) / (shown + dropped);
+        if (dropRate > 0.02)
+            m_renderThreadBoost = qMin(m_renderThreadBoost + 2, available);
+        else if (dropped == 0 && m_renderThreadBoost > 0)
+            --m_renderThreadBoost;
+        LOG_DEBUG() << "dropped" << dropped << "of" << (shown + dropped) << "frames; thread boost" << m_renderThreadBoost;
     }
-    return realtime;
+    threadCount = qBound(1, threadCount + m_renderThreadBoost, available);
+    LOG_DEBUG() << "render threads" << threadCount << "of" << cores << "cores";
+    return threadCount;
+#endif
+}
+
+void Controller::countFrame(bool isDropped)
+{
+    if (isDropped)
+        m_droppedFrameCount.fetchAndAddRelaxed(1);
+    else
+        m_shownFrameCount.fetchAndAddRelaxed(1);
+}
+
+static QThreadPool* createBackgroundThreadPool()
+{
+    QThreadPool* pool = new QThreadPool;
+    int threadCount = Settings.backgroundThreads();
+    if (threadCount <= 0)
+        threadCount = qBound(2, QThread::idealThreadCount() / 4, 8);
+    pool->setMaxThreadCount(threadCount);
+    LOG_DEBUG() << "background threads" << threadCount;
+    return pool;
+}
+
+QThreadPool& Controller::backgroundThreadPool()
+{
+    // Thumbnails, waveforms, and such run here to not compete with the global
+    // pool or the render threads.
+    static QScopedPointer<QThreadPool> pool(createBackgroundThreadPool());
+    return *pool;
 }
 
 void Controller::setImageDurationFromDefault(Service* service) const
@@ -24,11 +24,13 @@
 #include <QScopedPointer>
 #include <QTemporaryFile>
 #include <QMutex>
+#include <QAtomicInt>
 #include <Mlt.h>
 #include "transportcontrol.h"
 
 // forward declarations
 class QQuickView;
+class QThreadPool;
 
 #if defined(Q_OS_UNIX) && !defined(Q_OS_MAC)
 #   define MLT_LC_CATEGORY LC_NUMERIC
@@ -116,6 +118,9 @@ public:
     void updateAvformatCaching(int trackCount);
     bool isAudioFilter(const QString& name);
     int realTime() const;
+    int renderThreadCount() const;
+    void countFrame(bool isDropped);
+    static QThreadPool& backgroundThreadPool();
     void setImageDurationFromDefault(Service* service) const;
     void setDurationFromDefault(Producer* service) const;
     void lockCreationTime(Producer* producer) const;
@@ -188,6 +193,9 @@ private:
     unsigned m_skipJackEvents{0};
     QString m_projectFolder;
     QMutex m_saveXmlMutex;
+    mutable QAtomicInt m_shownFrameCount;
+    mutable QAtomicInt m_droppedFrameCount;
+    mutable int m_renderThreadBoost{0};
 
     static void on_jack_started(mlt_properties owner, void* object, const mlt_position *position);
     void onJackStarted(int position);
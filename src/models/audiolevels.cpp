@@ -0,0 +1,78 @@
+/*
+ * Copyright (c) 2021 Meltytech, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "audiolevels.h"
+
+quint8 AudioLevels::maxPeak(int firstFrame, int lastFrame) const
+{
+    firstFrame = qMax(0, firstFrame);
+    lastFrame = qMin(lastFrame, frameCount() - 1);
+    if (lastFrame < firstFrame)
+        return 0;
+
+    quint8 result = 0;
+    if (m_pyramid.isEmpty()) {
+        const quint8* data = constData();
+        for (int i = firstFrame * m_channels; i < (lastFrame + 1) * m_channels; ++i)
+            result = qMax(result, data[i]);
+        return result;
+    }
+
+    // Use the coarsest level whose entries are no wider than the range so that
+    // only a few entries are read. The entries at the edges may extend beyond
+    // the range by less than the width of one entry.
+    int level = 0;
+    const int span = lastFrame - firstFrame + 1;
+    while (level + 1 < m_pyramid.size() && (2 << level) <= span)
+        ++level;
+    const QByteArray& entries = m_pyramid.at(level);
+    const int last = qMin(lastFrame >> level, entries.size() - 1);
+    for (int i = firstFrame >> level; i <= last; ++i)
+        result = qMax(result, quint8(entries.at(i)));
+    return result;
+}
+
+QVector<QByteArray> AudioLevels::buildPyramid(const QByteArray& peaks, int channels)
+{
+    QVector<QByteArray> pyramid;
+    if (channels < 1 || peaks.size() < channels)
+        return pyramid;
+
+    const int frames = peaks.size() / channels;
+    const quint8* data = reinterpret_cast<const quint8*>(peaks.constData());
+    QByteArray level(frames, 0);
+    for (int i = 0; i < frames; ++i) {
+        quint8 peak = 0;
+        for (int channel = 0; channel < channels; ++channel)
+            peak = qMax(peak, data[i * channels + channel]);
+        level[i] = char(peak);
+    }
+    pyramid << level;
+
+    while (level.size() > 1) {
+        const QByteArray& previous = pyramid.last();
+        const int n = (previous.size() + 1) / 2;
+        level = QByteArray(n, 0);
+        for (int i = 0; i < n; ++i) {
+            quint8 a = quint8(previous.at(2 * i));
+            quint8 b = (2 * i + 1 < previous.size())? quint8(previous.at(2 * i + 1)) : a;
+            level[i] = char(qMax(a, b));
+        }
+        pyramid << level;
+    }
+    return pyramid;
+}
@@ -0,0 +1,72 @@
+/*
+ * Copyright (c) 2021 Meltytech, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef AUDIOLEVELS_H
+#define AUDIOLEVELS_H
+
+#include <QByteArray>
+#include <QVector>
+#include <QMetaType>
+
+/*!
+  \class AudioLevels
+  \brief Immutable, reference counted audio peak levels.
+
+  The peaks are stored as one unsigned byte per channel per frame with the
+  channels interleaved. Copies share the same buffer, so AudioLevels can be
+  passed by value through QVariant, the models, and into QML at no cost.
+
+  Optionally, a pyramid of peaks is attached. Its first level holds the
+  largest peak of all channels per frame, and each following level holds the
+  largest of two entries of the previous one. This lets maxPeak() answer for
+  any range of frames by reading only a few bytes.
+*/
+
+class AudioLevels
+{
+public:
+    AudioLevels()
+        : m_channels(0)
+    {}
+    AudioLevels(const QByteArray& peaks, int channels,
+                const QVector<QByteArray>& pyramid = QVector<QByteArray>())
+        : m_peaks(peaks)
+        , m_pyramid(pyramid)
+        , m_channels(channels)
+    {}
+
+    bool isEmpty() const { return m_peaks.isEmpty(); }
+    int channels() const { return m_channels; }
+    int size() const { return m_peaks.size(); }
+    quint8 at(int index) const { return quint8(m_peaks.at(index)); }
+    const quint8* constData() const { return reinterpret_cast<const quint8*>(m_peaks.constData()); }
+    const QByteArray& peaks() const { return m_peaks; }
+    int frameCount() const { return m_channels > 0 ? m_peaks.size() / m_channels : 0; }
+    const QVector<QByteArray>& pyramid() const { return m_pyramid; }
+    quint8 maxPeak(int firstFrame, int lastFrame) const;
+
+    static QVector<QByteArray> buildPyramid(const QByteArray& peaks, int channels);
+
+private:
+    QByteArray m_peaks;
+    QVector<QByteArray> m_pyramid;
+    int m_channels;
+};
+
+Q_DECLARE_METATYPE(AudioLevels)
+
+#endif // AUDIOLEVELS_H
@@ -16,40 +16,81 @@
  */
 
 #include "audiolevelstask.h"
+#include "audiolevels.h"
+#include "audiopeakfile.h"
 #include "database.h"
 #include "mltcontroller.h"
 #include "shotcut_mlt_properties.h"
 #include "settings.h"
+#include "producerpool.h"
 #include <QString>
-#include <QVariantList>
+#include <QByteArray>
 #include <QImage>
 #include <QCryptographicHash>
 #include <QRgb>
 #include <QThreadPool>
+#include <QThread>
 #include <QMutex>
 #include <QTime>
 #include <QElapsedTimer>
+#include <QtConcurrent/QtConcurrentRun>
 #include <Logger.h>
+#include <MltPlaylist.h>
+#include <algorithm>
 
 static QList<AudioLevelsTask*> tasksList;
 static QMutex tasksListMutex;
 
-static void deleteQVariantList(QVariantList* list)
+// Media shorter than this many frames (2 minutes at 25 fps) is decoded serially.
+static const int kMinimumRangeFrames = 3000;
+
+static QThreadPool& rangeThreadPool()
+{
+    // The tasks themselves run in the background pool. Helpers must not wait for a slot there
+    // behind other tasks, or the tasks could block each other.
+    static QThreadPool pool;
+    return pool;
+}
+
+static int clipInPoint(QObject* object, const QModelIndex& index)
 {
-    delete list;
+    MultitrackModel* model = qobject_cast<MultitrackModel*>(object);
+    if (model && model->tractor() && index.isValid() && index.parent().isValid()) {
+        int trackIndex = index.parent().row();
+        if (trackIndex >= 0 && trackIndex < model->trackList().size()) {
+            QScopedPointer<Mlt::Producer> track(model->tractor()->track(model->trackList().at(trackIndex).mlt_index));
+            if (track && track->is_valid()) {
+                Mlt::Playlist playlist(*track);
+                QScopedPointer<Mlt::ClipInfo> info(playlist.clip_info(index.row()));
+                if (info)
+                    return info->frame_in;
+            }
+        }
+    }
+    return 0;
+}
+
+static void deleteAudioLevels(AudioLevels* levels)
+{
+    delete levels;
 }
 
 AudioLevelsTask::AudioLevelsTask(Mlt::Producer& producer, QObject* object, const QModelIndex& index)
     : QRunnable()
     , m_object(object)
+    , m_tempProducer(nullptr)
     , m_isCanceled(false)
     , m_isForce(false)
+    , m_priorityFrame(0)
+    , m_channels(2)
+    , m_levelsData(0)
 {
     m_producers << ProducerAndIndex(new Mlt::Producer(producer), index);
 }
 
 AudioLevelsTask::~AudioLevelsTask()
 {
+    checkInTempProducer();
     foreach (ProducerAndIndex p, m_producers)
         delete p.first;
 }
@@ -79,8 +120,12 @@ void AudioLevelsTask::start(Mlt::Producer& producer, QObject* object, const QMod
         if (task) {
             // Otherwise, start a new audio levels generation thread.
             task->m_isForce = force;
+            // Decode the media around the visible start of the clip first.
+            int in = clipInPoint(object, index);
+            if (in > 0 && MLT.profile().fps() > 0.0)
+                task->m_priorityFrame = qRound(in * task->m_profile.fps() / MLT.profile().fps());
             tasksList << task;
-            QThreadPool::globalInstance()->start(task);
+            MLT.backgroundThreadPool().start(task);
         }
         tasksListMutex.unlock();
     }
@@ -112,29 +157,24 @@ bool AudioLevelsTask::operator==(AudioLevelsTask &b)
 
 Mlt::Producer* AudioLevelsTask::tempProducer()
 {
-    if (!m_tempProducer) {
-        Mlt::Producer* producer = m_producers.first().first;
-        QString service = producer->get("mlt_service");
-        if (service == "avformat-novalidate")
-            service = "avformat";
-        else if (service.startsWith("xml"))
-            service = "xml-nogl";
-        m_tempProducer.reset(new Mlt::Producer(m_profile, service.toUtf8().constData(),
-            producer->get("resource")));
-        if (m_tempProducer->is_valid()) {
-            Mlt::Filter channels(m_profile, "audiochannels");
-            Mlt::Filter converter(m_profile, "audioconvert");
-            Mlt::Filter levels(m_profile, "audiolevel");
-            m_tempProducer->attach(channels);
-            m_tempProducer->attach(converter);
-            m_tempProducer->attach(levels);
-            if (producer->get("audio_index")) {
-                m_tempProducer->pass_property(*producer, "audio_index");
-            }
-            m_tempProducer->set("video_index", -1);
-        }
-    }
-    return m_tempProducer.data();
+    if (!m_tempProducer)
+        m_tempProducer = checkOutProducer();
+    return m_tempProducer;
+}
+
+void AudioLevelsTask::checkInTempProducer()
+{
+    ProducerPool::singleton().checkIn(m_tempProducer);
+    m_tempProducer = nullptr;
+}
+
+// Returns a producer with the audio level filters from the ProducerPool.
+Mlt::Producer* AudioLevelsTask::checkOutProducer()
+{
+    Mlt::Producer* producer = m_producers.first().first;
+    return ProducerPool::singleton().checkOut(QString(), producer->get("mlt_service"),
+        QString::fromUtf8(producer->get("resource")), ProducerPool::AudioLevels,
+        QString::fromLatin1(producer->get("audio_index")));
 }
 
 QString AudioLevelsTask::cacheKey()
@@ -164,16 +204,39 @@ QString AudioLevelsTask::cacheKey()
 
 void AudioLevelsTask::run()
 {
+    // TODO: use project channel count
+    const int channels = m_channels;
     // 2 channels interleaved of uchar values
-    QVariantList levels;
-    QImage image = DB.getThumbnail(cacheKey());
-    if ((image.isNull() || m_isForce) && !DB.isFailing()) {
-        const char* key[2] = { "meta.media.audio_level.0", "meta.media.audio_level.1"};
-        QElapsedTimer updateTime;
-        updateTime.start();
-        // TODO: use project channel count
-        int channels = 2;
-
+    QByteArray levels;
+    QVector<QByteArray> pyramid;
+    const QString key = cacheKey();
+    const int frameRateNum = m_profile.frame_rate_num();
+    const int frameRateDen = m_profile.frame_rate_den();
+    AudioLevels cached;
+    bool isCached = !m_isForce && AudioPeakFile::read(key, frameRateNum, frameRateDen, cached);
+    if (!isCached && !m_isForce) {
+        // Convert levels cached by earlier versions as an image in the database.
+        QImage image = DB.getThumbnail(key);
+        if (!image.isNull()) {
+            int n = image.width() * image.height();
+            if (n > 1)
+                levels.reserve(n * 4);
+            for (int i = 0; n > 1 && i < n; i++) {
+                QRgb p = image.pixel(i / 2, i % channels);
+                levels.append(char(qRed(p)));
+                levels.append(char(qGreen(p)));
+                levels.append(char(qBlue(p)));
+                levels.append(char(qAlpha(p)));
+            }
+            cached = AudioLevels(levels, channels, AudioLevels::buildPyramid(levels, channels));
+            AudioPeakFile::write(key, frameRateNum, frameRateDen, cached);
+            isCached = true;
+        }
+    }
+    if (isCached) {
+        levels = cached.peaks();
+        pyramid = cached.pyramid();
+    } else {
         if (tempProducer()->get("audio_index")) {
             LOG_DEBUG() << "generating audio levels for" << tempProducer()->get("resource")
                         << "audio track =" << tempProducer()->get("audio_index");
@@ -181,78 +244,41 @@ void AudioLevelsTask::run()
             LOG_DEBUG() << "generating audio levels for" << tempProducer()->get("resource");
         }
 
-        // for each frame
+        // Long media is split into ranges of frames that are decoded in parallel, each
+        // range by its own producer, directly into their place in the levels.
         int n = tempProducer()->get_playtime();
-        for (int i = 0; i < n && !m_isCanceled; i++) {
-            Mlt::Frame* frame = tempProducer()->get_frame();
-            if (frame && frame->is_valid() && !frame->get_int("test_audio")) {
-                mlt_audio_format format = mlt_audio_s16;
-                int frequency = 48000;
-                int samples = mlt_sample_calculator(m_producers.first().first->get_fps(), frequency, i);
-                frame->get_audio(format, frequency, channels, samples);
-                // for each channel
-                for (int channel = 0; channel < channels; channel++)
-                    // Convert real to uint for caching as image.
-                    // Scale by 0.9 because values may exceed 1.0 to indicate clipping.
-                    levels << 256 * qMin(frame->get_double(key[channel]) * 0.9, 1.0);
-            } else if (!levels.isEmpty()) {
-                for (int channel = 0; channel < channels; channel++)
-                    levels << levels.last();
-            }
-            delete frame;
+        m_levels = QByteArray(qMax(0, n) * channels, 0);
+        m_levelsData = m_levels.data();
+        splitRanges(n);
+        // Let a range decode with the temporary producer.
+        checkInTempProducer();
 
-            // Incrementally update the audio levels every 3 seconds.
-            if (updateTime.elapsed() > 3*1000 && !m_isCanceled) {
-                updateTime.restart();
-                foreach (ProducerAndIndex p, m_producers) {
-                    QVariantList* levelsCopy = new QVariantList(levels);
-                    p.first->lock();
-                    p.first->set(kAudioLevelsProperty, levelsCopy, 0, (mlt_destructor) deleteQVariantList);
-                    p.first->unlock();
-                    if (-1 != m_object->metaObject()->indexOfMethod("audioLevelsReady(QModelIndex)"))
-                        QMetaObject::invokeMethod(m_object, "audioLevelsReady", Q_ARG(const QModelIndex&, p.second));
-                }
+        QList<QFuture<void>> helpers;
+        int threadCount = qMin(m_ranges.size(), QThread::idealThreadCount());
+        for (int i = 1; i < threadCount; i++)
+            helpers << QtConcurrent::run(&rangeThreadPool(), this, &AudioLevelsTask::decodeRanges, false);
+        m_updateTime.start();
+        decodeRanges(true);
+        foreach (QFuture<void> future, helpers) {
+            // Keep reporting progress until the remaining ranges are done.
+            while (!future.isFinished()) {
+                QThread::msleep(50);
+                if (m_updateTime.elapsed() > 3*1000 && !m_isCanceled)
+                    reportProgress();
             }
         }
+        if (m_hasAudio.loadAcquire())
+            levels = m_levels;
+        m_levelsData = 0;
+        m_levels.clear();
+        m_ranges.clear();
+
         if (!m_isCanceled) {
-            // Put into an image for caching.
-            int count = levels.size();
-            QImage image((count + 3) / 4 / channels, channels, QImage::Format_ARGB32);
-            n = image.width() * image.height();
-            for (int i = 0; i < n; i ++) {
-                QRgb p;
-                if ((4*i + 3) < count) {
-                    p = qRgba(levels.at(4*i).toInt(), levels.at(4*i+1).toInt(), levels.at(4*i+2).toInt(), levels.at(4*i+3).toInt());
-                } else {
-                    int last = levels.last().toInt();
-                    int r = (4*i+0) < count? levels.at(4*i+0).toInt() : last;
-                    int g = (4*i+1) < count? levels.at(4*i+1).toInt() : last;
-                    int b = (4*i+2) < count? levels.at(4*i+2).toInt() : last;
-                    int a = last;
-                    p = qRgba(r, g, b, a);
-                }
-                image.setPixel(i / 2, i % channels, p);
-            }
-            if (!image.isNull()) {
-                DB.putThumbnail(cacheKey(), image);
-            } else {
-                // If the produducer does not produce audio, make a special 1x1 RGBA(0,0,0,0) image,
-                // which is used to prevent QImage::isNull() from being true and continually trying
-                // to regenerate audio levels for this file.
-                QImage image(1, 1, QImage::Format_ARGB32);
-                DB.putThumbnail(cacheKey(), image);
-            }
-        }
-    } else if (!m_isCanceled && !image.isNull()) {
-        // convert cached image
-        int channels = 2;
-        int n = image.width() * image.height();
-        for (int i = 0; n > 1 && i < n; i++) {
-            QRgb p = image.pixel(i / 2, i % channels);
-            levels << qRed(p);
-            levels << qGreen(p);
-            levels << qBlue(p);
-            levels << qAlpha(p);
+            // Build the pyramid once to share it with all of the producers and the peak file.
+            // If the producer does not produce audio, the peak file is written without
+            // frames to prevent continually trying to regenerate audio levels for this file.
+            pyramid = AudioLevels::buildPyramid(levels, channels);
+            AudioPeakFile::write(key, frameRateNum, frameRateDen, AudioLevels(levels, channels, pyramid));
         }
     }
 
@@ -266,14 +292,113 @@ void AudioLevelsTask::run()
     }
     tasksListMutex.unlock();
 
-    if (levels.size() > 0 && !m_isCanceled) {
-        foreach (ProducerAndIndex p, m_producers) {
-            QVariantList* levelsCopy = new QVariantList(levels);
-            p.first->lock();
-            p.first->set(kAudioLevelsProperty, levelsCopy, 0, (mlt_destructor) deleteQVariantList);
-            p.first->unlock();
-            if (-1 != m_object->metaObject()->indexOfMethod("audioLevelsReady(QModelIndex)"))
-                QMetaObject::invokeMethod(m_object, "audioLevelsReady", Q_ARG(const QModelIndex&, p.second));
+    if (levels.size() > 0 && !m_isCanceled)
+        setLevels(levels, pyramid);
+}
+
+void AudioLevelsTask::splitRanges(int frameCount)
+{
+    m_ranges.clear();
+    m_nextRange = 0;
+    if (frameCount <= 0)
+        return;
+    int count = qBound(1, frameCount / kMinimumRangeFrames, 4 * QThread::idealThreadCount());
+    int size = (frameCount + count - 1) / count;
+    m_ranges.reserve(count);
+    for (int first = 0; first < frameCount; first += size) {
+        Range range;
+        range.first = first;
+        range.last = qMin(first + size, frameCount) - 1;
+        m_ranges << range;
+    }
+    // Start with the ranges nearest to the clip's in point so that the
+    // visible part of the waveform fills in first.
+    const int priority = qBound(0, m_priorityFrame, frameCount - 1);
+    std::stable_sort(m_ranges.begin(), m_ranges.end(), [=](const Range& a, const Range& b) {
+        int da = priority < a.first? a.first - priority : qMax(0, priority - a.last);
+        int db = priority < b.first? b.first - priority : qMax(0, priority - b.last);
+        return da < db;
+    });
+}
+
+void AudioLevelsTask::decodeRanges(bool isReporting)
+{
+    for (int i = m_nextRange.fetchAndAddOrdered(1); i < m_ranges.size() && !m_isCanceled;
+         i = m_nextRange.fetchAndAddOrdered(1)) {
+        decodeRange(m_ranges[i], isReporting);
+    }
+}
+
+void AudioLevelsTask::decodeRange(Range& range, bool isReporting)
+{
+    const char* key[2] = { "meta.media.audio_level.0", "meta.media.audio_level.1"};
+    // Each range needs its own producer since they are not reentrant.
+    Mlt::Producer* producer = checkOutProducer();
+    if (!producer->is_valid()) {
+        ProducerPool::singleton().checkIn(producer);
+        range.framesDone.storeRelease(range.last - range.first + 1);
+        return;
+    }
+    double fps = m_producers.first().first->get_fps();
+    char* out = m_levelsData + range.first * m_channels;
+    bool hasLevels = false;
+
+    producer->seek(range.first);
+    // for each frame
+    for (int i = range.first; i <= range.last && !m_isCanceled; i++) {
+        Mlt::Frame* frame = producer->get_frame();
+        if (frame && frame->is_valid() && !frame->get_int("test_audio")) {
+            mlt_audio_format format = mlt_audio_s16;
+            int frequency = 48000;
+            int samples = mlt_sample_calculator(fps, frequency, i);
+            int frameChannels = m_channels;
+            frame->get_audio(format, frequency, frameChannels, samples);
+            // for each channel
+            for (int channel = 0; channel < m_channels; channel++)
+                // Convert real to uint for caching as image.
+                // Scale by 0.9 because values may exceed 1.0 to indicate clipping.
+                out[channel] = char(qMin(int(256 * frame->get_double(key[channel]) * 0.9), 255));
+            hasLevels = true;
+        } else if (hasLevels) {
+            for (int channel = 0; channel < m_channels; channel++)
+                out[channel] = out[channel - m_channels];
         }
+        delete frame;
+        out += m_channels;
+        range.framesDone.storeRelease(i - range.first + 1);
+
+        // Incrementally update the audio levels every 3 seconds.
+        if (isReporting && m_updateTime.elapsed() > 3*1000 && !m_isCanceled)
+            reportProgress();
+    }
+    ProducerPool::singleton().checkIn(producer);
+    if (hasLevels)
+        m_hasAudio.storeRelease(1);
+}
+
+void AudioLevelsTask::reportProgress()
+{
+    m_updateTime.restart();
+    // Copy only the frames that are done; the rest stay silent until the next update.
+    QByteArray levels(m_levels.size(), 0);
+    // Do not copy m_ranges here; that would make the helpers detach it.
+    for (int i = 0; i < m_ranges.size(); i++) {
+        const Range& range = m_ranges.at(i);
+        int offset = range.first * m_channels;
+        int size = range.framesDone.loadAcquire() * m_channels;
+        memcpy(levels.data() + offset, m_levelsData + offset, size);
+    }
+    setLevels(levels, AudioLevels::buildPyramid(levels, m_channels));
+}
+
+void AudioLevelsTask::setLevels(const QByteArray& levels, const QVector<QByteArray>& pyramid)
+{
+    foreach (ProducerAndIndex p, m_producers) {
+        AudioLevels* levelsCopy = new AudioLevels(levels, m_channels, pyramid);
+        p.first->lock();
+        p.first->set(kAudioLevelsProperty, levelsCopy, 0, (mlt_destructor) deleteAudioLevels);
+        p.first->unlock();
+        if (-1 != m_object->metaObject()->indexOfMethod("audioLevelsReady(QModelIndex)"))
+            QMetaObject::invokeMethod(m_object, "audioLevelsReady", Q_ARG(const QModelIndex&, p.second));
     }
 }
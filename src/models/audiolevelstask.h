@@ -23,6 +23,10 @@
 #include <QRunnable>
 #include <QPersistentModelIndex>
 #include <QList>
+#include <QVector>
+#include <QByteArray>
+#include <QAtomicInt>
+#include <QElapsedTimer>
 #include <MltProducer.h>
 #include <MltProfile.h>
 
@@ -39,16 +43,37 @@ protected:
     void run();
 
 private:
+    struct Range {
+        int first;
+        int last;
+        QAtomicInt framesDone;
+    };
+
     Mlt::Producer* tempProducer();
+    void checkInTempProducer();
+    Mlt::Producer* checkOutProducer();
     QString cacheKey();
+    void splitRanges(int frameCount);
+    void decodeRanges(bool isReporting);
+    void decodeRange(Range& range, bool isReporting);
+    void reportProgress();
+    void setLevels(const QByteArray& levels, const QVector<QByteArray>& pyramid);
 
     QObject* m_object;
     typedef QPair<Mlt::Producer*, QPersistentModelIndex> ProducerAndIndex;
     QList<ProducerAndIndex> m_producers;
-    QScopedPointer<Mlt::Producer> m_tempProducer;
+    Mlt::Producer* m_tempProducer;
     bool m_isCanceled;
     bool m_isForce;
     Mlt::Profile m_profile;
+    int m_priorityFrame;
+    int m_channels;
+    QByteArray m_levels;
+    char* m_levelsData;
+    QVector<Range> m_ranges;
+    QAtomicInt m_nextRange;
+    QAtomicInt m_hasAudio;
+    QElapsedTimer m_updateTime;
 };
 
 #endif // AUDIOLEVELSTASK_H
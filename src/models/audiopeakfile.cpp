@@ -0,0 +1,181 @@
+/*
+ * Copyright (c) 2021 Meltytech, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "audiopeakfile.h"
+#include "settings.h"
+#include <QDir>
+#include <QDateTime>
+#include <QFile>
+#include <QSaveFile>
+#include <QCryptographicHash>
+#include <QtEndian>
+#include <Logger.h>
+#include <cstring>
+
+static const char* kPeakFileMagic = "SPKS";
+static const quint32 kPeakFileVersion = 1;
+// The total size of the peak files to keep.
+static const qint64 kMaxPeakFilesSize = 512 * 1024 * 1024;
+
+// All fields are little-endian.
+struct PeakFileHeader {
+    char magic[4];
+    quint32 version;
+    quint32 channels;
+    quint32 frameCount;
+    quint32 frameRateNum;
+    quint32 frameRateDen;
+    quint32 levelCount;
+    quint32 reserved;
+};
+
+// The size of every pyramid level follows from the number of frames.
+static qint64 pyramidSize(int frameCount, int levelCount)
+{
+    qint64 result = 0;
+    for (int i = 0, size = frameCount; i < levelCount; ++i, size = (size + 1) / 2)
+        result += size;
+    return result;
+}
+
+static int pyramidLevelCount(int frameCount)
+{
+    int result = (frameCount > 0)? 1 : 0;
+    for (int size = frameCount; size > 1; size = (size + 1) / 2)
+        ++result;
+    return result;
+}
+
+QString AudioPeakFile::fileName(const QString& key)
+{
+    QDir dir(Settings.appDataLocation());
+    const char* subfolder = "peaks";
+    if (!dir.cd(subfolder)) {
+        if (dir.mkdir(subfolder))
+            dir.cd(subfolder);
+    }
+    // The key may contain spaces and, without a file hash, a path.
+    QString name = QCryptographicHash::hash(key.toUtf8(), QCryptographicHash::Sha1).toHex();
+    return dir.filePath(name + ".peaks");
+}
+
+bool AudioPeakFile::read(const QString& key, int frameRateNum, int frameRateDen, AudioLevels& levels)
+{
+    QFile file(fileName(key));
+    if (!file.open(QIODevice::ReadOnly))
+        return false;
+    const qint64 fileSize = file.size();
+    if (fileSize < qint64(sizeof(PeakFileHeader)))
+        return false;
+    const uchar* data = file.map(0, fileSize);
+    if (!data)
+        return false;
+
+    PeakFileHeader header;
+    memcpy(&header, data, sizeof(header));
+    const int channels = int(qFromLittleEndian(header.channels));
+    const int frameCount = int(qFromLittleEndian(header.frameCount));
+    const int levelCount = int(qFromLittleEndian(header.levelCount));
+    if (memcmp(header.magic, kPeakFileMagic, 4)
+            || qFromLittleEndian(header.version) != kPeakFileVersion
+            || int(qFromLittleEndian(header.frameRateNum)) != frameRateNum
+            || int(qFromLittleEndian(header.frameRateDen)) != frameRateDen
+            || channels < 1 || frameCount < 0
+            || (levelCount && levelCount != pyramidLevelCount(frameCount))) {
+        file.unmap(const_cast<uchar*>(data));
+        return false;
+    }
+    const qint64 peaksSize = qint64(frameCount) * channels;
+    if (fileSize != qint64(sizeof(header)) + peaksSize + pyramidSize(frameCount, levelCount)) {
+        LOG_WARNING() << "truncated audio peak file" << file.fileName();
+        file.unmap(const_cast<uchar*>(data));
+        return false;
+    }
+
+    // Copy the sections out so the file can be replaced while the levels are in use.
+    const char* p = reinterpret_cast<const char*>(data) + sizeof(header);
+    QByteArray peaks(p, int(peaksSize));
+    p += peaksSize;
+    QVector<QByteArray> pyramid;
+    pyramid.reserve(levelCount);
+    for (int i = 0, size = frameCount; i < levelCount; ++i, size = (size + 1) / 2) {
+        pyramid << QByteArray(p, size);
+        p += size;
+    }
+    file.unmap(const_cast<uchar*>(data));
+    levels = AudioLevels(peaks, channels, pyramid);
+    file.close();
+    // Mark the file as recently used for deleteOldFiles().
+    if (file.open(QIODevice::ReadWrite))
+        file.setFileTime(QDateTime::currentDateTimeUtc(), QFileDevice::FileModificationTime);
+    return true;
+}
+
+bool AudioPeakFile::write(const QString& key, int frameRateNum, int frameRateDen, const AudioLevels& levels)
+{
+    const int channels = qMax(1, levels.channels());
+    const int frameCount = levels.size() / channels;
+    const QVector<QByteArray>& pyramid = levels.pyramid();
+    const int levelCount = (pyramid.size() == pyramidLevelCount(frameCount))? pyramid.size() : 0;
+
+    PeakFileHeader header;
+    memcpy(header.magic, kPeakFileMagic, 4);
+    header.version = qToLittleEndian(kPeakFileVersion);
+    header.channels = qToLittleEndian(quint32(channels));
+    header.frameCount = qToLittleEndian(quint32(frameCount));
+    header.frameRateNum = qToLittleEndian(quint32(frameRateNum));
+    header.frameRateDen = qToLittleEndian(quint32(frameRateDen));
+    header.levelCount = qToLittleEndian(quint32(levelCount));
+    header.reserved = 0;
+
+    // Write to a temporary file first so that readers never see a partial file.
+    QSaveFile file(fileName(key));
+    if (!file.open(QIODevice::WriteOnly)) {
+        LOG_WARNING() << "failed to write audio peak file" << file.fileName() << file.errorString();
+        return false;
+    }
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(levels.peaks().constData(), qint64(frameCount) * channels);
+    for (int i = 0; i < levelCount; ++i)
+        file.write(pyramid.at(i));
+    if (!file.commit()) {
+        LOG_WARNING() << "failed to write audio peak file" << file.fileName() << file.errorString();
+        return false;
+    }
+    return true;
+}
+
+void AudioPeakFile::deleteOldFiles()
+{
+    QDir dir(Settings.appDataLocation());
+    if (!dir.cd("peaks"))
+        return;
+    // Keep the most recently used files up to the size limit.
+    qint64 totalSize = 0;
+    int count = 0;
+    foreach (QFileInfo info, dir.entryInfoList(QStringList() << "*.peaks", QDir::Files, QDir::Time)) {
+        totalSize += info.size();
+        if (totalSize > kMaxPeakFilesSize) {
+            if (QFile::remove(info.filePath()))
+                ++count;
+            else
+                LOG_WARNING() << "failed to delete audio peak file" << info.filePath();
+        }
+    }
+    if (count)
+        LOG_INFO() << "deleted" << count << "old audio peak files";
+}
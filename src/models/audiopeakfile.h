@@ -0,0 +1,50 @@
+/*
+ * Copyright (c) 2021 Meltytech, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef AUDIOPEAKFILE_H
+#define AUDIOPEAKFILE_H
+
+#include "audiolevels.h"
+#include <QString>
+
+/*!
+  \class AudioPeakFile
+  \brief Reads and writes cached audio levels as binary peak files.
+
+  A peak file lives in the "peaks" folder of the app data directory and is
+  named after the audio levels cache key, which contains the file hash. It
+  consists of a fixed size little-endian header followed by the raw peaks
+  and, optionally, every level of the pyramid. Nothing needs decoding, so a
+  file is memory mapped and its sections copied out as they are.
+
+  A file with zero frames records media without audio so that its levels
+  are not generated again.
+
+  Reading a file updates its modification time, and deleteOldFiles() removes
+  the least recently used files once the folder exceeds its size limit.
+*/
+
+class AudioPeakFile
+{
+public:
+    static QString fileName(const QString& key);
+    static bool read(const QString& key, int frameRateNum, int frameRateDen, AudioLevels& levels);
+    static bool write(const QString& key, int frameRateNum, int frameRateDen, const AudioLevels& levels);
+    static void deleteOldFiles();
+};
+
+#endif // AUDIOPEAKFILE_H
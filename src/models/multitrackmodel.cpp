@@ -22,6 +22,7 @@
 #include "docks/playlistdock.h"
 #include "util.h"
 #include "audiolevelstask.h"
+#include "audiolevels.h"
 #include "shotcut_mlt_properties.h"
 #include "controllers/filtercontroller.h"
 #include "qmltypes/qmlmetadata.h"
@@ -46,6 +47,13 @@ MultitrackModel::MultitrackModel(QObject *parent)
 {
     connect(this, SIGNAL(modified()), SLOT(adjustBackgroundDuration()));
     connect(this, SIGNAL(modified()), SLOT(adjustTrackFilters()));
+    connect(this, SIGNAL(dataChanged(QModelIndex,QModelIndex,QVector<int>)),
+            SLOT(onDataChanged(QModelIndex,QModelIndex,QVector<int>)));
+    connect(this, SIGNAL(rowsInserted(QModelIndex,int,int)), SLOT(onRowsInserted(QModelIndex,int,int)));
+    connect(this, SIGNAL(rowsRemoved(QModelIndex,int,int)), SLOT(onRowsRemoved(QModelIndex,int,int)));
+    connect(this, SIGNAL(rowsMoved(QModelIndex,int,int,QModelIndex,int)), SLOT(clearClipIndex()));
+    connect(this, SIGNAL(modelReset()), SLOT(clearClipIndex()));
+    connect(this, SIGNAL(modified()), SLOT(invalidateClipIndex()));
     connect(this, SIGNAL(reloadRequested()), SLOT(reload()), Qt::QueuedConnection);
 }
 
@@ -88,109 +96,66 @@ QVariant MultitrackModel::data(const QModelIndex &index, int role) const
         return QVariant();
     if (index.parent().isValid()) {
         // Get data for a clip.
-        int i = m_trackList.at(index.internalId()).mlt_index;
-        QScopedPointer<Mlt::Producer> track(m_tractor->track(i));
-        if (track) {
-            Mlt::Playlist playlist(*track);
-//            LOG_DEBUG() << __FUNCTION__ << index.row();
-            QScopedPointer<Mlt::ClipInfo> info(playlist.clip_info(index.row()));
-            if (info)
-            switch (role) {
-            case NameRole: {
-                QString result;
-                if (info->producer && info->producer->is_valid()) {
-                    result = info->producer->get(kShotcutCaptionProperty);
-                    if (result.isNull()) {
-                        result = Util::baseName(ProxyManager::resource(*info->producer));
-                        if (!::qstrcmp(info->producer->get("mlt_service"), "timewarp")) {
-                            double speed = ::fabs(info->producer->get_double("warp_speed"));
-                            result = QString("%1 (%2x)").arg(result).arg(speed);
-                        }
-                    }
-                    if (result == "<producer>") {
-                        result = QString::fromUtf8(info->producer->get("mlt_service"));
-                    }
-                    if (info->producer->get_int(kIsProxyProperty)) {
-                        result.append("\n" + tr("(PROXY)"));
+        int trackIndex = index.internalId();
+        int clipIndex = index.row();
+        if (role == AudioLevelsRole) {
+            QVariant result;
+            int i = m_trackList.at(trackIndex).mlt_index;
+            QScopedPointer<Mlt::Producer> track(m_tractor->track(i));
+            if (track) {
+                Mlt::Playlist playlist(*track);
+                QScopedPointer<Mlt::Producer> clip(playlist.get_clip(clipIndex));
+                if (clip && clip->is_valid()) {
+                    Mlt::Producer producer(clip->parent());
+                    producer.lock();
+                    if (producer.get_data(kAudioLevelsProperty)) {
+                        result = QVariant::fromValue(*((AudioLevels*) producer.get_data(kAudioLevelsProperty)));
                     }
+                    producer.unlock();
                 }
-                return result;
             }
+            return result;
+        }
+        if (cacheClip(trackIndex, clipIndex)) {
+            const ClipIndex& clips = m_clipIndex.at(trackIndex);
+            switch (role) {
+            case NameRole:
+                return clips.name.at(clipIndex);
             case ResourceRole:
-            case Qt::DisplayRole: {
-                QString result = QString::fromUtf8(info->resource);
-                if (result == "<producer>" && info->producer
-                        && info->producer->is_valid() && info->producer->get("mlt_service"))
-                    result = QString::fromUtf8(info->producer->get("mlt_service"));
-                return result;
-            }
+            case Qt::DisplayRole:
+                return clips.resource.at(clipIndex);
             case ServiceRole:
-                if (info->producer && info->producer->is_valid())
-                    return QString::fromUtf8(info->producer->get("mlt_service"));
+                if (!clips.service.at(clipIndex).isNull())
+                    return clips.service.at(clipIndex);
                 break;
             case IsBlankRole:
-                return playlist.is_blank(index.row());
+                return bool(clips.flags.at(clipIndex) & ClipBlank);
             case StartRole:
-                return info->start;
+                return clips.start.at(clipIndex);
             case DurationRole:
-                return info->frame_count;
+                return clips.duration.at(clipIndex);
             case InPointRole:
-                return info->frame_in;
+                return clips.in.at(clipIndex);
             case OutPointRole:
-                return info->frame_out;
+                return clips.out.at(clipIndex);
             case FramerateRole:
-                return info->fps;
+                return clips.fps.at(clipIndex);
             case IsAudioRole:
-                return m_trackList[index.internalId()].type == AudioTrackType;
-            case AudioLevelsRole: {
-                QVariant result;
-                if (info->producer && info->producer->is_valid()) {
-                    info->producer->lock();
-                    if (info->producer->get_data(kAudioLevelsProperty)) {
-                        result = QVariant::fromValue(*((QVariantList*) info->producer->get_data(kAudioLevelsProperty)));
-                    }
-                    info->producer->unlock();
-                }
-                return result;
-            }
-            case FadeInRole: {
-                QScopedPointer<Mlt::Filter> filter(getFilter("fadeInVolume", info->producer));
-                if (!filter || !filter->is_valid())
-                    filter.reset(getFilter("fadeInBrightness", info->producer));
-                if (!filter || !filter->is_valid())
-                    filter.reset(getFilter("fadeInMovit", info->producer));
-                if (filter && filter->is_valid() && filter->get(kShotcutAnimInProperty))
-                    return filter->get_int(kShotcutAnimInProperty);
-                else
-                    return (filter && filter->is_valid())? filter->get_length() : 0;
-            }
-            case FadeOutRole: {
-                QScopedPointer<Mlt::Filter> filter(getFilter("fadeOutVolume", info->producer));
-                if (!filter || !filter->is_valid())
-                    filter.reset(getFilter("fadeOutBrightness", info->producer));
-                if (!filter || !filter->is_valid())
-                    filter.reset(getFilter("fadeOutMovit", info->producer));
-                if (filter && filter->is_valid() && filter->get(kShotcutAnimOutProperty))
-                    return filter->get_int(kShotcutAnimOutProperty);
-                else
-                    return (filter && filter->is_valid())? filter->get_length() : 0;
-            }
+                return m_trackList[trackIndex].type == AudioTrackType;
+            case FadeInRole:
+                return clips.fadeIn.at(clipIndex);
+            case FadeOutRole:
+                return clips.fadeOut.at(clipIndex);
             case IsTransitionRole:
-                return isTransition(playlist, index.row());
+                return bool(clips.flags.at(clipIndex) & ClipTransition);
             case FileHashRole:
-                return Util::getHash(*info->producer);
-            case SpeedRole: {
-                double speed = 1.0;
-                if (info->producer && info->producer->is_valid()) {
-                    if (!qstrcmp("timewarp", info->producer->get("mlt_service")))
-                        speed = info->producer->get_double("warp_speed");
-                }
-                return speed;
-            }
+                return clips.hash.at(clipIndex);
+            case SpeedRole:
+                return clips.speed.at(clipIndex);
             case IsFilteredRole:
-                return isFiltered(info->producer);
+                return bool(clips.flags.at(clipIndex) & ClipFiltered);
             case AudioIndexRole:
-                return info->producer->get("audio_index");
+                return clips.audioIndex.at(clipIndex);
             default:
                 break;
             }
@@ -2125,6 +2090,224 @@ void MultitrackModel::onFilterChanged(Mlt::Filter* filter)
     }
 }
 
+void MultitrackModel::onDataChanged(const QModelIndex& topLeft, const QModelIndex&, const QVector<int>& roles)
+{
+    // Audio levels do not move any clips.
+    if (roles.size() == 1 && roles.first() == AudioLevelsRole)
+        return;
+
+    // A change in duration moves the start of all following clips.
+    if (topLeft.isValid() && topLeft.parent().isValid()) {
+        int trackIndex = topLeft.internalId();
+        if (trackIndex < m_clipIndex.size())
+            m_clipIndex[trackIndex].invalidateFrom(topLeft.row());
+    }
+}
+
+void MultitrackModel::onRowsInserted(const QModelIndex& parent, int first, int last)
+{
+    if (!parent.isValid()) {
+        clearClipIndex();
+    } else if (parent.row() < m_clipIndex.size()) {
+        ClipIndex& clips = m_clipIndex[parent.row()];
+        if (first <= clips.size()) {
+            clips.insert(first, last - first + 1);
+            clips.invalidateFrom(first);
+        } else {
+            clips.resize(0);
+        }
+    }
+}
+
+void MultitrackModel::onRowsRemoved(const QModelIndex& parent, int first, int last)
+{
+    if (!parent.isValid()) {
+        clearClipIndex();
+    } else if (parent.row() < m_clipIndex.size()) {
+        ClipIndex& clips = m_clipIndex[parent.row()];
+        if (last < clips.size()) {
+            clips.remove(first, last - first + 1);
+            clips.invalidateFrom(first);
+        } else {
+            clips.resize(0);
+        }
+    }
+}
+
+void MultitrackModel::invalidateClipIndex()
+{
+    for (auto& clips : m_clipIndex)
+        clips.invalidateFrom(0);
+}
+
+void MultitrackModel::clearClipIndex()
+{
+    m_clipIndex.clear();
+}
+
+bool MultitrackModel::cacheClip(int trackIndex, int clipIndex) const
+{
+    if (!m_tractor || trackIndex < 0 || trackIndex >= m_trackList.size() || clipIndex < 0)
+        return false;
+    if (m_clipIndex.size() != m_trackList.size())
+        m_clipIndex.resize(m_trackList.size());
+    ClipIndex& clips = m_clipIndex[trackIndex];
+    if (clipIndex < clips.size() && (clips.flags.at(clipIndex) & ClipCached))
+        return true;
+
+    int i = m_trackList.at(trackIndex).mlt_index;
+    QScopedPointer<Mlt::Producer> track(m_tractor->track(i));
+    if (!track)
+        return false;
+    Mlt::Playlist playlist(*track);
+    int n = playlist.count();
+    if (clipIndex >= n)
+        return false;
+    if (clips.size() != n) {
+        // Out of sync with the playlist; start over for this track.
+        clips.resize(0);
+        clips.resize(n);
+    }
+    QScopedPointer<Mlt::ClipInfo> info(playlist.clip_info(clipIndex));
+    if (!info)
+        return false;
+
+    QString name;
+    QString service;
+    QString hash;
+    QString audioIndex;
+    double speed = 1.0;
+    int fadeIn = 0;
+    int fadeOut = 0;
+    quint8 flags = ClipCached;
+    if (playlist.is_blank(clipIndex))
+        flags |= ClipBlank;
+    if (isTransition(playlist, clipIndex))
+        flags |= ClipTransition;
+    if (info->producer && info->producer->is_valid()) {
+        service = QString::fromUtf8(info->producer->get("mlt_service"));
+        name = info->producer->get(kShotcutCaptionProperty);
+        if (name.isNull()) {
+            name = Util::baseName(ProxyManager::resource(*info->producer));
+            if (service == "timewarp") {
+                double warpSpeed = ::fabs(info->producer->get_double("warp_speed"));
+                name = QString("%1 (%2x)").arg(name).arg(warpSpeed);
+            }
+        }
+        if (name == "<producer>") {
+            name = service;
+        }
+        if (info->producer->get_int(kIsProxyProperty)) {
+            name.append("\n" + tr("(PROXY)"));
+        }
+        if (service == "timewarp")
+            speed = info->producer->get_double("warp_speed");
+        hash = Util::getHash(*info->producer);
+        audioIndex = QString::fromUtf8(info->producer->get("audio_index"));
+        if (isFiltered(info->producer))
+            flags |= ClipFiltered;
+
+        QScopedPointer<Mlt::Filter> filter(getFilter("fadeInVolume", info->producer));
+        if (!filter || !filter->is_valid())
+            filter.reset(getFilter("fadeInBrightness", info->producer));
+        if (!filter || !filter->is_valid())
+            filter.reset(getFilter("fadeInMovit", info->producer));
+        if (filter && filter->is_valid() && filter->get(kShotcutAnimInProperty))
+            fadeIn = filter->get_int(kShotcutAnimInProperty);
+        else
+            fadeIn = (filter && filter->is_valid())? filter->get_length() : 0;
+
+        filter.reset(getFilter("fadeOutVolume", info->producer));
+        if (!filter || !filter->is_valid())
+            filter.reset(getFilter("fadeOutBrightness", info->producer));
+        if (!filter || !filter->is_valid())
+            filter.reset(getFilter("fadeOutMovit", info->producer));
+        if (filter && filter->is_valid() && filter->get(kShotcutAnimOutProperty))
+            fadeOut = filter->get_int(kShotcutAnimOutProperty);
+        else
+            fadeOut = (filter && filter->is_valid())? filter->get_length() : 0;
+    }
+    QString resource = QString::fromUtf8(info->resource);
+    if (resource == "<producer>" && !service.isEmpty())
+        resource = service;
+
+    clips.flags[clipIndex] = flags;
+    clips.start[clipIndex] = info->start;
+    clips.duration[clipIndex] = info->frame_count;
+    clips.in[clipIndex] = info->frame_in;
+    clips.out[clipIndex] = info->frame_out;
+    clips.fadeIn[clipIndex] = fadeIn;
+    clips.fadeOut[clipIndex] = fadeOut;
+    clips.fps[clipIndex] = info->fps;
+    clips.speed[clipIndex] = speed;
+    clips.name[clipIndex] = name;
+    clips.resource[clipIndex] = resource;
+    clips.service[clipIndex] = service;
+    clips.hash[clipIndex] = hash;
+    clips.audioIndex[clipIndex] = audioIndex;
+    return true;
+}
+
+void MultitrackModel::ClipIndex::resize(int count)
+{
+    flags.resize(count);
+    start.resize(count);
+    duration.resize(count);
+    in.resize(count);
+    out.resize(count);
+    fadeIn.resize(count);
+    fadeOut.resize(count);
+    fps.resize(count);
+    speed.resize(count);
+    name.resize(count);
+    resource.resize(count);
+    service.resize(count);
+    hash.resize(count);
+    audioIndex.resize(count);
+}
+
+void MultitrackModel::ClipIndex::insert(int row, int count)
+{
+    flags.insert(row, count, 0);
+    start.insert(row, count, 0);
+    duration.insert(row, count, 0);
+    in.insert(row, count, 0);
+    out.insert(row, count, 0);
+    fadeIn.insert(row, count, 0);
+    fadeOut.insert(row, count, 0);
+    fps.insert(row, count, 0.0);
+    speed.insert(row, count, 1.0);
+    name.insert(row, count, QString());
+    resource.insert(row, count, QString());
+    service.insert(row, count, QString());
+    hash.insert(row, count, QString());
+    audioIndex.insert(row, count, QString());
+}
+
+void MultitrackModel::ClipIndex::remove(int row, int count)
+{
+    flags.remove(row, count);
+    start.remove(row, count);
+    duration.remove(row, count);
+    in.remove(row, count);
+    out.remove(row, count);
+    fadeIn.remove(row, count);
+    fadeOut.remove(row, count);
+    fps.remove(row, count);
+    speed.remove(row, count);
+    name.remove(row, count);
+    resource.remove(row, count);
+    service.remove(row, count);
+    hash.remove(row, count);
+    audioIndex.remove(row, count);
+}
+
+void MultitrackModel::ClipIndex::invalidateFrom(int row)
+{
+    for (int i = qMax(0, row); i < flags.size(); ++i)
+        flags[i] &= ~ClipCached;
+}
+
 void MultitrackModel::moveClipToEnd(Mlt::Playlist& playlist, int trackIndex, int clipIndex, int position, bool ripple, bool rippleAllTracks)
 {
     int n = playlist.count();
@@ -3177,6 +3360,7 @@ int MultitrackModel::clipIndex(int trackIndex, int position)
 
 void MultitrackModel::refreshTrackList()
 {
+    clearClipIndex();
     int n = m_tractor->count();
     int a = 0;
     int v = 0;
@@ -21,6 +21,7 @@
 #include <QAbstractItemModel>
 #include <QList>
 #include <QString>
+#include <QVector>
 #include <MltTractor.h>
 #include <MltPlaylist.h>
 
@@ -172,9 +173,42 @@ public slots:
     void replace(int trackIndex, int clipIndex, Mlt::Producer& clip, bool copyFilters = true);
 
 private:
+    enum ClipFlags {
+        ClipCached = 0x1,
+        ClipBlank = 0x2,
+        ClipTransition = 0x4,
+        ClipFiltered = 0x8
+    };
+
+    /// Per-track cache of the clip roles stored column-wise, so that data()
+    /// does not need to query MLT for every role of every clip.
+    struct ClipIndex {
+        QVector<quint8> flags;
+        QVector<int> start;
+        QVector<int> duration;
+        QVector<int> in;
+        QVector<int> out;
+        QVector<int> fadeIn;
+        QVector<int> fadeOut;
+        QVector<double> fps;
+        QVector<double> speed;
+        QVector<QString> name;
+        QVector<QString> resource;
+        QVector<QString> service;
+        QVector<QString> hash;
+        QVector<QString> audioIndex;
+
+        int size() const { return flags.size(); }
+        void resize(int count);
+        void insert(int row, int count);
+        void remove(int row, int count);
+        void invalidateFrom(int row);
+    };
+
     Mlt::Tractor* m_tractor;
     TrackList m_trackList;
     bool m_isMakingTransition;
+    mutable QVector<ClipIndex> m_clipIndex;
 
     void moveClipToEnd(Mlt::Playlist& playlist, int trackIndex, int clipIndex, int position, bool ripple, bool rippleAllTracks);
     void moveClipInBlank(Mlt::Playlist& playlist, int trackIndex, int clipIndex, int position, bool ripple, bool rippleAllTracks, int duration = 0);
@@ -195,12 +229,18 @@ private:
     int getDuration();
     void adjustServiceFilterDurations(Mlt::Service& service, int duration);
     bool warnIfInvalid(Mlt::Service& service);
+    bool cacheClip(int trackIndex, int clipIndex) const;
 
     friend class UndoHelper;
 
 private slots:
     void adjustBackgroundDuration();
     void adjustTrackFilters();
+    void onDataChanged(const QModelIndex& topLeft, const QModelIndex& bottomRight, const QVector<int>& roles);
+    void onRowsInserted(const QModelIndex& parent, int first, int last);
+    void onRowsRemoved(const QModelIndex& parent, int first, int last);
+    void invalidateClipIndex();
+    void clearClipIndex();
 };
 
 #endif // MULTITRACKMODEL_H
@@ -35,6 +35,7 @@
 #include "database.h"
 #include "mainwindow.h"
 #include "proxymanager.h"
+#include "producerpool.h"
 
 static void deleteQImage(QImage* image)
 {
@@ -67,26 +68,17 @@ public:
 
     ~UpdateThumbnailTask()
     {
-        delete m_tempProducer;
+        ProducerPool::singleton().checkIn(m_tempProducer);
     }
 
     Mlt::Producer* tempProducer()
     {
         if (!m_tempProducer) {
-            QString service = m_producer.get("mlt_service");
-            if (service == "avformat-novalidate")
-                service = "avformat";
-            else if (service.startsWith("xml"))
-                service = "xml-nogl";
-            m_tempProducer = new Mlt::Producer(m_profile, service.toUtf8().constData(), m_producer.get("resource"));
-            if (m_tempProducer->is_valid()) {
-                Mlt::Filter scaler(m_profile, "swscale");
-                Mlt::Filter padder(m_profile, "resize");
-                Mlt::Filter converter(m_profile, "avcolor_space");
-                m_tempProducer->attach(scaler);
-                m_tempProducer->attach(padder);
-                m_tempProducer->attach(converter);
-            }
+            QString resource = QString::fromUtf8(m_producer.get("resource"));
+            if (m_force)
+                ProducerPool::singleton().evict(resource);
+            m_tempProducer = ProducerPool::singleton().checkOut("atsc_720p_60", m_producer.get("mlt_service"),
+                resource, ProducerPool::Thumbnail);
         }
         return m_tempProducer;
     }
@@ -637,7 +629,7 @@ void PlaylistModel::append(Mlt::Producer& producer, bool emitModified)
     int in = producer.get_in();
     int out = producer.get_out();
     producer.set_in_and_out(0, producer.get_length() - 1);
-    QThreadPool::globalInstance()->start(
+    MLT.backgroundThreadPool().start(
         new UpdateThumbnailTask(this, producer, in, out, count), 1);
     beginInsertRows(QModelIndex(), count, count);
     m_playlist->append(producer, in, out);
@@ -652,7 +644,7 @@ void PlaylistModel::insert(Mlt::Producer& producer, int row)
     int in = producer.get_in();
     int out = producer.get_out();
     producer.set_in_and_out(0, producer.get_length() - 1);
-    QThreadPool::globalInstance()->start(
+    MLT.backgroundThreadPool().start(
         new UpdateThumbnailTask(this, producer, in, out, row), 1);
     beginInsertRows(QModelIndex(), row, row);
     m_playlist->insert(producer, row, in, out);
@@ -678,7 +670,7 @@ void PlaylistModel::update(int row, Mlt::Producer& producer, bool copyFilters)
     int in = producer.get_in();
     int out = producer.get_out();
     producer.set_in_and_out(0, producer.get_length() - 1);
-    QThreadPool::globalInstance()->start(
+    MLT.backgroundThreadPool().start(
         new UpdateThumbnailTask(this, producer, in, out, row), 1);
     if (copyFilters) {
         Mlt::Producer oldClip(m_playlist->get_clip(row));
@@ -697,7 +689,7 @@ void PlaylistModel::updateThumbnails(int row)
     if (!m_playlist) return;
     QScopedPointer<Mlt::ClipInfo> info(m_playlist->clip_info(row));
     if (!info || !info->producer->is_valid()) return;
-    QThreadPool::globalInstance()->start(
+    MLT.backgroundThreadPool().start(
         new UpdateThumbnailTask(this, *info->producer, info->frame_in, info->frame_out, row, true /* force */), 1);
 }
 
@@ -759,7 +751,7 @@ void PlaylistModel::refreshThumbnails()
         for (int i = 0; i < m_playlist->count(); i++) {
             Mlt::ClipInfo* info = m_playlist->clip_info(i);
             if (info && info->producer && info->producer->is_valid()) {
-                QThreadPool::globalInstance()->start(
+                MLT.backgroundThreadPool().start(
                     new UpdateThumbnailTask(this, *info->producer, info->frame_in, info->frame_out, i), 1);
             }
             delete info;
@@ -807,7 +799,7 @@ void PlaylistModel::setInOut(int row, int in, int out)
             outChanged = info->frame_out != out;
         }
         m_playlist->resize_clip(row, in, out);
-        QThreadPool::globalInstance()->start(
+        MLT.backgroundThreadPool().start(
             new UpdateThumbnailTask(this, *info->producer, in, out, row), 1);
         emit dataChanged(createIndex(row, COLUMN_IN), createIndex(row, COLUMN_START));
         emit modified();
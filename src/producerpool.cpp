@@ -0,0 +1,159 @@
+/*
+ * Copyright (c) 2021 Meltytech, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "producerpool.h"
+#include <Logger.h>
+#include <Mlt.h>
+#include <QMutexLocker>
+
+// The avformat producers also close their files when they drop out of the
+// MLT cache for avformat, see Controller::updateAvformatCaching().
+static const int kMaxIdleProducers = 8;
+
+ProducerPool& ProducerPool::singleton()
+{
+    static ProducerPool* instance = new ProducerPool;
+    return *instance;
+}
+
+ProducerPool::ProducerPool()
+    : m_mutex(QMutex::NonRecursive)
+{
+}
+
+Mlt::Producer* ProducerPool::checkOut(const QString& profileName, QString service, const QString& resource,
+                                      Purpose purpose, const QString& audioIndex, const QString& videoIndex)
+{
+    if (service == "avformat-novalidate")
+        service = "avformat";
+    else if (service.startsWith("xml"))
+        service = "xml-nogl";
+    QString key = QString("%1 %2 %3 %4 %5 %6").arg(purpose).arg(profileName).arg(service)
+            .arg(audioIndex).arg(videoIndex).arg(resource);
+
+    m_mutex.lock();
+    for (int i = 0; i < m_entries.size(); i++) {
+        Entry* entry = m_entries[i];
+        if (!entry->isCheckedOut && entry->key == key) {
+            entry->isCheckedOut = true;
+            m_entries.move(i, 0);
+            m_mutex.unlock();
+            return entry->producer;
+        }
+    }
+    m_mutex.unlock();
+
+    // Opening the media takes a while; do not keep the others waiting.
+    Entry* entry = new Entry;
+    entry->key = key;
+    entry->resource = resource;
+    entry->isCheckedOut = true;
+    entry->profile = profileName.isEmpty()? new Mlt::Profile : new Mlt::Profile(profileName.toLatin1().constData());
+    Mlt::Profile& profile = *entry->profile;
+    entry->producer = new Mlt::Producer(profile, service.toUtf8().constData(), resource.toUtf8().constData());
+    Mlt::Producer* producer = entry->producer;
+    if (producer->is_valid()) {
+        if (!audioIndex.isEmpty())
+            producer->set("audio_index", audioIndex.toUtf8().constData());
+        if (!videoIndex.isEmpty())
+            producer->set("video_index", videoIndex.toUtf8().constData());
+        if (purpose == Thumbnail) {
+            Mlt::Filter scaler(profile, "swscale");
+            Mlt::Filter padder(profile, "resize");
+            Mlt::Filter converter(profile, "avcolor_space");
+            producer->attach(scaler);
+            producer->attach(padder);
+            producer->attach(converter);
+        } else {
+            Mlt::Filter channels(profile, "audiochannels");
+            Mlt::Filter converter(profile, "audioconvert");
+            Mlt::Filter levels(profile, "audiolevel");
+            producer->attach(channels);
+            producer->attach(converter);
+            producer->attach(levels);
+            producer->set("video_index", -1);
+        }
+    }
+    QMutexLocker locker(&m_mutex);
+    m_entries.prepend(entry);
+    return producer;
+}
+
+void ProducerPool::checkIn(Mlt::Producer* producer)
+{
+    if (!producer)
+        return;
+    QMutexLocker locker(&m_mutex);
+    for (int i = 0; i < m_entries.size(); i++) {
+        Entry* entry = m_entries[i];
+        if (entry->producer == producer) {
+            if (producer->is_valid()) {
+                entry->isCheckedOut = false;
+                m_entries.move(i, 0);
+            } else {
+                // Try again the next time; the file may be there by then.
+                m_entries.removeAt(i);
+                deleteEntry(entry);
+            }
+            trim(kMaxIdleProducers);
+            return;
+        }
+    }
+    LOG_WARNING() << "producer is not from the pool" << producer->get("resource");
+}
+
+void ProducerPool::evict(const QString& resource)
+{
+    QMutexLocker locker(&m_mutex);
+    for (int i = m_entries.size() - 1; i >= 0; i--) {
+        Entry* entry = m_entries[i];
+        if (!entry->isCheckedOut && entry->resource == resource) {
+            m_entries.removeAt(i);
+            deleteEntry(entry);
+        }
+    }
+}
+
+void ProducerPool::clear()
+{
+    QMutexLocker locker(&m_mutex);
+    trim(0);
+}
+
+// Closes the least recently used producers that are not checked out until
+// at most \a maxIdleCount remain.
+void ProducerPool::trim(int maxIdleCount)
+{
+    int idleCount = 0;
+    for (int i = 0; i < m_entries.size(); ) {
+        Entry* entry = m_entries[i];
+        if (!entry->isCheckedOut && ++idleCount > maxIdleCount) {
+            m_entries.removeAt(i);
+            deleteEntry(entry);
+        } else {
+            ++i;
+        }
+    }
+}
+
+void ProducerPool::deleteEntry(Entry* entry)
+{
+    // The producer uses the profile.
+    delete entry->producer;
+    delete entry->profile;
+    delete entry;
+}
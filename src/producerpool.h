@@ -0,0 +1,90 @@
+/*
+ * Copyright (c) 2021 Meltytech, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PRODUCERPOOL_H
+#define PRODUCERPOOL_H
+
+#include <QList>
+#include <QMutex>
+#include <QString>
+
+namespace Mlt {
+    class Producer;
+    class Profile;
+}
+
+/*!
+  \class ProducerPool
+  \brief The ProducerPool keeps the producers that make thumbnails and audio
+  levels open for the next request for the same media.
+
+  \threadsafe
+
+  A producer is checked out for the exclusive use of one thread and checked
+  in when that is done. It is keyed by the service, the resource, the audio
+  and video index and the name of its profile, and it already has the
+  filters for its Purpose attached. Each producer has a profile of its own
+  because a producer may change a profile that is not explicit to match its
+  media. The producers that are not checked out are closed, least recently
+  used first, when there are more than a few of them.
+*/
+
+class ProducerPool
+{
+public:
+    enum Purpose {
+        Thumbnail,  //!< scales and converts the images
+        AudioLevels //!< computes the audio levels and decodes no video
+    };
+
+    static ProducerPool& singleton();
+
+    /*!
+      Returns a producer of the \a service for the \a resource with a new
+      profile of \a profileName, or the default profile if it is empty. The
+      \a audioIndex and \a videoIndex are set unless they are empty. The
+      producer may be invalid and must be given back with checkIn().
+    */
+    Mlt::Producer* checkOut(const QString& profileName, QString service, const QString& resource,
+                            Purpose purpose, const QString& audioIndex = QString(),
+                            const QString& videoIndex = QString());
+    //! Gives back a \a producer from checkOut() for the next request.
+    void checkIn(Mlt::Producer* producer);
+    //! Closes the producers for \a resource that are not checked out.
+    void evict(const QString& resource);
+    //! Closes all of the producers that are not checked out.
+    void clear();
+
+private:
+    struct Entry {
+        QString key;
+        QString resource;
+        Mlt::Profile* profile;
+        Mlt::Producer* producer;
+        bool isCheckedOut;
+    };
+
+    ProducerPool();
+    void trim(int maxIdleCount);
+    static void deleteEntry(Entry* entry);
+
+    QMutex m_mutex;
+    // Most recently used first
+    QList<Entry*> m_entries;
+};
+
+#endif // PRODUCERPOOL_H
@@ -21,10 +21,12 @@
 #include "shotcut_mlt_properties.h"
 #include "jobqueue.h"
 #include "jobs/ffmpegjob.h"
+#include "jobs/proxybatchjob.h"
 #include "jobs/qimagejob.h"
 #include "util.h"
 
 #include <QObject>
+#include <QHash>
 #include <QVector>
 #include <QXmlStreamReader>
 #include <QXmlStreamWriter>
@@ -32,6 +34,8 @@
 #include <QImageReader>
 #include <Logger.h>
 #include <utime.h>
+#include <algorithm>
+#include <climits>
 
 static const char* kProxySubfolder = "proxies";
 static const char* kProxyVideoExtension = ".mp4";
@@ -50,6 +54,9 @@ static const QStringList kPixFmtsWithAlpha = {"pal8", "argb", "rgba", "abgr",
     "gbrap12le", "gbrap12be", "gbrap10le", "gbrap10be", "gbrapf32be",
     "gbrapf32le", "yuva422p12be", "yuva422p12le", "yuva444p12be", "yuva444p12le"};
 
+// While generateIfNotExistsAll() runs, the video proxies go into this batch.
+static ProxyBatchJob* s_batch = nullptr;
+
 QDir ProxyManager::dir()
 {
     // Use project folder + "/proxies" if using project folder and enabled
@@ -95,6 +102,8 @@ void ProxyManager::generateVideoProxy(Mlt::Producer& producer, bool fullRange, S
     file.close();
 
     args << "-loglevel" << "verbose";
+    if (s_batch)
+        args << "-threads" << QString::number(s_batch->threadCount());
     args << "-i" << resource;
     args << "-max_muxing_queue_size" << "9999";
     // transcode all streams except data, subtitles, and attachments
@@ -207,8 +216,21 @@ void ProxyManager::generateVideoProxy(Mlt::Producer& producer, bool fullRange, S
         args << "-crf" << "23";
     }
     args << "-g" << "1" << "-bf" << "0";
+    if (s_batch)
+        args << "-threads" << QString::number(s_batch->threadCount());
     args << "-y" << fileName;
 
+    if (s_batch) {
+        PostJobAction* action;
+        if (replace)
+            action = new ProxyReplacePostJobAction(resource, fileName, hash);
+        else
+            action = new ProxyFinalizePostJobAction(fileName);
+        double seconds = producer.parent().get_length() / MLT.profile().fps();
+        s_batch->addProxy(fileName, args, seconds, action);
+        return;
+    }
+
     FfmpegJob* job = new FfmpegJob(fileName, args, true);
     job->setLabel(QObject::tr("Make proxy for %1").arg(Util::baseName(resource)));
     if (replace) {
@@ -560,12 +582,88 @@ public:
     int on_end_transition(Mlt::Transition*) { return 0; }
 };
 
-void ProxyManager::generateIfNotExistsAll(Mlt::Producer& producer)
+struct ProxyUsage {
+    ProxyUsage() : distance(INT_MAX), count(0) {}
+    int distance; //!< frames from the position to the nearest use in a timeline
+    int count;    //!< the number of times a clip uses the resource
+};
+
+// Counts how often each resource is used and how close the timeline uses it
+// to the \a position, or to its start if that is negative.
+static void findProxyUsage(Mlt::Producer& producer, int position, QHash<QString, ProxyUsage>& usage,
+                           bool isTrack = false)
+{
+    if (producer.type() == mlt_service_tractor_type) {
+        Mlt::Tractor tractor(producer);
+        for (int i = 0; i < tractor.count(); i++) {
+            QScopedPointer<Mlt::Producer> track(tractor.track(i));
+            if (track && track->is_valid())
+                findProxyUsage(*track, position, usage, true);
+        }
+    } else if (producer.type() == mlt_service_playlist_type) {
+        Mlt::Playlist playlist(producer);
+        for (int i = 0; i < playlist.count(); i++) {
+            QScopedPointer<Mlt::ClipInfo> info(playlist.clip_info(i));
+            if (!info || !info->producer || !info->producer->is_valid() || playlist.is_blank(i))
+                continue;
+            ProxyUsage& item = usage[ProxyManager::resource(*info->producer)];
+            ++item.count;
+            // Only the tracks of a timeline have positions.
+            if (isTrack) {
+                int start = info->start;
+                int end = info->start + info->frame_count - 1;
+                int distance = start;
+                if (position >= 0)
+                    distance = (position < start)? start - position : (position > end)? position - end : 0;
+                item.distance = qMin(item.distance, distance);
+            }
+        }
+    }
+}
+
+void ProxyManager::generateIfNotExistsAll(const QList<Mlt::Producer>& producers, int position)
 {
-    FindNonProxyProducersParser parser;
-    parser.start(producer);
-    for (auto& clip : parser.producers()) {
-        generateIfNotExists(clip, false /* replace */);
+    QList<Mlt::Producer> clips;
+    QHash<QString, ProxyUsage> usage;
+    foreach (Mlt::Producer producer, producers) {
+        if (!producer.is_valid())
+            continue;
+        FindNonProxyProducersParser parser;
+        parser.start(producer);
+        clips << parser.producers();
+        findProxyUsage(producer, position, usage);
+    }
+    // Make the proxies of the clips around the position first, then those
+    // used most.
+    QVector<ProxyUsage> clipUsage;
+    QVector<int> order;
+    for (int i = 0; i < clips.size(); i++) {
+        clipUsage << usage.value(ProxyManager::resource(clips[i].parent()));
+        order << i;
+    }
+    std::stable_sort(order.begin(), order.end(), [&](int a, int b) {
+        const ProxyUsage& x = clipUsage[a];
+        const ProxyUsage& y = clipUsage[b];
+        return (x.distance != y.distance)? x.distance < y.distance : x.count > y.count;
+    });
+
+    int workerCount = qMax(1, Settings.proxyWorkers());
+    // Hardware encoders allow only a few sessions at a time, so more workers
+    // would only make proxies fail.
+    if (Settings.proxyUseHardware() && !Settings.encodeHardware().isEmpty())
+        workerCount = 1;
+    int threadCount = qMax(1, Settings.jobsCpuBudget() / workerCount);
+    s_batch = new ProxyBatchJob(ProxyManager::dir().path(), workerCount, threadCount);
+    for (int i : order) {
+        generateIfNotExists(clips[i], false /* replace */);
+    }
+    ProxyBatchJob* batch = s_batch;
+    s_batch = nullptr;
+    if (batch->count() > 0) {
+        batch->setLabel(QObject::tr("Make %n proxies", nullptr, batch->count()));
+        JOBS.add(batch);
+    } else {
+        delete batch;
     }
 }
 
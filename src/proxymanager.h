@@ -19,6 +19,7 @@
 #define PROXYMANAGER_H
 
 #include <QDir>
+#include <QList>
 #include <QString>
 #include <QPoint>
 
@@ -56,7 +57,7 @@ public:
     static const char* imageFilenameExtension();
     static const char* pendingImageExtension();
     static int resolution();
-    static void generateIfNotExistsAll(Mlt::Producer& producer);
+    static void generateIfNotExistsAll(const QList<Mlt::Producer>& producers, int position = -1);
     static bool removePending();
 };
 
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2013-2020 Meltytech, LLC
+ * Copyright (c) 2013-2021 Meltytech, LLC
  *
  * This program is free software: you can redistribute it and/or modify
  * it under the terms of the GNU General Public License as published by
@@ -35,6 +35,7 @@ Rectangle {
     property int fadeOut: 0
     property int trackIndex
     property int originalTrackIndex: trackIndex
+    readonly property int clipIndex: index
     property int originalClipIndex: index
     property int originalX: x
     property bool selected: false
@@ -42,6 +43,23 @@ Rectangle {
     property double speed: 1.0
     property string audioIndex: ''
     property bool isTrackMute: false
+    property string thumbnailSuffix: ''
+    readonly property real thumbnailWidth: (height / 2 - border.width) * 16.0/9.0
+    // Clips that are wide enough show a filmstrip of thumbnails instead of the
+    // in and out frames. The count is a power of two, up to the 32 of the
+    // filmstrip provider, so that zooming only sometimes needs a new strip.
+    readonly property int filmstripCount: {
+        var n = Math.min(32, Math.floor((width - 2 * border.width) / thumbnailWidth))
+        if (n < 4)
+            return 0
+        var count = 4
+        while (count * 2 <= n)
+            count *= 2
+        return count
+    }
+    readonly property bool showWaveform: !isBlank && settings.timelineShowWaveforms && (parseInt(audioIndex) > -1 || audioIndex === 'all')
+    readonly property real waveformHeight: (isAudio || height <= 20)? height : height / 2
+    readonly property real waveformOpacity: isTrackMute ? 0.2 : 0.7
 
     signal clicked(var clip, var mouse)
     signal moved(var clip)
@@ -86,49 +104,96 @@ Rectangle {
     }
 
     function generateWaveform(force) {
-        if (!waveform.visible && !force) return
-        // This is needed to make the model have the correct count.
-        // Model as a property expression is not working in all cases.
-        waveformRepeater.model = Math.ceil(waveform.innerWidth / waveform.maxWidth)
-        for (var i = 0; i < waveformRepeater.count; i++)
-            waveformRepeater.itemAt(0).update()
+        if (!showWaveform && !force) return
+        if (waveformLoader.item)
+            waveformLoader.item.generate()
     }
 
     function imagePath(time) {
         if (isAudio || isBlank || isTransition) {
             return ''
         } else {
-            return 'image://thumbnail/' + hash + '/' + mltService + '/' + clipResource + '#' + time
+            return 'image://thumbnail/' + hash + '/' + mltService + '/' + clipResource + '#' + time + thumbnailSuffix
         }
     }
 
+    function filmstripPath(count) {
+        return 'image://filmstrip/' + hash + '/' + mltService + '/' + clipResource + '#' + inPoint + ':' + outPoint + ':' + count + thumbnailSuffix
+    }
+
+    function showMenu() {
+        menuLoader.active = true
+        menuLoader.item.menu.show()
+    }
+
     onAudioLevelsChanged: generateWaveform(false)
 
-    Image {
-        id: outThumbnail
-        visible: !isBlank && settings.timelineShowThumbnails && parent.height > 20 && x > inThumbnail.width
-        anchors.right: parent.right
-        anchors.top: parent.top
-        anchors.topMargin: parent.border.width
-        anchors.rightMargin: parent.border.width + 1
-        anchors.bottom: parent.bottom
-        anchors.bottomMargin: parent.height / 2
-        width: height * 16.0/9.0
-        fillMode: Image.PreserveAspectFit
-        source: imagePath(outPoint)
+    Loader {
+        id: thumbnailsLoader
+        active: !isBlank && !isAudio && !isTransition && settings.timelineShowThumbnails && clipRoot.height > 20
+        anchors.fill: parent
+        sourceComponent: filmstripCount > 0? filmstripComponent : inOutComponent
     }
 
-    Image {
-        id: inThumbnail
-        visible: !isBlank && settings.timelineShowThumbnails && parent.height > 20
-        anchors.left: parent.left
-        anchors.top: parent.top
-        anchors.topMargin: parent.border.width
-        anchors.bottom: parent.bottom
-        anchors.bottomMargin: parent.height / 2
-        width: height * 16.0/9.0
-        fillMode: Image.PreserveAspectFit
-        source: imagePath(inPoint)
+    Component {
+        id: inOutComponent
+        Item {
+            Image {
+                id: outThumbnail
+                visible: x > inThumbnail.width
+                anchors.right: parent.right
+                anchors.top: parent.top
+                anchors.topMargin: clipRoot.border.width
+                anchors.rightMargin: clipRoot.border.width + 1
+                anchors.bottom: parent.bottom
+                anchors.bottomMargin: parent.height / 2
+                width: height * 16.0/9.0
+                fillMode: Image.PreserveAspectFit
+                source: imagePath(outPoint)
+            }
+
+            Image {
+                id: inThumbnail
+                anchors.left: parent.left
+                anchors.top: parent.top
+                anchors.topMargin: clipRoot.border.width
+                anchors.bottom: parent.bottom
+                anchors.bottomMargin: parent.height / 2
+                width: height * 16.0/9.0
+                fillMode: Image.PreserveAspectFit
+                source: imagePath(inPoint)
+            }
+        }
+    }
+
+    Component {
+        id: filmstripComponent
+        Item {
+            id: filmstrip
+            readonly property int count: filmstripCount
+            readonly property real cellWidth: (width - 2 * clipRoot.border.width) / count
+            readonly property string source: filmstripPath(count)
+
+            // Every cell shows its part of the same strip image, which is
+            // requested and stored once.
+            Repeater {
+                model: filmstrip.count
+                Item {
+                    x: clipRoot.border.width + index * filmstrip.cellWidth
+                    y: clipRoot.border.width
+                    width: Math.min(thumbnailWidth, filmstrip.cellWidth)
+                    height: filmstrip.height / 2 - clipRoot.border.width
+                    clip: true
+                    Image {
+                        x: -index * thumbnailWidth
+                        width: filmstrip.count * thumbnailWidth
+                        height: parent.height
+                        fillMode: Image.Stretch
+                        source: filmstrip.source
+                    }
+                }
+            }
+        }
     }
 
     Shotcut.TimelineTransition {
@@ -139,47 +204,60 @@ Rectangle {
         colorB: clipRoot.selected ? Qt.darker(color) : Qt.lighter(color)
     }
 
-    Row {
-        id: waveform
-        visible: !isBlank && settings.timelineShowWaveforms && (parseInt(audioIndex) > -1 || audioIndex === 'all')
-        height: (isAudio || parent.height <= 20)? parent.height : parent.height / 2
+    Loader {
+        id: waveformLoader
+        active: showWaveform
         anchors.left: parent.left
         anchors.bottom: parent.bottom
         anchors.margins: parent.border.width
-        opacity: isTrackMute ? 0.2 : 0.7
-        property int maxWidth: Math.max(application.maxTextureSize / 2, 2048)
-        property int innerWidth: clipRoot.width - clipRoot.border.width * 2
-
-        Repeater {
-            id: waveformRepeater
-            model: Math.ceil(waveform.innerWidth / waveform.maxWidth)
-            Shotcut.TimelineWaveform {
-                width: Math.min(waveform.innerWidth, waveform.maxWidth)
-                height: waveform.height
-                fillColor: getColor()
-                property int channels: 2
-                inPoint: Math.round((clipRoot.inPoint + index * waveform.maxWidth / timeScale) * speed) * channels
-                outPoint: inPoint + Math.round(width / timeScale * speed) * channels
-                levels: audioLevels
-                active: ((clipRoot.x + x + width)   > tracksFlickable.contentX) && // right edge
-                        ((clipRoot.x + x)           < tracksFlickable.contentX + tracksFlickable.width) && // left edge
-                        ((trackRoot.y + y + height) > tracksFlickable.contentY) && // bottom edge
-                        ((trackRoot.y + y)          < tracksFlickable.contentY + tracksFlickable.height) // top edge
+        width: clipRoot.width - clipRoot.border.width * 2
+        height: waveformHeight
+        sourceComponent: Row {
+            id: waveform
+            opacity: waveformOpacity
+            property int maxWidth: Math.max(application.maxTextureSize / 2, 2048)
+            property int innerWidth: clipRoot.width - clipRoot.border.width * 2
+
+            function generate() {
+                // This is needed to make the model have the correct count.
+                // Model as a property expression is not working in all cases.
+                waveformRepeater.model = Math.ceil(waveform.innerWidth / waveform.maxWidth)
+                for (var i = 0; i < waveformRepeater.count; i++)
+                    waveformRepeater.itemAt(0).update()
+            }
+
+            Repeater {
+                id: waveformRepeater
+                model: Math.ceil(waveform.innerWidth / waveform.maxWidth)
+                Shotcut.TimelineWaveform {
+                    width: Math.min(waveform.innerWidth, waveform.maxWidth)
+                    height: waveform.height
+                    fillColor: getColor()
+                    property int channels: 2
+                    inPoint: Math.round((clipRoot.inPoint + index * waveform.maxWidth / timeScale) * speed) * channels
+                    outPoint: inPoint + Math.round(width / timeScale * speed) * channels
+                    levels: audioLevels
+                    active: ((clipRoot.x + x + width)   > tracksFlickable.contentX) && // right edge
+                            ((clipRoot.x + x)           < tracksFlickable.contentX + tracksFlickable.width) && // left edge
+                            ((trackRoot.y + y + height) > tracksFlickable.contentY) && // bottom edge
+                            ((trackRoot.y + y)          < tracksFlickable.contentY + tracksFlickable.height) // top edge
+                }
             }
         }
+        onLoaded: item.generate()
     }
 
     Rectangle {
         // audio peak line
         width: parent.width - parent.border.width * 2
-        visible: waveform.visible && !isTransition
+        visible: showWaveform && !isTransition
         height: 1
         anchors.left: parent.left
         anchors.bottom: parent.bottom
         anchors.leftMargin: parent.border.width
-        anchors.bottomMargin: waveform.height * 0.9
+        anchors.bottomMargin: waveformHeight * 0.9
         color: Qt.darker(parent.color)
-        opacity: waveform.opacity
+        opacity: waveformOpacity
     }
 
     Rectangle {
@@ -191,7 +269,7 @@ Rectangle {
         anchors.left: parent.left
         anchors.topMargin: parent.border.width
         anchors.leftMargin: parent.border.width +
-            ((isAudio || !settings.timelineShowThumbnails) ? 0 : inThumbnail.width)
+            ((isAudio || !settings.timelineShowThumbnails) ? 0 : thumbnailWidth)
         width: label.width + 2
         height: label.height
     }
@@ -206,7 +284,7 @@ Rectangle {
             left: parent.left
             topMargin: parent.border.width + 1
             leftMargin: parent.border.width +
-                ((isAudio || !settings.timelineShowThumbnails) ? 0 : inThumbnail.width) + 1
+                ((isAudio || !settings.timelineShowThumbnails) ? 0 : thumbnailWidth) + 1
         }
         color: 'black'
     }
@@ -220,7 +298,7 @@ Rectangle {
         anchors.right: parent.right
         anchors.topMargin: parent.border.width
         anchors.rightMargin: parent.border.width +
-            ((isAudio || !settings.timelineShowThumbnails) ? 0 : outThumbnail.width) + 2
+            ((isAudio || !settings.timelineShowThumbnails) ? 0 : thumbnailWidth) + 2
         width: labelRight.width + 2
         height: labelRight.height
     }
@@ -228,14 +306,14 @@ Rectangle {
     Text {
         id: labelRight
         text: clipName
-        visible: !isBlank && !isTransition && parent.width > ((settings.timelineShowThumbnails? 2 * outThumbnail.width : 0) + 3 * label.width)
+        visible: !isBlank && !isTransition && parent.width > ((settings.timelineShowThumbnails? 2 * thumbnailWidth : 0) + 3 * label.width)
         font.pointSize: 8
         anchors {
             top: parent.top
             right: parent.right
             topMargin: parent.border.width + 1
             rightMargin: parent.border.width +
-                ((isAudio || !settings.timelineShowThumbnails) ? 0 : outThumbnail.width) + 3
+                ((isAudio || !settings.timelineShowThumbnails) ? 0 : thumbnailWidth) + 3
         }
         color: 'black'
     }
@@ -281,7 +359,7 @@ Rectangle {
         acceptedButtons: Qt.RightButton
         onClicked: {
             timeline.position = timeline.position // pause
-            menu.show()
+            showMenu()
         }
     }
 
@@ -352,7 +430,7 @@ Rectangle {
                 timeline.position = timeline.position // pause
                 clipRoot.forceActiveFocus();
                 clipRoot.clicked(clipRoot, mouse)
-                menu.show()
+                showMenu()
             }
         }
     }
@@ -620,109 +698,100 @@ Rectangle {
             onExited: parent.opacity = 0
         }
     }
-    Menu {
-        id: menu
-        function show() {
-            mergeItem.enabled = timeline.mergeClipWithNext(trackIndex, index, true)
-            popup()
-        }
-        MenuItem {
-            enabled: !isBlank && !isTransition
-            text: qsTr('Cut') + (application.OS === 'OS X'? '    ⌘X' : ' (Ctrl+X)')
-            onTriggered: {
-                if (!trackRoot.isLocked) {
-                    timeline.copyClip(trackIndex, index)
-                    timeline.remove(trackIndex, index)
-                } else {
-                    root.pulseLockButtonOnTrack(currentTrack)
+    Loader {
+        id: menuLoader
+        active: false
+        sourceComponent: Item {
+            property alias menu: menu
+
+            Menu {
+                id: menu
+                function show() {
+                    mergeItem.enabled = timeline.mergeClipWithNext(trackIndex, index, true)
+                    popup()
                 }
-            }
-        }
-        MenuItem {
-            enabled: !isBlank && !isTransition
-            text: qsTr('Copy') + (application.OS === 'OS X'? '    ⌘C' : ' (Ctrl+C)')
-            onTriggered: timeline.copyClip(trackIndex, index)
-        }
-        MenuItem {
-            text: qsTr('Remove') + (application.OS === 'OS X'? '    X' : ' (X)')
-            onTriggered: timeline.remove(trackIndex, index)
-        }
-        MenuItem {
-            enabled: !isBlank && !isTransition
-            text: qsTr('Split At Playhead') + (application.OS === 'OS X'? '    S' : ' (S)')
-            onTriggered: timeline.splitClip(trackIndex, index)
-        }
-        Menu {
-            title: qsTr('More')
-            MenuItem {
-                enabled: !isBlank
-                text: qsTr('Lift') + (application.OS === 'OS X'? '    Z' : ' (Z)')
-                onTriggered: timeline.lift(trackIndex, index)
-            }
-            MenuItem {
-                enabled: !isTransition
-                text: qsTr('Replace') + (application.OS === 'OS X'? '    R' : ' (R)')
-                onTriggered: timeline.replace(trackIndex, index)
-            }
-            MenuItem {
-                id: mergeItem
-                text: qsTr('Merge with next clip')
-                onTriggered: timeline.mergeClipWithNext(trackIndex, index, false)
-            }
-            MenuItem {
-                enabled: !isBlank && !isTransition && !isAudio && (parseInt(audioIndex) > -1 || audioIndex === 'all')
-                text: qsTr('Detach Audio')
-                onTriggered: timeline.detachAudio(trackIndex, index)
-            }
-            MenuItem {
-                enabled: !isBlank && !isTransition && settings.timelineShowThumbnails && !isAudio
-                text: qsTr('Update Thumbnails')
-                onTriggered: {
-                    var s = inThumbnail.source.toString()
-                    if (s.substring(s.length - 1) !== '!') {
-                        inThumbnail.source = s + '!'
-                        resetThumbnailsSourceTimer.restart()
+                MenuItem {
+                    enabled: !isBlank && !isTransition
+                    text: qsTr('Cut') + (application.OS === 'OS X'? '    ⌘X' : ' (Ctrl+X)')
+                    onTriggered: {
+                        if (!trackRoot.isLocked) {
+                            timeline.copyClip(trackIndex, index)
+                            timeline.remove(trackIndex, index)
+                        } else {
+                            root.pulseLockButtonOnTrack(currentTrack)
+                        }
+                    }
+                }
+                MenuItem {
+                    enabled: !isBlank && !isTransition
+                    text: qsTr('Copy') + (application.OS === 'OS X'? '    ⌘C' : ' (Ctrl+C)')
+                    onTriggered: timeline.copyClip(trackIndex, index)
+                }
+                MenuItem {
+                    text: qsTr('Remove') + (application.OS === 'OS X'? '    X' : ' (X)')
+                    onTriggered: timeline.remove(trackIndex, index)
+                }
+                MenuItem {
+                    enabled: !isBlank && !isTransition
+                    text: qsTr('Split At Playhead') + (application.OS === 'OS X'? '    S' : ' (S)')
+                    onTriggered: timeline.splitClip(trackIndex, index)
+                }
+                Menu {
+                    title: qsTr('More')
+                    MenuItem {
+                        enabled: !isBlank
+                        text: qsTr('Lift') + (application.OS === 'OS X'? '    Z' : ' (Z)')
+                        onTriggered: timeline.lift(trackIndex, index)
+                    }
+                    MenuItem {
+                        enabled: !isTransition
+                        text: qsTr('Replace') + (application.OS === 'OS X'? '    R' : ' (R)')
+                        onTriggered: timeline.replace(trackIndex, index)
                     }
-                    s = outThumbnail.source.toString()
-                    if (s.substring(s.length - 1) !== '!') {
-                        outThumbnail.source = s + '!'
-                        resetThumbnailsSourceTimer.restart()
+                    MenuItem {
+                        id: mergeItem
+                        text: qsTr('Merge with next clip')
+                        onTriggered: timeline.mergeClipWithNext(trackIndex, index, false)
+                    }
+                    MenuItem {
+                        enabled: !isBlank && !isTransition && !isAudio && (parseInt(audioIndex) > -1 || audioIndex === 'all')
+                        text: qsTr('Detach Audio')
+                        onTriggered: timeline.detachAudio(trackIndex, index)
+                    }
+                    MenuItem {
+                        enabled: !isBlank && !isTransition && settings.timelineShowThumbnails && !isAudio
+                        text: qsTr('Update Thumbnails')
+                        onTriggered: {
+                            thumbnailSuffix = '!'
+                            resetThumbnailsSourceTimer.restart()
+                        }
+                    }
+                    MenuItem {
+                        enabled: !isBlank && !isTransition && settings.timelineShowWaveforms
+                        text: qsTr('Rebuild Audio Waveform')
+                        onTriggered: timeline.remakeAudioLevels(trackIndex, index)
                     }
                 }
+                MenuItem {
+                    enabled: !isBlank
+                    text: qsTr('Properties')
+                    onTriggered: {
+                        clipRoot.forceActiveFocus()
+                        clipRoot.clicked(clipRoot, null)
+                        timeline.openProperties()
+                    }
+                }
+                MenuItem {
+                    text: qsTr('Cancel')
+                    onTriggered: menu.dismiss()
+                }
             }
-            MenuItem {
-                enabled: !isBlank && !isTransition && settings.timelineShowWaveforms
-                text: qsTr('Rebuild Audio Waveform')
-                onTriggered: timeline.remakeAudioLevels(trackIndex, index)
-            }
-        }
-        MenuItem {
-            enabled: !isBlank
-            text: qsTr('Properties')
-            onTriggered: {
-                clipRoot.forceActiveFocus()
-                clipRoot.clicked(clipRoot, null)
-                timeline.openProperties()
-            }
-        }
-        MenuItem {
-            text: qsTr('Cancel')
-            onTriggered: menu.dismiss()
         }
     }
 
     Timer {
         id: resetThumbnailsSourceTimer
         interval: 5000
-        onTriggered: {
-            var s = inThumbnail.source.toString()
-            if (s.substring(s.length - 1) === '!') {
-                inThumbnail.source = s.substring(0, s.length - 1)
-            }
-            s = inThumbnail.source.toString()
-            if (s.substring(s.length - 1) === '!') {
-                inThumbnail.source = s.substring(0, s.length - 1)
-            }
-        }
+        onTriggered: thumbnailSuffix = ''
     }
 }
@@ -29,7 +29,7 @@ function snapClip(clip, repeater) {
         // Snap to other clips on the same track.
         for (var i = 0; i < repeater.count; i++) {
             // Do not snap to self.
-            if (i === clip.DelegateModel.itemsIndex && clip.trackIndex === repeater.itemAt(i).trackIndex)
+            if (i === clip.clipIndex && clip.trackIndex === repeater.itemAt(i).trackIndex)
                 continue
             var itemLeft = repeater.itemAt(i).x
             var itemRight = itemLeft + repeater.itemAt(i).width
@@ -69,7 +69,7 @@ function snapTrimIn(clip, delta, timeline, trackIndex) {
     if (delta < 0) {
         // Snap to other clips on the same track.
         for (var i = 0; i < repeater.count; i++) {
-            if (i === clip.DelegateModel.itemsIndex || repeater.itemAt(i).isBlank || repeater.itemAt(i).isTransition)
+            if (i === clip.clipIndex || repeater.itemAt(i).isBlank || repeater.itemAt(i).isTransition)
                 continue
             var itemLeft = repeater.itemAt(i).x
             var itemRight = itemLeft + repeater.itemAt(i).width
@@ -113,7 +113,7 @@ function snapTrimOut(clip, delta, timeline, trackIndex) {
     if (delta < 0) {
         // Snap to other clips.
         for (var i = 0; i < repeater.count; i++) {
-            if (i === clip.DelegateModel.itemsIndex || repeater.itemAt(i).isBlank || repeater.itemAt(i).isTransition)
+            if (i === clip.clipIndex || repeater.itemAt(i).isBlank || repeater.itemAt(i).isTransition)
                 continue
             var itemLeft = repeater.itemAt(i).x
             var itemRight = itemLeft + repeater.itemAt(i).width
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2013-2020 Meltytech, LLC
+ * Copyright (c) 2013-2021 Meltytech, LLC
  *
  * This program is free software: you can redistribute it and/or modify
  * it under the terms of the GNU General Public License as published by
@@ -65,169 +65,212 @@ Rectangle {
 
     DelegateModel {
         id: trackModel
-        Clip {
-            clipName: model.name
-            clipResource: model.resource
-            clipDuration: model.duration
-            mltService: model.mlt_service
-            inPoint: model.in
-            outPoint: model.out
-            isBlank: model.blank
-            isAudio: model.audio
-            isTransition: model.isTransition
-            audioLevels: model.audioLevels
+        // Each clip gets a lightweight slot that keeps its index, position,
+        // and size in the row. The full Clip is only created for slots near
+        // the visible part of the timeline, up to one view away in each
+        // direction, and for selected or dragged clips.
+        Item {
+            id: clipSlot
+            property bool isBlank: model.blank
+            property bool isTransition: model.isTransition
+            property int trackIndex: trackRoot.DelegateModel.itemsIndex
+            readonly property bool isSelected: Logic.selectionContains(timeline.selection, trackIndex, index)
+            readonly property bool isDragged: clipLoader.item !== null &&
+                (clipLoader.item.Drag.active || clipLoader.item.trackIndex !== clipLoader.item.originalTrackIndex)
+            readonly property bool isNearViewport:
+                ((x + width) > tracksFlickable.contentX - tracksFlickable.width) &&
+                (x < tracksFlickable.contentX + 2 * tracksFlickable.width) &&
+                ((trackRoot.y + height) > tracksFlickable.contentY - tracksFlickable.height) &&
+                (trackRoot.y < tracksFlickable.contentY + 2 * tracksFlickable.height)
+
+            function generateWaveform(force) {
+                if (clipLoader.item)
+                    clipLoader.item.generateWaveform(force)
+            }
+
             width: model.duration * timeScale
             height: trackRoot.height
-            trackIndex: trackRoot.DelegateModel.itemsIndex
-            fadeIn: model.fadeIn
-            fadeOut: model.fadeOut
-            hash: model.hash
-            speed: model.speed
-            audioIndex: model.audioIndex
-            selected: Logic.selectionContains(timeline.selection, trackIndex, index)
-            isTrackMute: trackRoot.isMute
-
-            onClicked: trackRoot.clipClicked(clip, trackRoot, mouse);
-            onMoved: {
-                var fromTrack = clip.originalTrackIndex
-                var toTrack = clip.trackIndex
-                var clipIndex = clip.originalClipIndex
-                var selection = timeline.selection
-                var frame = Math.round(clip.x / timeScale)
-
-                // Workaround moving multiple clips on the same track with ripple on
-                if (fromTrack === toTrack && settings.timelineRipple && selection.length > 1) {
-                    // Use the left-most clip
-                    var clipIndexChanged = false
-                    for (var i = 0; i < selection.length; i++) {
-                        if (selection[i].y === fromTrack && selection[i].x < clipIndex) {
-                            clipIndex = selection[i].x
-                            clipIndexChanged = true
+            onXChanged: {
+                if (clipLoader.item && !clipLoader.item.Drag.active)
+                    clipLoader.item.x = x
+            }
+
+            Loader {
+                id: clipLoader
+                // Clips are positioned in the track, where a dragged clip
+                // may also reparent itself to another track.
+                parent: trackRoot
+                z: item ? item.z : 0
+                active: clipSlot.isNearViewport || clipSlot.isSelected || clipSlot.isDragged
+                onLoaded: item.x = clipSlot.x
+                sourceComponent: Clip {
+                    clipName: model.name
+                    clipResource: model.resource
+                    clipDuration: model.duration
+                    mltService: model.mlt_service
+                    inPoint: model.in
+                    outPoint: model.out
+                    isBlank: model.blank
+                    isAudio: model.audio
+                    isTransition: model.isTransition
+                    audioLevels: model.audioLevels
+                    width: clipSlot.width
+                    height: trackRoot.height
+                    trackIndex: clipSlot.trackIndex
+                    fadeIn: model.fadeIn
+                    fadeOut: model.fadeOut
+                    hash: model.hash
+                    speed: model.speed
+                    audioIndex: model.audioIndex
+                    selected: clipSlot.isSelected
+                    isTrackMute: trackRoot.isMute
+
+                    onClicked: trackRoot.clipClicked(clip, trackRoot, mouse);
+                    onMoved: {
+                        var fromTrack = clip.originalTrackIndex
+                        var toTrack = clip.trackIndex
+                        var clipIndex = clip.originalClipIndex
+                        var selection = timeline.selection
+                        var frame = Math.round(clip.x / timeScale)
+
+                        // Workaround moving multiple clips on the same track with ripple on
+                        if (fromTrack === toTrack && settings.timelineRipple && selection.length > 1) {
+                            // Use the left-most clip
+                            var clipIndexChanged = false
+                            for (var i = 0; i < selection.length; i++) {
+                                if (selection[i].y === fromTrack && selection[i].x < clipIndex) {
+                                    clipIndex = selection[i].x
+                                    clipIndexChanged = true
+                                }
+                            }
+                            if (clipIndexChanged) {
+                                frame = Math.round((clipAt(clipIndex).x + clip.x - clip.originalX) / timeScale)
+                            }
+                        }
+
+                        // Remove the placeholder inserted in onDraggedToTrack
+                        if (placeHolderAdded) {
+                            placeHolderAdded = false
+                            root.resetDrag()
+                            multitrack.reload(true)
+                        }
+                        if (!timeline.moveClip(fromTrack, toTrack, clipIndex, frame, settings.timelineRipple)) {
+                            clip.x = clip.originalX
+                            clip.trackIndex = clip.originalTrackIndex
                         }
                     }
-                    if (clipIndexChanged) {
-                        frame = Math.round((clipAt(clipIndex).x + clip.x - clip.originalX) / timeScale)
-                    }
-                }
+                    onDragged: {
+                        if (toolbar.scrub) {
+                            root.stopScrolling = false
+                            timeline.position = Math.round(clip.x / timeScale)
+                        }
+                        // Snap if Alt key is not down.
+                        if (!(mouse.modifiers & Qt.AltModifier) && settings.timelineSnap)
+                            trackRoot.checkSnap(clip)
 
-                // Remove the placeholder inserted in onDraggedToTrack
-                if (placeHolderAdded) {
-                    placeHolderAdded = false
-                    root.resetDrag()
-                    multitrack.reload(true)
-                }
-                if (!timeline.moveClip(fromTrack, toTrack, clipIndex, frame, settings.timelineRipple)) {
-                    clip.x = clip.originalX
-                    clip.trackIndex = clip.originalTrackIndex
-                }
-            }
-            onDragged: {
-                if (toolbar.scrub) {
-                    root.stopScrolling = false
-                    timeline.position = Math.round(clip.x / timeScale)
-                }
-                // Snap if Alt key is not down.
-                if (!(mouse.modifiers & Qt.AltModifier) && settings.timelineSnap)
-                    trackRoot.checkSnap(clip)
-
-                // Prevent dragging left of multitracks origin.
-                clip.x = Math.max(0, clip.x)
-                var mapped = trackRoot.mapFromItem(clip, mouse.x, mouse.y)
-                trackRoot.clipDragged(clip, mapped.x, mapped.y)
-
-                // Show distance moved as time in a "bubble" help.
-                var delta = Math.round(clip.x / timeScale) - model.start
-                var s = application.timecode(Math.abs(delta))
-                // remove leading zeroes
-                if (s.substring(0, 3) === '00:')
-                    s = s.substring(3)
-                s = ((delta < 0)? '-' : (delta > 0)? '+' : '') + s
-                bubbleHelp.show(mapped.x, trackRoot.y + trackRoot.height, s)
-            }
-            onTrimmingIn: {
-                var originalDelta = delta
-                if (!(mouse.modifiers & Qt.AltModifier) && settings.timelineSnap && !settings.timelineRipple)
-                    delta = Logic.snapTrimIn(clip, delta, root, trackRoot.DelegateModel.itemsIndex)
-                if (delta != 0) {
-                    if (timeline.trimClipIn(trackRoot.DelegateModel.itemsIndex, clip.DelegateModel.itemsIndex,
-                                            clip.originalClipIndex, delta, settings.timelineRipple)) {
-                        // Show amount trimmed as a time in a "bubble" help.
-                        var s = application.timecode(Math.abs(clip.originalX))
-                        s = '%1%2 = %3'.arg((clip.originalX < 0)? '-' : (clip.originalX > 0)? '+' : '')
-                                       .arg(s.substring(3))
-                                       .arg(application.timecode(clipDuration))
-                        bubbleHelp.show(clip.x, trackRoot.y + trackRoot.height, s)
-                    } else {
-                        clip.originalX -= originalDelta
+                        // Prevent dragging left of multitracks origin.
+                        clip.x = Math.max(0, clip.x)
+                        var mapped = trackRoot.mapFromItem(clip, mouse.x, mouse.y)
+                        trackRoot.clipDragged(clip, mapped.x, mapped.y)
+
+                        // Show distance moved as time in a "bubble" help.
+                        var delta = Math.round(clip.x / timeScale) - model.start
+                        var s = application.timecode(Math.abs(delta))
+                        // remove leading zeroes
+                        if (s.substring(0, 3) === '00:')
+                            s = s.substring(3)
+                        s = ((delta < 0)? '-' : (delta > 0)? '+' : '') + s
+                        bubbleHelp.show(mapped.x, trackRoot.y + trackRoot.height, s)
                     }
-                }
-            }
-            onTrimmedIn: {
-                multitrack.notifyClipIn(trackRoot.DelegateModel.itemsIndex, clip.DelegateModel.itemsIndex)
-                // Notify out point of clip A changed when trimming to add a transition.
-                if (clip.DelegateModel.itemsIndex > 1 && repeater.itemAt(clip.DelegateModel.itemsIndex - 1).isTransition)
-                    multitrack.notifyClipOut(trackRoot.DelegateModel.itemsIndex, clip.DelegateModel.itemsIndex - 2)
-                bubbleHelp.hide()
-                timeline.commitTrimCommand()
-            }
-            onTrimmingOut: {
-                var originalDelta = delta
-                if (!(mouse.modifiers & Qt.AltModifier) && settings.timelineSnap && !settings.timelineRipple)
-                    delta = Logic.snapTrimOut(clip, delta, root, trackRoot.DelegateModel.itemsIndex)
-                if (delta != 0) {
-                    if (timeline.trimClipOut(trackRoot.DelegateModel.itemsIndex,
-                                             clip.DelegateModel.itemsIndex, delta, settings.timelineRipple)) {
-                        // Show amount trimmed as a time in a "bubble" help.
-                        var s = application.timecode(Math.abs(clip.originalX))
-                        s = '%1%2 = %3'.arg((clip.originalX < 0)? '+' : (clip.originalX > 0)? '-' : '')
-                                       .arg(s.substring(3))
-                                       .arg(application.timecode(clipDuration))
-                        bubbleHelp.show(clip.x + clip.width, trackRoot.y + trackRoot.height, s)
-                    } else {
-                        clip.originalX -= originalDelta
+                    onTrimmingIn: {
+                        var originalDelta = delta
+                        if (!(mouse.modifiers & Qt.AltModifier) && settings.timelineSnap && !settings.timelineRipple)
+                            delta = Logic.snapTrimIn(clip, delta, root, trackRoot.DelegateModel.itemsIndex)
+                        if (delta != 0) {
+                            if (timeline.trimClipIn(trackRoot.DelegateModel.itemsIndex, clip.clipIndex,
+                                                    clip.originalClipIndex, delta, settings.timelineRipple)) {
+                                // Show amount trimmed as a time in a "bubble" help.
+                                var s = application.timecode(Math.abs(clip.originalX))
+                                s = '%1%2 = %3'.arg((clip.originalX < 0)? '-' : (clip.originalX > 0)? '+' : '')
+                                               .arg(s.substring(3))
+                                               .arg(application.timecode(clipDuration))
+                                bubbleHelp.show(clip.x, trackRoot.y + trackRoot.height, s)
+                            } else {
+                                clip.originalX -= originalDelta
+                            }
+                        }
                     }
-                }
-            }
-            onTrimmedOut: {
-                multitrack.notifyClipOut(trackRoot.DelegateModel.itemsIndex, clip.DelegateModel.itemsIndex)
-                // Notify in point of clip B changed when trimming to add a transition.
-                if (clip.DelegateModel.itemsIndex + 2 < repeater.count && repeater.itemAt(clip.DelegateModel.itemsIndex + 1).isTransition)
-                    multitrack.notifyClipIn(trackRoot.DelegateModel.itemsIndex, clip.DelegateModel.itemsIndex + 2)
-                bubbleHelp.hide()
-                timeline.commitTrimCommand()
-            }
-            onDraggedToTrack: {
-                if (!placeHolderAdded) {
-                    placeHolderAdded = true
-                    trackModel.items.insert(clip.DelegateModel.itemsIndex, {
-                        'name': '',
-                        'resource': '',
-                        'duration': clip.clipDuration,
-                        'mlt_service': '<producer',
-                        'in': 0,
-                        'out': clip.clipDuration - 1,
-                        'blank': true,
-                        'audio': false,
-                        'isTransition': false,
-                        'fadeIn': 0,
-                        'fadeOut': 0,
-                        'hash': '',
-                        'speed': 1.0
-                    })
-                }
-            }
-            onDropped: {
-                if (placeHolderAdded) {
-                    timeline.selection = []
-                    multitrack.reload(true)
-                    placeHolderAdded = false
-                }
-            }
+                    onTrimmedIn: {
+                        multitrack.notifyClipIn(trackRoot.DelegateModel.itemsIndex, clip.clipIndex)
+                        // Notify out point of clip A changed when trimming to add a transition.
+                        if (clip.clipIndex > 1 && repeater.itemAt(clip.clipIndex - 1).isTransition)
+                            multitrack.notifyClipOut(trackRoot.DelegateModel.itemsIndex, clip.clipIndex - 2)
+                        bubbleHelp.hide()
+                        timeline.commitTrimCommand()
+                    }
+                    onTrimmingOut: {
+                        var originalDelta = delta
+                        if (!(mouse.modifiers & Qt.AltModifier) && settings.timelineSnap && !settings.timelineRipple)
+                            delta = Logic.snapTrimOut(clip, delta, root, trackRoot.DelegateModel.itemsIndex)
+                        if (delta != 0) {
+                            if (timeline.trimClipOut(trackRoot.DelegateModel.itemsIndex,
+                                                     clip.clipIndex, delta, settings.timelineRipple)) {
+                                // Show amount trimmed as a time in a "bubble" help.
+                                var s = application.timecode(Math.abs(clip.originalX))
+                                s = '%1%2 = %3'.arg((clip.originalX < 0)? '+' : (clip.originalX > 0)? '-' : '')
+                                               .arg(s.substring(3))
+                                               .arg(application.timecode(clipDuration))
+                                bubbleHelp.show(clip.x + clip.width, trackRoot.y + trackRoot.height, s)
+                            } else {
+                                clip.originalX -= originalDelta
+                            }
+                        }
+                    }
+                    onTrimmedOut: {
+                        multitrack.notifyClipOut(trackRoot.DelegateModel.itemsIndex, clip.clipIndex)
+                        // Notify in point of clip B changed when trimming to add a transition.
+                        if (clip.clipIndex + 2 < repeater.count && repeater.itemAt(clip.clipIndex + 1).isTransition)
+                            multitrack.notifyClipIn(trackRoot.DelegateModel.itemsIndex, clip.clipIndex + 2)
+                        bubbleHelp.hide()
+                        timeline.commitTrimCommand()
+                    }
+                    onDraggedToTrack: {
+                        if (!placeHolderAdded) {
+                            placeHolderAdded = true
+                            trackModel.items.insert(clip.clipIndex, {
+                                'name': '',
+                                'resource': '',
+                                'duration': clip.clipDuration,
+                                'mlt_service': '<producer',
+                                'in': 0,
+                                'out': clip.clipDuration - 1,
+                                'blank': true,
+                                'audio': false,
+                                'isTransition': false,
+                                'fadeIn': 0,
+                                'fadeOut': 0,
+                                'hash': '',
+                                'speed': 1.0
+                            })
+                        }
+                    }
+                    onDropped: {
+                        if (placeHolderAdded) {
+                            timeline.selection = []
+                            multitrack.reload(true)
+                            placeHolderAdded = false
+                        }
+                    }
+
+                    // Return to the slot once a drag ends, after the move is applied.
+                    Drag.onActiveChanged: if (!Drag.active) x = clipSlot.x
 
-            Component.onCompleted: {
-                moved.connect(trackRoot.clipDropped)
-                dropped.connect(trackRoot.clipDropped)
-                draggedToTrack.connect(trackRoot.clipDraggedToTrack)
+                    Component.onCompleted: {
+                        moved.connect(trackRoot.clipDropped)
+                        dropped.connect(trackRoot.clipDropped)
+                        draggedToTrack.connect(trackRoot.clipDraggedToTrack)
+                    }
+                }
             }
         }
     }
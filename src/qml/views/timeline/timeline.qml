@@ -369,7 +369,7 @@ Rectangle {
                                     height: track.height
                                     color: 'transparent'
                                     border.color: 'red'
-                                    visible: !clip.Drag.active && clip.trackIndex === clip.originalTrackIndex
+                                    visible: !clip.isDragged
                                 }
                             }
                         }
@@ -630,7 +630,7 @@ Rectangle {
             timeScale: multitrack.scaleFactor
             onClipClicked: {
                 var trackIndex = track.DelegateModel.itemsIndex
-                var clipIndex = clip.DelegateModel.itemsIndex
+                var clipIndex = clip.clipIndex
                 currentTrack = trackIndex
                 if (mouse && mouse.modifiers & Qt.ControlModifier)
                     timeline.selection = Logic.toggleSelection(trackIndex, clipIndex)
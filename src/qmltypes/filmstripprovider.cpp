@@ -0,0 +1,125 @@
+/*
+ * Copyright (c) 2021 Meltytech, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "filmstripprovider.h"
+#include "mltcontroller.h"
+#include "models/playlistmodel.h"
+#include "database.h"
+#include "producerpool.h"
+#include <QCryptographicHash>
+#include <QPainter>
+#include <QScopedPointer>
+
+#include <Logger.h>
+
+FilmstripProvider::FilmstripProvider()
+    : QQuickImageProvider(QQmlImageProviderBase::Image, QQmlImageProviderBase::ForceAsynchronousImageLoading)
+    , m_profile("atsc_720p_60")
+{
+}
+
+QImage FilmstripProvider::requestImage(const QString &id, QSize *size, const QSize &requestedSize)
+{
+    Q_UNUSED(requestedSize)
+    QImage result;
+
+    // id is [hash]/mlt_service/resource#in:out:count[!]
+    int index = id.lastIndexOf('#');
+
+    if (index != -1) {
+        QString myId = id;
+        bool force = id.endsWith('!');
+        if (force)
+            myId = id.left(id.size() - 1);
+        QString hash = myId.section('/', 0, 0);
+        QString service = myId.section('/', 1, 1);
+        QString resource = myId.section('/', 2);
+        resource = resource.left(resource.lastIndexOf('#'));
+        QStringList range = myId.mid(index + 1).split(':');
+        if (range.size() == 3) {
+            // Scale the frame numbers to this profile's fps.
+            int in = qRound(range[0].toInt() / MLT.profile().fps() * m_profile.fps());
+            int out = qRound(range[1].toInt() / MLT.profile().fps() * m_profile.fps());
+            int count = qBound(1, range[2].toInt(), MAX_COUNT);
+
+            QString key = cacheKey(service, resource, hash, in, out, count);
+            result = DB.getThumbnail(key);
+            if (force || result.isNull()) {
+                ProducerPool& pool = ProducerPool::singleton();
+                if (force)
+                    pool.evict(resource);
+                Mlt::Producer* producer = pool.checkOut("atsc_720p_60", service, resource, ProducerPool::Thumbnail);
+                if (producer->is_valid()) {
+                    result = makeFilmstrip(*producer, in, out, count);
+                    DB.putThumbnail(key, result);
+                }
+                pool.checkIn(producer);
+            }
+        }
+    }
+    if (result.isNull()) {
+        result = QImage(1, 1, QImage::Format_Alpha8);
+        result.fill(0);
+    }
+    if (size)
+        *size = result.size();
+    return result;
+}
+
+QString FilmstripProvider::cacheKey(const QString& service, const QString& resource, const QString& hash,
+                                    int in, int out, int count)
+{
+    QString key = QString("%1 filmstrip %2 %3 %4")
+            .arg(hash.isEmpty()? service + ' ' + resource : hash)
+            .arg(in).arg(out).arg(count);
+    QCryptographicHash sha1(QCryptographicHash::Sha1);
+    sha1.addData(key.toUtf8());
+    return sha1.result().toHex();
+}
+
+// The \a producer already has the filters for thumbnails.
+QImage FilmstripProvider::makeFilmstrip(Mlt::Producer& producer, int in, int out, int count)
+{
+    int width = PlaylistModel::THUMBNAIL_WIDTH * 2;
+    int height = PlaylistModel::THUMBNAIL_HEIGHT * 2;
+    int last = qMax(0, producer.get_length() - 1);
+    in = qBound(0, in, last);
+    out = qBound(in, out, last);
+
+    QImage strip(width * count, height, QImage::Format_ARGB32_Premultiplied);
+    strip.fill(Qt::transparent);
+    QPainter painter(&strip);
+    QImage previous;
+    for (int i = 0; i < count; i++) {
+        int frameNumber = in + int(qint64(out - in + 1) * i / count);
+        // Going forward, the decoder continues from the previous thumbnail
+        // if it is near instead of seeking to a keyframe again.
+        producer.seek(frameNumber);
+        QScopedPointer<Mlt::Frame> frame(producer.get_frame());
+        QImage image;
+        if (frame && frame->is_valid())
+            image = MLT.image(frame.data(), width, height);
+        // Frames near the end may not decode; repeat the one before.
+        if (image.isNull())
+            image = previous;
+        if (!image.isNull())
+            painter.drawImage(i * width, 0, image);
+        previous = image;
+    }
+    painter.end();
+    return strip;
+}
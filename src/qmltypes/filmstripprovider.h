@@ -0,0 +1,53 @@
+/*
+ * Copyright (c) 2021 Meltytech, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef FILMSTRIPPROVIDER_H
+#define FILMSTRIPPROVIDER_H
+
+#include <QQuickImageProvider>
+#include <MltProducer.h>
+#include <MltProfile.h>
+
+/*!
+  \class FilmstripProvider
+  \brief The FilmstripProvider makes the continuous thumbnails of a timeline
+  clip as one image.
+
+  The id is [hash]/mlt_service/resource#in:out:count with an optional
+  trailing '!' to force an update. The image has count thumbnails side by
+  side, taken at even steps from in to before out. They are read in order
+  from one producer, so that a decoder that is near the next thumbnail
+  decodes on to it instead of seeking, and the strip is cached as a whole.
+*/
+
+class FilmstripProvider : public QQuickImageProvider
+{
+public:
+    //! The most thumbnails in a strip, which keeps it within a texture.
+    static const int MAX_COUNT = 32;
+
+    explicit FilmstripProvider();
+    QImage requestImage(const QString &id, QSize *size, const QSize &requestedSize);
+
+private:
+    QString cacheKey(const QString& service, const QString& resource, const QString& hash,
+                     int in, int out, int count);
+    QImage makeFilmstrip(Mlt::Producer& producer, int in, int out, int count);
+    Mlt::Profile m_profile;
+};
+
+#endif // FILMSTRIPPROVIDER_H
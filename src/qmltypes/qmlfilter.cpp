@@ -386,6 +386,9 @@ void QmlFilter::analyze(bool isAudio)
         connect(job, &AbstractJob::finished, delegate, &AnalyzeDelegate::onAnalyzeFinished);
         connect(job, &AbstractJob::finished, this, &QmlFilter::analyzeFinished);
         job->setLabel(tr("Analyze %1").arg(Util::baseName(ProxyManager::resource(service))));
+        job->setResourceClass(AbstractJob::ResourceLight);
+        // The user is waiting for the analysis to use the filter.
+        job->setPriority(1);
 
         // Touch the target .stab file. This prevents multiple jobs from trying
         // to write the same file.
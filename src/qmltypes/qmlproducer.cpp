@@ -19,6 +19,7 @@
 #include "mltcontroller.h"
 #include "util.h"
 #include "models/audiolevelstask.h"
+#include "models/audiolevels.h"
 #include "mainwindow.h"
 
 static const char* kWidthProperty = "meta.media.width";
@@ -90,7 +91,7 @@ QVariant QmlProducer::audioLevels()
 {
     if (!m_producer.is_valid()) return QVariant();
     if (m_producer.get_data(kAudioLevelsProperty))
-        return QVariant::fromValue(*((QVariantList*) m_producer.get_data(kAudioLevelsProperty)));
+        return QVariant::fromValue(*((AudioLevels*) m_producer.get_data(kAudioLevelsProperty)));
     else
         return QVariant();
 }
@@ -21,6 +21,7 @@
 #include "mltcontroller.h"
 #include "models/playlistmodel.h"
 #include "database.h"
+#include "producerpool.h"
 
 #include <Logger.h>
 
@@ -58,15 +59,15 @@ QImage ThumbnailProvider::requestImage(const QString &id, QSize *size, const QSi
         QString key = cacheKey(properties, service, resource, hash, frameNumber);
         result = DB.getThumbnail(key);
         if (force || result.isNull()) {
-            if (service == "avformat-novalidate")
-                service = "avformat";
-            else if (service.startsWith("xml"))
-                service = "xml-nogl";
-            Mlt::Producer producer(m_profile, service.toUtf8().constData(), resource.toUtf8().constData());
-            if (producer.is_valid()) {
-                result = makeThumbnail(producer, frameNumber, requestedSize);
+            ProducerPool& pool = ProducerPool::singleton();
+            if (force)
+                pool.evict(resource);
+            Mlt::Producer* producer = pool.checkOut("atsc_720p_60", service, resource, ProducerPool::Thumbnail);
+            if (producer->is_valid()) {
+                result = makeThumbnail(*producer, frameNumber, requestedSize);
                 DB.putThumbnail(key, result);
             }
+            pool.checkIn(producer);
         }
     }
     if (result.isNull()) {
@@ -100,11 +101,9 @@ QString ThumbnailProvider::cacheKey(Mlt::Properties& properties, const QString&
     return key;
 }
 
+// The \a producer already has the filters for thumbnails.
 QImage ThumbnailProvider::makeThumbnail(Mlt::Producer &producer, int frameNumber, const QSize& requestedSize)
 {
-    Mlt::Filter scaler(m_profile, "swscale");
-    Mlt::Filter padder(m_profile, "resize");
-    Mlt::Filter converter(m_profile, "avcolor_space");
     int height = PlaylistModel::THUMBNAIL_HEIGHT * 2;
     int width = PlaylistModel::THUMBNAIL_WIDTH * 2;
 
@@ -113,8 +112,5 @@ QImage ThumbnailProvider::makeThumbnail(Mlt::Producer &producer, int frameNumber
         height = requestedSize.height();
     }
 
-    producer.attach(scaler);
-    producer.attach(padder);
-    producer.attach(converter);
     return MLT.image(producer, frameNumber, width, height);
 }
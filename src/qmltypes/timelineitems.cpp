@@ -18,6 +18,7 @@
 #include "timelineitems.h"
 #include "mltcontroller.h"
 #include "settings.h"
+#include "models/audiolevels.h"
 #include <Logger.h>
 
 #include <QQuickPaintedItem>
@@ -114,9 +115,11 @@ public:
     {
         if (!m_isActive)
             return;
-        QVariantList data = m_audioLevels.toList();
-        if (data.isEmpty())
+        const AudioLevels levels = m_audioLevels.value<AudioLevels>();
+        if (levels.isEmpty())
             return;
+        const int channels = qMax(1, levels.channels());
+        const int frameCount = levels.frameCount();
 
         // In and out points are # frames at current fps,
         // but audio levels are created at 25 fps.
@@ -127,15 +130,18 @@ public:
 
 //        LOG_DEBUG() << "In/out points" << inPoint << "/" << outPoint;
 
+        // Each pixel shows the peak of all of the frames it covers, which
+        // the pyramid of levels provides at constant cost per pixel.
         QPainterPath path;
         path.moveTo(-1, height());
         int i = 0;
         for (; i < width(); ++i)
         {
-            int idx = inPoint + int(i * indicesPrPixel);
-            if (idx + 1 >= data.length())
+            int firstFrame = (inPoint + int(i * indicesPrPixel)) / channels;
+            int lastFrame = (inPoint + int((i + 1) * indicesPrPixel)) / channels - 1;
+            if (firstFrame >= frameCount)
                 break;
-            qreal level = qMax(data.at(idx).toReal(), data.at(idx + 1).toReal()) / 256;
+            qreal level = levels.maxPeak(firstFrame, qMax(firstFrame, lastFrame)) / 256.0;
             path.lineTo(i, height() - level * height());
         }
         path.lineTo(i, height());
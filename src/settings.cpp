@@ -20,6 +20,7 @@
 #include <QStandardPaths>
 #include <QFile>
 #include <QDir>
+#include <QThread>
 #include <Logger.h>
 
 static const QString APP_DATA_DIR_KEY("appdatadir");
@@ -298,6 +299,16 @@ void ShotcutSettings::setEncodeParallelProcessing(bool b)
     settings.setValue("encode/parallelProcessing", b);
 }
 
+bool ShotcutSettings::encodeChunked() const
+{
+    return settings.value("encode/chunked", false).toBool();
+}
+
+void ShotcutSettings::setEncodeChunked(bool b)
+{
+    settings.setValue("encode/chunked", b);
+}
+
 int ShotcutSettings::playerAudioChannels() const
 {
     return settings.value("player/audioChannels", 2).toInt();
@@ -431,6 +442,28 @@ void ShotcutSettings::setPlayerRealtime(bool b)
     settings.setValue("player/realtime", b);
 }
 
+int ShotcutSettings::playerRenderThreads() const
+{
+    // 0 means automatic.
+    return settings.value("player/renderThreads", 0).toInt();
+}
+
+void ShotcutSettings::setPlayerRenderThreads(int threads)
+{
+    settings.setValue("player/renderThreads", threads);
+}
+
+int ShotcutSettings::backgroundThreads() const
+{
+    // 0 means automatic.
+    return settings.value("backgroundThreads", 0).toInt();
+}
+
+void ShotcutSettings::setBackgroundThreads(int threads)
+{
+    settings.setValue("backgroundThreads", threads);
+}
+
 bool ShotcutSettings::playerScrubAudio() const
 {
     return settings.value("player/scrubAudio", true).toBool();
@@ -686,6 +719,17 @@ void ShotcutSettings::setLoudnessScopeShowMeter(const QString& meter, bool b)
     settings.setValue("scope/loudness/" + meter, b);
 }
 
+int ShotcutSettings::videoScopeQuality() const
+{
+    // 3 is adaptive (VideoScopeAnalyzer::AdaptiveQuality).
+    return settings.value("scope/video/quality", 3).toInt();
+}
+
+void ShotcutSettings::setVideoScopeQuality(int quality)
+{
+    settings.setValue("scope/video/quality", quality);
+}
+
 int ShotcutSettings::drawMethod() const
 {
 #ifdef Q_OS_WIN
@@ -854,6 +898,27 @@ void ShotcutSettings::setProjectsFolder(const QString &path)
     settings.setValue("projectsFolder", path);
 }
 
+int ShotcutSettings::jobsCpuBudget() const
+{
+    return settings.value("jobs/cpuBudget", QThread::idealThreadCount()).toInt();
+}
+
+void ShotcutSettings::setJobsCpuBudget(int cores)
+{
+    settings.setValue("jobs/cpuBudget", cores);
+}
+
+// In MiB; 0 only starts another job while the system is not low on memory.
+int ShotcutSettings::jobsMemoryBudget() const
+{
+    return settings.value("jobs/memoryBudget", 0).toInt();
+}
+
+void ShotcutSettings::setJobsMemoryBudget(int mebibytes)
+{
+    settings.setValue("jobs/memoryBudget", mebibytes);
+}
+
 bool ShotcutSettings::proxyEnabled() const
 {
     return settings.value("proxy/enabled", false).toBool();
@@ -900,6 +965,17 @@ void ShotcutSettings::setProxyUseHardware(bool b)
     settings.setValue("proxy/useHardware", b);
 }
 
+// The number of FFmpeg processes that make proxies at the same time.
+int ShotcutSettings::proxyWorkers() const
+{
+    return settings.value("proxy/workers", qBound(1, QThread::idealThreadCount() / 4, 4)).toInt();
+}
+
+void ShotcutSettings::setProxyWorkers(int count)
+{
+    settings.setValue("proxy/workers", count);
+}
+
 int ShotcutSettings::undoLimit() const
 {
     return settings.value("undoLimit", 1000).toInt();
@@ -101,6 +101,8 @@ public:
     void setShowConvertClipDialog(bool);
     bool encodeParallelProcessing() const;
     void setEncodeParallelProcessing(bool);
+    bool encodeChunked() const;
+    void setEncodeChunked(bool);
 
     // player
     int playerAudioChannels() const;
@@ -128,6 +130,10 @@ public:
     void setPlayerProgressive(bool);
     bool playerRealtime() const;
     void setPlayerRealtime(bool);
+    int playerRenderThreads() const;
+    void setPlayerRenderThreads(int);
+    int backgroundThreads() const;
+    void setBackgroundThreads(int);
     bool playerScrubAudio() const;
     void setPlayerScrubAudio(bool);
     int playerVolume() const;
@@ -184,6 +190,8 @@ public:
     // scope
     bool loudnessScopeShowMeter(const QString& meter) const;
     void setLoudnessScopeShowMeter(const QString& meter, bool b);
+    int videoScopeQuality() const;
+    void setVideoScopeQuality(int quality);
 
     // general continued
     int drawMethod() const;
@@ -215,6 +223,12 @@ public:
     QString projectsFolder() const;
     void setProjectsFolder(const QString& path);
 
+    // jobs
+    int jobsCpuBudget() const;
+    void setJobsCpuBudget(int);
+    int jobsMemoryBudget() const;
+    void setJobsMemoryBudget(int);
+
     // proxy
     bool proxyEnabled() const;
     void setProxyEnabled(bool);
@@ -224,6 +238,8 @@ public:
     void setProxyUseProjectFolder(bool);
     bool proxyUseHardware() const;
     void setProxyUseHardware(bool);
+    int proxyWorkers() const;
+    void setProxyWorkers(int);
 
     int undoLimit() const;
 
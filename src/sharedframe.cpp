@@ -19,9 +19,21 @@
 
 #include <mutex>
 
-void destroyFrame(void* p)
+// A frame that holds one converted image and a lock for converting it
+class ConvertedImage
 {
-    delete static_cast<Mlt::Frame*>(p);
+public:
+    ConvertedImage(mlt_frame frame) : f(frame) {};
+
+    Mlt::Frame f;
+    std::mutex m;
+private:
+    Q_DISABLE_COPY(ConvertedImage)
+};
+
+void destroyConvertedImage(void* p)
+{
+    delete static_cast<ConvertedImage*>(p);
 }
 
 class FrameData : public QSharedData
@@ -62,6 +74,17 @@ SharedFrame& SharedFrame::operator=(const SharedFrame& other)
    return *this;
 }
 
+bool SharedFrame::operator==(const SharedFrame& other) const
+{
+    // Copies share the same frame data.
+    return d == other.d;
+}
+
+bool SharedFrame::operator!=(const SharedFrame& other) const
+{
+    return d != other.d;
+}
+
 bool SharedFrame::is_valid() const
 {
     return d && d->f.is_valid();
@@ -197,29 +220,33 @@ const uint8_t* SharedFrame::get_image(mlt_image_format format) const
 
         nonConstData->m.lock();
 
-        Mlt::Frame* cacheFrame = static_cast<Mlt::Frame*>(nonConstData->f.get_data(formatName));
-        if (cacheFrame == nullptr) {
+        ConvertedImage* cache = static_cast<ConvertedImage*>(nonConstData->f.get_data(formatName));
+        if (cache == nullptr) {
             // A cached image does not exist, create one.
             // Make a non-deep clone of the frame (including convert function)
             mlt_frame cloneFrame = mlt_frame_clone(nonConstData->f.get_frame(), 0);
             cloneFrame->convert_image = nonConstData->f.get_frame()->convert_image;
             // Create a new cache frame
-            cacheFrame = new Mlt::Frame(cloneFrame);
+            cache = new ConvertedImage(cloneFrame);
             // Release the reference on the clone
             // (now it is owned by the cache frame)
             mlt_frame_close( cloneFrame );
             // Save the cache frame as a property under the name of the image
             // format for later use.
-            nonConstData->f.set(formatName, static_cast<void*>(cacheFrame), 0, destroyFrame);
+            nonConstData->f.set(formatName, static_cast<void*>(cache), 0, destroyConvertedImage);
             // Break a circular reference
-            cacheFrame->clear("_cloned_frame");
+            cache->f.clear("_cloned_frame");
         }
 
-        // Get the image from the cache frame.
-        // This will cause a conversion if it was just created.
-        image = (uint8_t*)cacheFrame->get_image(format, width, height, 0);
-
         nonConstData->m.unlock();
+
+        // Get the image from the cache frame.
+        // This will cause a conversion if it was just created. Only threads
+        // that want the same format wait for it, so e.g. the player's
+        // yuv420p does not wait for a scope's rgb24.
+        cache->m.lock();
+        image = (uint8_t*)cache->f.get_image(format, width, height, 0);
+        cache->m.unlock();
     }
     return image;
 }
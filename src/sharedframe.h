@@ -42,6 +42,9 @@ class FrameData;
   the frame data (e.g. to resize the image), then the object must call clone()
   to receive it's own non-const copy of the frame.
 
+  get_image() converts the image to a non-native format at most once per frame
+  and format and keeps the result for all copies.
+
   TODO: Consider providing a similar class in Mlt++.
 */
 
@@ -53,6 +56,8 @@ public:
     SharedFrame(const SharedFrame& other);
     ~SharedFrame();
     SharedFrame& operator=(const SharedFrame& other);
+    bool operator==(const SharedFrame& other) const;
+    bool operator!=(const SharedFrame& other) const;
 
     bool is_valid() const;
     Mlt::Frame clone(bool audio = false, bool image = false, bool alpha = false) const;
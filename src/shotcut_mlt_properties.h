@@ -88,6 +88,7 @@
 #define kMultitrackItemProperty "_shotcut:multitrack-item"
 #define kExportFromProperty "_shotcut:exportFromDefault"
 #define kIsProxyProperty "shotcut:proxy"
+#define kDisplaySequenceProperty "_shotcut:display-sequence"
 
 #define kDefaultMltProfile "atsc_1080p_25"
 
@@ -14,6 +14,7 @@ SOURCES += main.cpp\
     mainwindow.cpp \
     mltcontroller.cpp \
     proxymanager.cpp \
+    producerpool.cpp \
     qmltypes/qmlrichtext.cpp \
     scrubbar.cpp \
     openotherdialog.cpp \
@@ -85,6 +86,7 @@ SOURCES += main.cpp\
     qmltypes/qmlutilities.cpp \
     qmltypes/qmlview.cpp \
     qmltypes/thumbnailprovider.cpp \
+    qmltypes/filmstripprovider.cpp \
     commands/timelinecommands.cpp \
     util.cpp \
     widgets/lumamixtransition.cpp \
@@ -93,29 +95,38 @@ SOURCES += main.cpp\
     jobs/abstractjob.cpp \
     jobs/meltjob.cpp \
     jobs/encodejob.cpp \
+    jobs/chunkedencodejob.cpp \
     jobs/postjobaction.cpp \
+    jobs/proxybatchjob.cpp \
     jobs/videoqualityjob.cpp \
     commands/playlistcommands.cpp \
     docks/scopedock.cpp \
     controllers/scopecontroller.cpp \
+    widgets/scopes/scopedensitydisplay.cpp \
+    widgets/scopes/scopekernels.cpp \
     widgets/scopes/scopewidget.cpp \
     widgets/scopes/audioloudnessscopewidget.cpp \
+    widgets/scopes/audioscopeanalyzer.cpp \
     widgets/scopes/audiopeakmeterscopewidget.cpp \
     widgets/scopes/audiospectrumscopewidget.cpp \
     widgets/scopes/audiowaveformscopewidget.cpp \
     widgets/scopes/videohistogramscopewidget.cpp \
     widgets/scopes/videorgbparadescopewidget.cpp \
     widgets/scopes/videorgbwaveformscopewidget.cpp \
+    widgets/scopes/videoscopeanalyzer.cpp \
     widgets/scopes/videovectorscopewidget.cpp \
     widgets/scopes/videowaveformscopewidget.cpp \
     widgets/scopes/videozoomscopewidget.cpp \
     widgets/scopes/videozoomwidget.cpp \
     sharedframe.cpp \
+    audiotap.cpp \
     widgets/audioscale.cpp \
     widgets/playlisttable.cpp \
     widgets/playlisticonview.cpp \
     commands/undohelper.cpp \
+    models/audiolevels.cpp \
     models/audiolevelstask.cpp \
+    models/audiopeakfile.cpp \
     mltxmlchecker.cpp \
     widgets/avfoundationproducerwidget.cpp \
     widgets/frameratewidget.cpp \
@@ -133,6 +144,7 @@ SOURCES += main.cpp\
     widgets/textproducerwidget.cpp \
     dialogs/listselectiondialog.cpp \
     dialogs/longuitask.cpp \
+    dialogs/scopestatisticsdialog.cpp \
     widgets/newprojectfolder.cpp \
     widgets/playlistlistview.cpp
 
@@ -144,6 +156,7 @@ HEADERS  += mainwindow.h \
     jobs/qimagejob.h \
     mltcontroller.h \
     proxymanager.h \
+    producerpool.h \
     qmltypes/qmlrichtext.h \
     scrubbar.h \
     openotherdialog.h \
@@ -218,6 +231,7 @@ HEADERS  += mainwindow.h \
     qmltypes/qmlutilities.h \
     qmltypes/qmlview.h \
     qmltypes/thumbnailprovider.h \
+    qmltypes/filmstripprovider.h \
     commands/timelinecommands.h \
     util.h \
     widgets/lumamixtransition.h \
@@ -226,30 +240,40 @@ HEADERS  += mainwindow.h \
     jobs/abstractjob.h \
     jobs/meltjob.h \
     jobs/encodejob.h \
+    jobs/chunkedencodejob.h \
     jobs/postjobaction.h \
+    jobs/proxybatchjob.h \
     jobs/videoqualityjob.h \
     commands/playlistcommands.h \
     docks/scopedock.h \
     controllers/scopecontroller.h \
+    widgets/scopes/scopedensitydisplay.h \
+    widgets/scopes/scopekernels.h \
     widgets/scopes/scopewidget.h \
     widgets/scopes/audioloudnessscopewidget.h \
+    widgets/scopes/audioscopeanalyzer.h \
     widgets/scopes/audiopeakmeterscopewidget.h \
     widgets/scopes/audiospectrumscopewidget.h \
     widgets/scopes/audiowaveformscopewidget.h \
     widgets/scopes/videohistogramscopewidget.h \
     widgets/scopes/videorgbparadescopewidget.h \
     widgets/scopes/videorgbwaveformscopewidget.h \
+    widgets/scopes/videoscopeanalyzer.h \
     widgets/scopes/videovectorscopewidget.h \
     widgets/scopes/videowaveformscopewidget.h \
     widgets/scopes/videozoomscopewidget.h \
     widgets/scopes/videozoomwidget.h \
     dataqueue.h \
+    lockfreedataqueue.h \
     sharedframe.h \
+    audiotap.h \
     widgets/audioscale.h \
     widgets/playlisttable.h \
     widgets/playlisticonview.h \
     commands/undohelper.h \
+    models/audiolevels.h \
     models/audiolevelstask.h \
+    models/audiopeakfile.h \
     shotcut_mlt_properties.h \
     mltxmlchecker.h \
     widgets/avfoundationproducerwidget.h \
@@ -268,6 +292,7 @@ HEADERS  += mainwindow.h \
     widgets/textproducerwidget.h \
     dialogs/listselectiondialog.h \
     dialogs/longuitask.h \
+    dialogs/scopestatisticsdialog.h \
     widgets/newprojectfolder.h \
     widgets/playlistlistview.h
 
@@ -374,29 +399,10 @@ mac {
     INCLUDEPATH += $$[QT_INSTALL_HEADERS]
     LIBS += -framework Foundation -framework Cocoa
 
-    # QMake from Qt 5.1.0 on OSX is messing with the environment in which it runs
-    # pkg-config such that the PKG_CONFIG_PATH env var is not set.
-    isEmpty(MLT_PREFIX) {
-        MLT_PREFIX = /opt/local
-    }
-    isEmpty(PREFIX) {
-        INCLUDEPATH += $$MLT_PREFIX/include/mlt++
-        INCLUDEPATH += $$MLT_PREFIX/include/mlt
-        LIBS += -L$$MLT_PREFIX/lib -lmlt++ -lmlt
-    } else {
-        INCLUDEPATH += $$PREFIX/Contents/Frameworks/include/mlt++
-        INCLUDEPATH += $$PREFIX/Contents/Frameworks/include/mlt
-        LIBS += -L$$PREFIX/Contents/Frameworks -lmlt++ -lmlt
-    }
 }
 win32 {
     CONFIG += windows rtti
-    isEmpty(MLT_PATH) {
-        message("MLT_PATH not set; using ..\\..\\... You can change this with 'qmake MLT_PATH=...'")
-        MLT_PATH = ..\\..\\..
-    }
-    INCLUDEPATH += $$MLT_PATH\\include\\mlt++ $$MLT_PATH\\include\\mlt
-    LIBS += -L$$MLT_PATH\\lib -lmlt++ -lmlt -lopengl32
+    LIBS += -lopengl32
     CONFIG(debug, debug|release) {
         INCLUDEPATH += $$PWD/../drmingw/include
         LIBS += -L$$PWD/../drmingw/x64/lib -lexchndl
@@ -408,10 +414,7 @@ win32 {
     SOURCES += \
     windowstools.cpp
 }
-unix:!mac {
-    CONFIG += link_pkgconfig
-    PKGCONFIG += mlt++
-}
+include(mlt.pri)
 
 unix:!mac:isEmpty(PREFIX) {
     message("Install PREFIX not set; using /usr/local. You can change this with 'qmake PREFIX=...'")
@@ -1102,6 +1102,7 @@ void AvformatProducerWidget::on_reverseButton_clicked()
             MeltJob* meltJob = new MeltJob(filename, meltArgs,
                 m_producer->get_int("meta.media.frame_rate_num"), m_producer->get_int("meta.media.frame_rate_den"));
             meltJob->setLabel(tr("Reverse %1").arg(Util::baseName(resource)));
+            meltJob->setDependency(ffmpegJob);
 
             if (m_producer->get(kMultitrackItemProperty)) {
                 QString s = QString::fromLatin1(m_producer->get(kMultitrackItemProperty));
@@ -1174,6 +1175,7 @@ void AvformatProducerWidget::on_actionExtractSubclip_triggered()
         // Run the ffmpeg job.
         FfmpegJob* ffmpegJob = new FfmpegJob(filename, ffmpegArgs, false);
         ffmpegJob->setLabel(tr("Extract sub-clip %1").arg(Util::baseName(resource)));
+        ffmpegJob->setResourceClass(AbstractJob::ResourceIo);
         JOBS.add(ffmpegJob);
     }
 }
@@ -27,10 +27,8 @@
 #include <QMenu>
 #include <QLabel>
 #include <QTimer>
-#include <MltProfile.h>
 #include <math.h>
 #include "qmltypes/qmlutilities.h"
-#include "mltcontroller.h"
 #include "settings.h"
 
 static double onedec( double in )
@@ -38,24 +36,24 @@ static double onedec( double in )
 	return round( in * 10.0 ) / 10.0;
 }
 
-AudioLoudnessScopeWidget::AudioLoudnessScopeWidget()
+AudioLoudnessScopeWidget::AudioLoudnessScopeWidget(AudioScopeAnalyzer* analyzer)
   : ScopeWidget("AudioLoudnessMeter")
-  , m_loudnessFilter(0)
+  , m_mutex(QMutex::NonRecursive)
   , m_peak(-100)
   , m_true_peak(-100)
   , m_newData(false)
+  , m_analyzer(analyzer)
   , m_orientation((Qt::Orientation)-1)
   , m_qview(new QQuickWidget(QmlUtilities::sharedEngine(), this))
   , m_timeLabel(new QLabel(this))
 {
     LOG_DEBUG() << "begin";
-    m_loudnessFilter = new Mlt::Filter(MLT.profile(), "loudness_meter");
-    m_loudnessFilter->set("calc_program", Settings.loudnessScopeShowMeter("integrated"));
-    m_loudnessFilter->set("calc_shortterm", Settings.loudnessScopeShowMeter("shortterm"));
-    m_loudnessFilter->set("calc_momentary", Settings.loudnessScopeShowMeter("momentary"));
-    m_loudnessFilter->set("calc_range", Settings.loudnessScopeShowMeter("range"));
-    m_loudnessFilter->set("calc_peak", Settings.loudnessScopeShowMeter("peak"));
-    m_loudnessFilter->set("calc_true_peak", Settings.loudnessScopeShowMeter("truepeak"));
+    m_analyzer->setLoudnessEnabled("calc_program", Settings.loudnessScopeShowMeter("integrated"));
+    m_analyzer->setLoudnessEnabled("calc_shortterm", Settings.loudnessScopeShowMeter("shortterm"));
+    m_analyzer->setLoudnessEnabled("calc_momentary", Settings.loudnessScopeShowMeter("momentary"));
+    m_analyzer->setLoudnessEnabled("calc_range", Settings.loudnessScopeShowMeter("range"));
+    m_analyzer->setLoudnessEnabled("calc_peak", Settings.loudnessScopeShowMeter("peak"));
+    m_analyzer->setLoudnessEnabled("calc_true_peak", Settings.loudnessScopeShowMeter("truepeak"));
 
     setAutoFillBackground(true);
 
@@ -130,7 +128,6 @@ AudioLoudnessScopeWidget::AudioLoudnessScopeWidget()
 AudioLoudnessScopeWidget::~AudioLoudnessScopeWidget()
 {
     m_timer->stop();
-    delete m_loudnessFilter;
 }
 
 void AudioLoudnessScopeWidget::refreshScope(const QSize& /*size*/, bool /*full*/)
@@ -138,28 +135,22 @@ void AudioLoudnessScopeWidget::refreshScope(const QSize& /*size*/, bool /*full*/
     SharedFrame sFrame;
     while (m_queue.count() > 0) {
         sFrame = m_queue.pop();
-        if (sFrame.is_valid() && sFrame.get_audio_samples() > 0) {
-            mlt_audio_format format = mlt_audio_f32le;
-            int channels = sFrame.get_audio_channels();
-            int frequency = sFrame.get_audio_frequency();
-            int samples = sFrame.get_audio_samples();
-            if (channels && frequency && samples) {
-                Mlt::Frame mFrame = sFrame.clone(true, false, false);
-                m_loudnessFilter->process(mFrame);
-                mFrame.get_audio(format, frequency, channels, samples);
-                if( m_peak < m_loudnessFilter->get_double("peak") ) {
-                    m_peak = m_loudnessFilter->get_double("peak");
-                }
-                if( m_true_peak < m_loudnessFilter->get_double("true_peak") ) {
-                    m_true_peak = m_loudnessFilter->get_double("true_peak");
-                }
-                m_newData = true;
-            }
-        }
     }
 
-    // Update the time with every frame.
-    m_timeLabel->setText( m_loudnessFilter->get_time( "frames_processed" ) );
+    // The analyzer measures all of the audio since the previous frame, so
+    // the integrated loudness does not depend on how fast the scope keeps up.
+    AudioScopeAnalysis analysis = m_analyzer->analyze(sFrame, AudioScopeAnalysis::Loudness);
+    if (analysis.features & AudioScopeAnalysis::Loudness) {
+        QMutexLocker locker(&m_mutex);
+        m_analysis = analysis;
+        if( m_peak < analysis.peak ) {
+            m_peak = analysis.peak;
+        }
+        if( m_true_peak < analysis.truePeak ) {
+            m_true_peak = analysis.truePeak;
+        }
+        m_newData = true;
+    }
 }
 
 QString AudioLoudnessScopeWidget::getTitle()
@@ -212,7 +203,7 @@ void AudioLoudnessScopeWidget::setOrientation(Qt::Orientation orientation, bool
 
 void AudioLoudnessScopeWidget::onResetButtonClicked()
 {
-    m_loudnessFilter->set("reset", 1);
+    m_analyzer->resetLoudness();
     m_timeLabel->setText( "00:00:00:00" );
     setOrientation(m_orientation, true);
     resetQview();
@@ -220,7 +211,7 @@ void AudioLoudnessScopeWidget::onResetButtonClicked()
 
 void AudioLoudnessScopeWidget::onIntegratedToggled(bool checked)
 {
-    m_loudnessFilter->set("calc_program", checked);
+    m_analyzer->setLoudnessEnabled("calc_program", checked);
     Settings.setLoudnessScopeShowMeter("integrated", checked);
     setOrientation(m_orientation, true);
     resetQview();
@@ -228,7 +219,7 @@ void AudioLoudnessScopeWidget::onIntegratedToggled(bool checked)
 
 void AudioLoudnessScopeWidget::onShorttermToggled(bool checked)
 {
-    m_loudnessFilter->set("calc_shortterm", checked);
+    m_analyzer->setLoudnessEnabled("calc_shortterm", checked);
     Settings.setLoudnessScopeShowMeter("shortterm", checked);
     setOrientation(m_orientation, true);
     resetQview();
@@ -236,7 +227,7 @@ void AudioLoudnessScopeWidget::onShorttermToggled(bool checked)
 
 void AudioLoudnessScopeWidget::onMomentaryToggled(bool checked)
 {
-    m_loudnessFilter->set("calc_momentary", checked);
+    m_analyzer->setLoudnessEnabled("calc_momentary", checked);
     Settings.setLoudnessScopeShowMeter("momentary", checked);
     setOrientation(m_orientation, true);
     resetQview();
@@ -244,7 +235,7 @@ void AudioLoudnessScopeWidget::onMomentaryToggled(bool checked)
 
 void AudioLoudnessScopeWidget::onRangeToggled(bool checked)
 {
-    m_loudnessFilter->set("calc_range", checked);
+    m_analyzer->setLoudnessEnabled("calc_range", checked);
     Settings.setLoudnessScopeShowMeter("range", checked);
     setOrientation(m_orientation, true);
     resetQview();
@@ -252,7 +243,7 @@ void AudioLoudnessScopeWidget::onRangeToggled(bool checked)
 
 void AudioLoudnessScopeWidget::onPeakToggled(bool checked)
 {
-    m_loudnessFilter->set("calc_peak", checked);
+    m_analyzer->setLoudnessEnabled("calc_peak", checked);
     Settings.setLoudnessScopeShowMeter("peak", checked);
     setOrientation(m_orientation, true);
     resetQview();
@@ -260,7 +251,7 @@ void AudioLoudnessScopeWidget::onPeakToggled(bool checked)
 
 void AudioLoudnessScopeWidget::onTruePeakToggled(bool checked)
 {
-    m_loudnessFilter->set("calc_true_peak", checked);
+    m_analyzer->setLoudnessEnabled("calc_true_peak", checked);
     Settings.setLoudnessScopeShowMeter("truepeak", checked);
     setOrientation(m_orientation, true);
     resetQview();
@@ -268,19 +259,21 @@ void AudioLoudnessScopeWidget::onTruePeakToggled(bool checked)
 
 void AudioLoudnessScopeWidget::updateMeters(void)
 {
+    QMutexLocker locker(&m_mutex);
     if (!m_newData) return;
-    if (m_loudnessFilter->get_int("calc_program") )
-        m_qview->rootObject()->setProperty("integrated", onedec(m_loudnessFilter->get_double("program")));
-    if (m_loudnessFilter->get_int("calc_shortterm") )
-        m_qview->rootObject()->setProperty("shortterm", onedec(m_loudnessFilter->get_double("shortterm")));
-    if (m_loudnessFilter->get_int("calc_momentary") )
-        m_qview->rootObject()->setProperty("momentary", onedec(m_loudnessFilter->get_double("momentary")));
-    if (m_loudnessFilter->get_int("calc_range") )
-        m_qview->rootObject()->setProperty("range", onedec(m_loudnessFilter->get_double("range")));
-    if (m_loudnessFilter->get_int("calc_peak") )
+    if (Settings.loudnessScopeShowMeter("integrated"))
+        m_qview->rootObject()->setProperty("integrated", onedec(m_analysis.integrated));
+    if (Settings.loudnessScopeShowMeter("shortterm"))
+        m_qview->rootObject()->setProperty("shortterm", onedec(m_analysis.shortTerm));
+    if (Settings.loudnessScopeShowMeter("momentary"))
+        m_qview->rootObject()->setProperty("momentary", onedec(m_analysis.momentary));
+    if (Settings.loudnessScopeShowMeter("range"))
+        m_qview->rootObject()->setProperty("range", onedec(m_analysis.range));
+    if (Settings.loudnessScopeShowMeter("peak"))
         m_qview->rootObject()->setProperty("peak", onedec(m_peak));
-    if (m_loudnessFilter->get_int("calc_true_peak") )
+    if (Settings.loudnessScopeShowMeter("truepeak"))
         m_qview->rootObject()->setProperty("truePeak", onedec(m_true_peak));
+    m_timeLabel->setText(m_analysis.loudnessTime);
     m_peak = -100;
     m_true_peak = -100;
     m_newData = false;
@@ -20,10 +20,10 @@
 #define AUDIOLOUDNESSSCOPEWIDGET_H
 
 #include "scopewidget.h"
+#include "audioscopeanalyzer.h"
 #include <QMutex>
 #include <QImage>
 #include <QVector>
-#include <MltFilter.h>
 
 class QQuickWidget;
 class QLabel;
@@ -34,7 +34,7 @@ class AudioLoudnessScopeWidget Q_DECL_FINAL : public ScopeWidget
     Q_OBJECT
     
 public:
-    explicit AudioLoudnessScopeWidget();
+    explicit AudioLoudnessScopeWidget(AudioScopeAnalyzer* analyzer);
     ~AudioLoudnessScopeWidget();
     QString getTitle() Q_DECL_OVERRIDE;
     void setOrientation(Qt::Orientation orientation) Q_DECL_OVERRIDE;
@@ -58,13 +58,15 @@ private:
     // Functions run in scope thread.
     void refreshScope(const QSize& size, bool full) Q_DECL_OVERRIDE;
 
-    // Members accessed by scope thread.
-    Mlt::Filter* m_loudnessFilter;
+    // Members accessed by scope thread and GUI thread (mutex protected).
+    QMutex m_mutex;
+    AudioScopeAnalysis m_analysis;
     double m_peak;
     double m_true_peak;
     bool m_newData;
 
     // Members accessed by GUI thread.
+    AudioScopeAnalyzer* m_analyzer;
     Qt::Orientation m_orientation;
     QQuickWidget* m_qview;
     QLabel* m_timeLabel;
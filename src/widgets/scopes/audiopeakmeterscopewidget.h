@@ -20,10 +20,10 @@
 #define AUDIOPEAKMETERSCOPEWIDGET_H
 
 #include "scopewidget.h"
+#include "audioscopeanalyzer.h"
 #include <QMutex>
 #include <QImage>
 #include <QVector>
-#include <MltFilter.h>
 
 class AudioMeterWidget;
 
@@ -32,7 +32,7 @@ class AudioPeakMeterScopeWidget Q_DECL_FINAL : public ScopeWidget
     Q_OBJECT
     
 public:
-    explicit AudioPeakMeterScopeWidget();
+    explicit AudioPeakMeterScopeWidget(AudioScopeAnalyzer* analyzer);
     ~AudioPeakMeterScopeWidget();
     QString getTitle() Q_DECL_OVERRIDE;
     void setOrientation(Qt::Orientation orientation) Q_DECL_OVERRIDE;
@@ -42,7 +42,7 @@ private:
     void refreshScope(const QSize& size, bool full) Q_DECL_OVERRIDE;
 
     // Members accessed by scope thread.
-    Mlt::Filter* m_filter;
+    AudioScopeAnalyzer* m_analyzer;
 
     // Members accessed by GUI thread.
     AudioMeterWidget* m_audioMeter;
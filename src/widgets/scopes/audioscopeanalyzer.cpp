@@ -0,0 +1,197 @@
+/*
+ * Copyright (c) 2021 Meltytech, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "audioscopeanalyzer.h"
+#include "mltcontroller.h"
+#include "shotcut_mlt_properties.h"
+#include <Logger.h>
+#include <QMutexLocker>
+#include <MltProfile.h>
+#include <algorithm>
+#include <cmath>
+
+typedef AudioScopeAnalysis::Features Features;
+
+static const int kFftWindowSize = 8000; // 6 Hz FFT bins at 48kHz
+
+AudioScopeAnalyzer::AudioScopeAnalyzer(AudioTap* audioTap)
+    : m_mutex(QMutex::NonRecursive)
+    , m_busy(false)
+    , m_sequence(0)
+    , m_requestedFeatures(AudioScopeAnalysis::NoFeatures)
+    , m_previousFeatures(AudioScopeAnalysis::NoFeatures)
+    , m_audioReader(audioTap)
+    , m_block(nullptr)
+    , m_loudnessSeconds(0.0)
+{
+    Mlt::Profile profile;
+    m_fftFilter = new Mlt::Filter(profile, "fft");
+    m_fftFilter->set("window_size", kFftWindowSize);
+    m_loudnessFilter = new Mlt::Filter(MLT.profile(), "loudness_meter");
+}
+
+AudioScopeAnalyzer::~AudioScopeAnalyzer()
+{
+    delete m_block;
+    delete m_fftFilter;
+    delete m_loudnessFilter;
+}
+
+AudioScopeAnalysis AudioScopeAnalyzer::analyze(const SharedFrame& frame, Features features)
+{
+    if (!frame.is_valid()) {
+        return AudioScopeAnalysis();
+    }
+
+    QMutexLocker locker(&m_mutex);
+    while (m_busy) {
+        m_idleCondition.wait(&m_mutex);
+    }
+
+    AudioScopeAnalysis analysis;
+    Features missing = features;
+    // Each scope takes the latest frame from its own queue, so one may be a
+    // frame behind the others. Only a frame shown later than the last is new.
+    qint64 sequence = frame.get_int64(kDisplaySequenceProperty);
+    bool isNewFrame = sequence? sequence > m_sequence : m_frame != frame;
+    if (!isNewFrame) {
+        m_requestedFeatures |= features;
+        missing &= ~m_analysis.features;
+        if (!missing || !m_block) {
+            return m_analysis;
+        }
+        // A scope that was not asking before. Add its part to the result.
+        analysis = m_analysis;
+    } else {
+        // Also compute what the other scopes asked for in the last two
+        // frames. Besides having their part ready, this keeps the FFT and
+        // loudness fed while their scope skips a frame.
+        missing |= m_requestedFeatures | m_previousFeatures;
+        m_previousFeatures = m_requestedFeatures;
+        m_requestedFeatures = features;
+    }
+    m_busy = true;
+    locker.unlock();
+
+    if (isNewFrame) {
+        delete m_block;
+        m_block = nullptr;
+        Mlt::Frame block = m_audioReader.read();
+        if (block.is_valid()) {
+            m_block = new Mlt::Frame(block);
+            analysis.channels = block.get_int("audio_channels");
+            analysis.frequency = block.get_int("audio_frequency");
+            analysis.samples = block.get_int("audio_samples");
+        }
+    }
+    if (m_block) {
+        if (missing & AudioScopeAnalysis::Levels)
+            computeLevels(analysis);
+        if (missing & (AudioScopeAnalysis::Spectrum | AudioScopeAnalysis::Loudness))
+            computeFiltered(missing, analysis);
+    }
+
+    locker.relock();
+    if (isNewFrame) {
+        m_frame = frame;
+        m_sequence = sequence;
+    }
+    m_analysis = analysis;
+    m_busy = false;
+    m_idleCondition.wakeAll();
+    return analysis;
+}
+
+void AudioScopeAnalyzer::setLoudnessEnabled(const char* name, bool enabled)
+{
+    QMutexLocker locker(&m_loudnessMutex);
+    m_loudnessFilter->set(name, enabled);
+}
+
+void AudioScopeAnalyzer::resetLoudness()
+{
+    QMutexLocker locker(&m_loudnessMutex);
+    m_loudnessFilter->set("reset", 1);
+    m_loudnessSeconds = 0.0;
+}
+
+void AudioScopeAnalyzer::computeLevels(AudioScopeAnalysis& analysis)
+{
+    mlt_audio_format format = mlt_audio_s16;
+    int channels = analysis.channels;
+    int frequency = analysis.frequency;
+    int samples = analysis.samples;
+    const int16_t* pcm = static_cast<const int16_t*>(m_block->get_audio(format, frequency, channels, samples));
+    if (!pcm || channels <= 0 || samples <= 0)
+        return;
+
+    analysis.peaks.fill(0.0, channels);
+    analysis.rms.fill(0.0, channels);
+    for (int c = 0; c < channels; c++) {
+        int peak = 0;
+        double sum = 0.0;
+        const int16_t* src = pcm + c;
+        for (int i = 0; i < samples; i++, src += channels) {
+            int sample = *src;
+            peak = qMax(peak, qAbs(sample));
+            sum += double(sample) * sample;
+        }
+        analysis.peaks[c] = qMin(1.0, peak / 32768.0);
+        analysis.rms[c] = std::sqrt(sum / samples) / 32768.0;
+    }
+    analysis.features |= AudioScopeAnalysis::Levels;
+}
+
+// Runs the audio through the MLT filters of the requested \a features at once.
+void AudioScopeAnalyzer::computeFiltered(Features features, AudioScopeAnalysis& analysis)
+{
+    QMutexLocker locker(&m_loudnessMutex);
+    if (features & AudioScopeAnalysis::Spectrum)
+        m_fftFilter->process(*m_block);
+    if (features & AudioScopeAnalysis::Loudness)
+        m_loudnessFilter->process(*m_block);
+    mlt_audio_format format = mlt_audio_f32le;
+    int channels = analysis.channels;
+    int frequency = analysis.frequency;
+    int samples = analysis.samples;
+    m_block->get_audio(format, frequency, channels, samples);
+
+    if (features & AudioScopeAnalysis::Spectrum) {
+        const float* bins = static_cast<const float*>(m_fftFilter->get_data("bins"));
+        int binCount = m_fftFilter->get_int("bin_count");
+        if (bins && binCount > 0) {
+            analysis.bins.resize(binCount);
+            std::copy(bins, bins + binCount, analysis.bins.begin());
+            analysis.binWidth = m_fftFilter->get_double("bin_width");
+        }
+        analysis.features |= AudioScopeAnalysis::Spectrum;
+    }
+    if (features & AudioScopeAnalysis::Loudness) {
+        if (analysis.frequency > 0)
+            m_loudnessSeconds += double(analysis.samples) / analysis.frequency;
+        analysis.momentary = m_loudnessFilter->get_double("momentary");
+        analysis.shortTerm = m_loudnessFilter->get_double("shortterm");
+        analysis.integrated = m_loudnessFilter->get_double("program");
+        analysis.range = m_loudnessFilter->get_double("range");
+        analysis.peak = m_loudnessFilter->get_double("peak");
+        analysis.truePeak = m_loudnessFilter->get_double("true_peak");
+        // The filter counts blocks rather than frames, so time the samples.
+        int frames = qRound(m_loudnessSeconds * MLT.profile().fps());
+        analysis.loudnessTime = QString::fromLatin1(m_loudnessFilter->frames_to_time(frames));
+        analysis.features |= AudioScopeAnalysis::Loudness;
+    }
+}
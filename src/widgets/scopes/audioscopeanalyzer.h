@@ -0,0 +1,139 @@
+/*
+ * Copyright (c) 2021 Meltytech, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef AUDIOSCOPEANALYZER_H
+#define AUDIOSCOPEANALYZER_H
+
+#include "sharedframe.h"
+#include "audiotap.h"
+#include <QFlags>
+#include <QMutex>
+#include <QString>
+#include <QVector>
+#include <QWaitCondition>
+#include <MltFilter.h>
+
+/*!
+  \class AudioScopeAnalysis
+  \brief The data computed for the audio scopes from the audio of one frame.
+
+  Members for features that were not computed are empty or zero.
+*/
+
+class AudioScopeAnalysis
+{
+public:
+    enum Feature {
+        NoFeatures  = 0,
+        Levels      = 1 << 0, //!< peaks and rms
+        Spectrum    = 1 << 1, //!< bins and binWidth
+        Loudness    = 1 << 2, //!< the EBU R128 members
+        AllFeatures = (1 << 3) - 1
+    };
+    Q_DECLARE_FLAGS(Features, Feature)
+
+    AudioScopeAnalysis()
+        : features(NoFeatures)
+        , channels(0)
+        , frequency(0)
+        , samples(0)
+        , binWidth(0.0)
+        , momentary(0.0)
+        , shortTerm(0.0)
+        , integrated(0.0)
+        , range(0.0)
+        , peak(0.0)
+        , truePeak(0.0)
+    {}
+
+    Features features;
+    int channels;
+    int frequency;
+    int samples; //!< samples per channel since the previous analysis
+    QVector<double> peaks; //!< linear peak of each channel, 1.0 is full scale
+    QVector<double> rms;   //!< linear RMS of each channel, 1.0 is full scale
+    QVector<float> bins;   //!< FFT magnitudes of the windowed audio
+    double binWidth;       //!< Hz per bin
+    double momentary;      //!< LUFS
+    double shortTerm;      //!< LUFS
+    double integrated;     //!< LUFS since the last reset
+    double range;          //!< LU since the last reset
+    double peak;           //!< dBFS
+    double truePeak;       //!< dBTP
+    QString loudnessTime;  //!< duration measured since the last reset
+};
+
+Q_DECLARE_OPERATORS_FOR_FLAGS(AudioScopeAnalysis::Features)
+
+/*!
+  \class AudioScopeAnalyzer
+  \brief Computes the data for all of the audio scopes once per frame.
+
+  \threadsafe
+
+  The audio scopes call analyze() from their refresh threads. The first call
+  for a frame reads the audio that was shown since the previous frame from
+  the AudioTap and runs it once through the level, FFT and loudness stages
+  that any scope asked for recently. The other scopes wait for that result
+  and take their part of it. A scope that is behind gets the result of the
+  newest frame. The FFT window and the loudness measurement
+  therefore see every sample exactly once, however many scopes are open.
+*/
+
+class AudioScopeAnalyzer
+{
+public:
+    explicit AudioScopeAnalyzer(AudioTap* audioTap);
+    ~AudioScopeAnalyzer();
+
+    /*!
+      Returns the analysis of the audio up to \a frame with at least
+      \a features computed. This blocks while another scope's analysis is in
+      progress.
+    */
+    AudioScopeAnalysis analyze(const SharedFrame& frame, AudioScopeAnalysis::Features features);
+
+    //! Sets a "calc_" property of the loudness measurement, e.g. "calc_range".
+    void setLoudnessEnabled(const char* name, bool enabled);
+    //! Restarts the loudness measurement.
+    void resetLoudness();
+
+private:
+    void computeLevels(AudioScopeAnalysis& analysis);
+    void computeFiltered(AudioScopeAnalysis::Features features, AudioScopeAnalysis& analysis);
+
+    QMutex m_mutex;
+    QWaitCondition m_idleCondition;
+    bool m_busy;
+    SharedFrame m_frame;
+    qint64 m_sequence;
+    AudioScopeAnalysis m_analysis;
+    AudioScopeAnalysis::Features m_requestedFeatures;
+    AudioScopeAnalysis::Features m_previousFeatures;
+
+    // Members used only by the analyzing thread
+    AudioTapReader m_audioReader;
+    Mlt::Frame* m_block;
+    Mlt::Filter* m_fftFilter;
+
+    // The loudness filter is also configured from the GUI thread.
+    QMutex m_loudnessMutex;
+    Mlt::Filter* m_loudnessFilter;
+    double m_loudnessSeconds;
+};
+
+#endif // AUDIOSCOPEANALYZER_H
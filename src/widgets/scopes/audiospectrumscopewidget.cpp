@@ -22,11 +22,8 @@
 #include <QPainter>
 #include <QtAlgorithms>
 #include <QVBoxLayout>
-#include <MltProfile.h>
 #include <cmath>
 
-static const int WINDOW_SIZE = 8000; // 6 Hz FFT bins at 48kHz
-
 struct band
 {
     float low;    // Low frequency
@@ -89,8 +86,9 @@ static const int FIRST_AUDIBLE_BAND_INDEX = 12;
 static const int LAST_AUDIBLE_BAND_INDEX = 42;
 static const int AUDIBLE_BAND_COUNT = LAST_AUDIBLE_BAND_INDEX - FIRST_AUDIBLE_BAND_INDEX + 1;
 
-AudioSpectrumScopeWidget::AudioSpectrumScopeWidget()
+AudioSpectrumScopeWidget::AudioSpectrumScopeWidget(AudioScopeAnalyzer* analyzer)
   : ScopeWidget("AudioSpectrum")
+  , m_analyzer(analyzer)
   , m_audioMeter(0)
 {
     LOG_DEBUG() << "begin";
@@ -98,11 +96,6 @@ AudioSpectrumScopeWidget::AudioSpectrumScopeWidget()
     // Setup this widget
     qRegisterMetaType< QVector<double> >("QVector<double>");
 
-    // Create the FFT filter
-    Mlt::Profile profile;
-    m_filter = new Mlt::Filter(profile, "fft");
-    m_filter->set("window_size", WINDOW_SIZE);
-
     // Add the audio signal widget
     QVBoxLayout *vlayout = new QVBoxLayout(this);
     vlayout->setContentsMargins(4, 4, 4, 4);
@@ -131,15 +124,14 @@ AudioSpectrumScopeWidget::AudioSpectrumScopeWidget()
 
 AudioSpectrumScopeWidget::~AudioSpectrumScopeWidget()
 {
-    delete m_filter;
 }
 
-void AudioSpectrumScopeWidget::processSpectrum()
+void AudioSpectrumScopeWidget::processSpectrum(const AudioScopeAnalysis& analysis)
 {
     QVector<double> bands(AUDIBLE_BAND_COUNT);
-    float* bins = (float*)m_filter->get_data("bins");
-    int bin_count = m_filter->get_int("bin_count");
-    double bin_width = m_filter->get_double("bin_width");
+    const float* bins = analysis.bins.constData();
+    int bin_count = analysis.bins.size();
+    double bin_width = analysis.binWidth;
 
     int band = 0;
     bool firstBandFound = false;
@@ -185,25 +177,14 @@ void AudioSpectrumScopeWidget::processSpectrum()
 
 void AudioSpectrumScopeWidget::refreshScope(const QSize& /*size*/, bool /*full*/)
 {
-    bool refresh = false;
     SharedFrame sFrame;
-
     while (m_queue.count() > 0) {
         sFrame = m_queue.pop();
-        if (sFrame.is_valid() && sFrame.get_audio_samples() > 0) {
-            mlt_audio_format format = mlt_audio_s16;
-            int channels = sFrame.get_audio_channels();
-            int frequency = sFrame.get_audio_frequency();
-            int samples = sFrame.get_audio_samples();
-            Mlt::Frame mFrame = sFrame.clone(true, false, false);
-            m_filter->process(mFrame);
-            mFrame.get_audio( format, frequency, channels, samples );
-            refresh = true;
-        }
     }
 
-    if (refresh) {
-        processSpectrum();
+    AudioScopeAnalysis analysis = m_analyzer->analyze(sFrame, AudioScopeAnalysis::Spectrum);
+    if (analysis.features & AudioScopeAnalysis::Spectrum) {
+        processSpectrum(analysis);
     }
 }
 
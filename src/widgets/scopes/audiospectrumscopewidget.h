@@ -21,7 +21,7 @@
 
 
 #include "scopewidget.h"
-#include <MltFilter.h>
+#include "audioscopeanalyzer.h"
 
 class AudioMeterWidget;
 
@@ -30,17 +30,17 @@ class AudioSpectrumScopeWidget Q_DECL_FINAL : public ScopeWidget
     Q_OBJECT
     
 public:
-    explicit AudioSpectrumScopeWidget();
+    explicit AudioSpectrumScopeWidget(AudioScopeAnalyzer* analyzer);
     ~AudioSpectrumScopeWidget();
     QString getTitle() Q_DECL_OVERRIDE;
 
 private:
     // Functions run in scope thread.
     void refreshScope(const QSize& size, bool full) Q_DECL_OVERRIDE;
-    void processSpectrum();
+    void processSpectrum(const AudioScopeAnalysis& analysis);
 
     // Members accessed by scope thread.
-    Mlt::Filter* m_filter;
+    AudioScopeAnalyzer* m_analyzer;
 
     // Members accessed only in the GUI thread
     AudioMeterWidget* m_audioMeter;
@@ -0,0 +1,240 @@
+/*
+ * Copyright (c) 2021 Meltytech, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "scopedensitydisplay.h"
+#include <Logger.h>
+#include <QOpenGLContext>
+#include <QOpenGLShaderProgram>
+#include <QVector2D>
+#include <QVector>
+
+enum { DensityTexture = 0, GraticuleTexture };
+
+ScopeDensityDisplay::ScopeDensityDisplay(QWidget* parent)
+    : QOpenGLWidget(parent)
+    , m_shader(nullptr)
+    , m_densityLocation(-1)
+    , m_graticuleLocation(-1)
+    , m_plusLocation(-1)
+    , m_vertexLocation(-1)
+    , m_texCoordLocation(-1)
+    , m_maxTextureSize(0)
+    , m_compositionMode(CompositionModeSourceOver)
+    , m_isGraticuleChanged(false)
+    , m_mutex(QMutex::NonRecursive)
+    , m_isDensityChanged(false)
+{
+    m_texture[DensityTexture] = m_texture[GraticuleTexture] = 0;
+    // The scope shows the tooltips.
+    setAttribute(Qt::WA_TransparentForMouseEvents);
+}
+
+ScopeDensityDisplay::~ScopeDensityDisplay()
+{
+    cleanup();
+}
+
+void ScopeDensityDisplay::setCompositionMode(CompositionMode mode)
+{
+    m_compositionMode = mode;
+    update();
+}
+
+void ScopeDensityDisplay::setDensity(const QImage& density)
+{
+    m_mutex.lock();
+    m_density = density;
+    m_isDensityChanged = true;
+    m_mutex.unlock();
+    QMetaObject::invokeMethod(this, "update", Qt::QueuedConnection);
+}
+
+QImage ScopeDensityDisplay::newGraticule() const
+{
+    qreal ratio = devicePixelRatioF();
+    QImage graticule(size() * ratio, QImage::Format_RGBA8888_Premultiplied);
+    graticule.setDevicePixelRatio(ratio);
+    graticule.fill(Qt::transparent);
+    return graticule;
+}
+
+void ScopeDensityDisplay::setGraticule(const QImage& graticule)
+{
+    m_graticule = graticule;
+    m_isGraticuleChanged = true;
+    update();
+}
+
+void ScopeDensityDisplay::initializeGL()
+{
+    initializeOpenGLFunctions();
+    connect(context(), SIGNAL(aboutToBeDestroyed()), SLOT(cleanup()), Qt::DirectConnection);
+
+    m_shader = new QOpenGLShaderProgram;
+    m_shader->addShaderFromSourceCode(QOpenGLShader::Vertex,
+                                     "attribute highp vec4 vertex;"
+                                     "attribute highp vec2 texCoord;"
+                                     "varying highp vec2 coordinates;"
+                                     "void main(void) {"
+                                     "  gl_Position = vertex;"
+                                     "  coordinates = texCoord;"
+                                     "}");
+    // The graticule is premultiplied.
+    m_shader->addShaderFromSourceCode(QOpenGLShader::Fragment,
+                                      "uniform sampler2D density, graticule;"
+                                      "uniform lowp int plus;"
+                                      "varying highp vec2 coordinates;"
+                                      "void main(void) {"
+                                      "  lowp vec3 trace = texture2D(density, coordinates).rgb;"
+                                      "  lowp vec4 lines = texture2D(graticule, coordinates);"
+                                      "  if (plus == 1)"
+                                      "    gl_FragColor = vec4(min(trace + lines.rgb, 1.0), 1.0);"
+                                      "  else"
+                                      "    gl_FragColor = vec4(trace * (1.0 - lines.a) + lines.rgb, 1.0);"
+                                      "}");
+    if (!m_shader->link()) {
+        LOG_ERROR() << "failed to link the scope shader" << m_shader->log();
+    }
+    m_densityLocation = m_shader->uniformLocation("density");
+    m_graticuleLocation = m_shader->uniformLocation("graticule");
+    m_plusLocation = m_shader->uniformLocation("plus");
+    m_vertexLocation = m_shader->attributeLocation("vertex");
+    m_texCoordLocation = m_shader->attributeLocation("texCoord");
+
+    glGetIntegerv(GL_MAX_TEXTURE_SIZE, &m_maxTextureSize);
+    glGenTextures(2, m_texture);
+    for (int i = 0; i < 2; ++i) {
+        glBindTexture  (GL_TEXTURE_2D, m_texture[i]);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        m_textureSize[i] = QSize();
+    }
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    // A new context, e.g. after the dock was floated, has empty textures.
+    QImage black(1, 1, QImage::Format_RGBX8888);
+    black.fill(Qt::black);
+    upload(m_texture[DensityTexture], black, m_textureSize[DensityTexture]);
+    QImage transparent(1, 1, QImage::Format_RGBA8888_Premultiplied);
+    transparent.fill(Qt::transparent);
+    upload(m_texture[GraticuleTexture], transparent, m_textureSize[GraticuleTexture]);
+    m_isGraticuleChanged = !m_graticule.isNull();
+    m_mutex.lock();
+    m_isDensityChanged = !m_density.isNull();
+    m_mutex.unlock();
+}
+
+void ScopeDensityDisplay::paintGL()
+{
+    if (!m_shader || !m_shader->isLinked())
+        return;
+
+    m_mutex.lock();
+    QImage density;
+    if (m_isDensityChanged) {
+        density = m_density;
+        m_isDensityChanged = false;
+    }
+    m_mutex.unlock();
+    if (!density.isNull())
+        upload(m_texture[DensityTexture], density, m_textureSize[DensityTexture]);
+    if (m_isGraticuleChanged) {
+        upload(m_texture[GraticuleTexture], m_graticule, m_textureSize[GraticuleTexture]);
+        m_isGraticuleChanged = false;
+    }
+
+    glViewport(0, 0, width() * devicePixelRatioF(), height() * devicePixelRatioF());
+    glDisable(GL_BLEND);
+    glActiveTexture(GL_TEXTURE0 + DensityTexture);
+    glBindTexture(GL_TEXTURE_2D, m_texture[DensityTexture]);
+    glActiveTexture(GL_TEXTURE0 + GraticuleTexture);
+    glBindTexture(GL_TEXTURE_2D, m_texture[GraticuleTexture]);
+
+    m_shader->bind();
+    m_shader->setUniformValue(m_densityLocation, DensityTexture);
+    m_shader->setUniformValue(m_graticuleLocation, GraticuleTexture);
+    m_shader->setUniformValue(m_plusLocation, m_compositionMode == CompositionModePlus? 1 : 0);
+
+    // Cover the display; the first image row is at the top.
+    QVector<QVector2D> vertices;
+    vertices << QVector2D(-1.0f, -1.0f);
+    vertices << QVector2D(-1.0f, 1.0f);
+    vertices << QVector2D(1.0f, -1.0f);
+    vertices << QVector2D(1.0f, 1.0f);
+    m_shader->enableAttributeArray(m_vertexLocation);
+    m_shader->setAttributeArray(m_vertexLocation, vertices.constData());
+    QVector<QVector2D> texCoord;
+    texCoord << QVector2D(0.0f, 1.0f);
+    texCoord << QVector2D(0.0f, 0.0f);
+    texCoord << QVector2D(1.0f, 1.0f);
+    texCoord << QVector2D(1.0f, 0.0f);
+    m_shader->enableAttributeArray(m_texCoordLocation);
+    m_shader->setAttributeArray(m_texCoordLocation, texCoord.constData());
+
+    glDrawArrays(GL_TRIANGLE_STRIP, 0, vertices.size());
+
+    m_shader->disableAttributeArray(m_vertexLocation);
+    m_shader->disableAttributeArray(m_texCoordLocation);
+    m_shader->release();
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+void ScopeDensityDisplay::cleanup()
+{
+    if (!m_shader)
+        return;
+    makeCurrent();
+    glDeleteTextures(2, m_texture);
+    m_texture[DensityTexture] = m_texture[GraticuleTexture] = 0;
+    delete m_shader;
+    m_shader = nullptr;
+    doneCurrent();
+}
+
+// Replaces the contents of the texture and only reallocates it when the size
+// of the image changes.
+void ScopeDensityDisplay::upload(GLuint texture, const QImage& source, QSize& textureSize)
+{
+    // The analyzer makes the density no wider than the display, but do not
+    // let a texture that is too large leave the scope blank.
+    QImage image = source;
+    if (m_maxTextureSize > 0 && (image.width() > m_maxTextureSize || image.height() > m_maxTextureSize)) {
+        image = image.scaled(qMin(image.width(), m_maxTextureSize), qMin(image.height(), m_maxTextureSize),
+                             Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+    }
+    // Format_RGBX8888 and Format_RGBA8888_Premultiplied are RGBA in memory.
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    if (textureSize != image.size()) {
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, image.width(), image.height(), 0,
+                     GL_RGBA, GL_UNSIGNED_BYTE, image.constBits());
+        textureSize = image.size();
+        GLenum error = glGetError();
+        if (error != GL_NO_ERROR) {
+            LOG_ERROR() << "failed to allocate the scope texture" << image.size() << "error" << error;
+            textureSize = QSize();
+        }
+    } else {
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, image.width(), image.height(),
+                        GL_RGBA, GL_UNSIGNED_BYTE, image.constBits());
+    }
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
@@ -0,0 +1,104 @@
+/*
+ * Copyright (c) 2021 Meltytech, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SCOPEDENSITYDISPLAY_H
+#define SCOPEDENSITYDISPLAY_H
+
+#include <QOpenGLWidget>
+#include <QOpenGLFunctions>
+#include <QImage>
+#include <QMutex>
+
+class QOpenGLShaderProgram;
+
+/*!
+  \class ScopeDensityDisplay
+  \brief The ScopeDensityDisplay shows the density image of a video scope
+  with its graticule on top, using the GPU.
+
+  The scope hands over the small density image that the VideoScopeAnalyzer
+  made (e.g. display width x 256 for a waveform) as it is. The image is
+  uploaded to a texture, and a shader stretches it to the size of the display
+  and blends the graticule over it. The graticule is drawn by the scope only when
+  its size or its contents change and is kept in a texture of its own.
+  Neither the refresh thread nor the GUI thread scales or composites images
+  per frame.
+
+  The display passes mouse events to its parent, which remains responsible
+  for tooltips.
+*/
+
+class ScopeDensityDisplay : public QOpenGLWidget, protected QOpenGLFunctions
+{
+    Q_OBJECT
+
+public:
+    enum CompositionMode {
+        CompositionModeSourceOver = 0, //!< The graticule covers the density
+        CompositionModePlus            //!< The graticule is added to the density
+    };
+
+    explicit ScopeDensityDisplay(QWidget* parent = nullptr);
+    virtual ~ScopeDensityDisplay();
+
+    void setCompositionMode(CompositionMode mode);
+
+    /*!
+      Shows the \a density image, which is stretched to the whole display.
+      The image must be of Format_RGBX8888. This may be called from any thread.
+    */
+    void setDensity(const QImage& density);
+
+    /*!
+      Returns a transparent, premultiplied image with the size and pixel ratio
+      of the display for the scope to draw its graticule into with QPainter.
+    */
+    QImage newGraticule() const;
+
+    //! Shows the \a graticule that was made from newGraticule().
+    void setGraticule(const QImage& graticule);
+
+protected:
+    void initializeGL() Q_DECL_OVERRIDE;
+    void paintGL() Q_DECL_OVERRIDE;
+
+private slots:
+    void cleanup();
+
+private:
+    void upload(GLuint texture, const QImage& image, QSize& textureSize);
+
+    QOpenGLShaderProgram* m_shader;
+    GLuint m_texture[2];
+    QSize m_textureSize[2];
+    int m_densityLocation;
+    int m_graticuleLocation;
+    int m_plusLocation;
+    int m_vertexLocation;
+    int m_texCoordLocation;
+    int m_maxTextureSize;
+    CompositionMode m_compositionMode;
+    QImage m_graticule;
+    bool m_isGraticuleChanged;
+
+    // Members accessed from multiple threads (mutex protected)
+    QMutex m_mutex;
+    QImage m_density;
+    bool m_isDensityChanged;
+};
+
+#endif // SCOPEDENSITYDISPLAY_H
@@ -0,0 +1,338 @@
+/*
+ * Copyright (c) 2021 Meltytech, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "scopekernels.h"
+#include <cmath>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define SCOPE_KERNELS_X86
+#include <immintrin.h>
+#endif
+
+// Each count brightens a density pixel by 1/17th until it saturates.
+static const uint16_t kMaxCount = 17;
+static const uint16_t kLevelStep = 0x0f;
+
+static inline uint8_t level(const uint16_t* counts, int i)
+{
+    if (!counts)
+        return 0;
+    uint16_t count = counts[i] < kMaxCount? counts[i] : kMaxCount;
+    return count * kLevelStep;
+}
+
+static inline void add(uint16_t* counter, int weight)
+{
+    unsigned int sum = *counter + weight;
+    *counter = sum < 0xffff? sum : 0xffff;
+}
+
+static void toneMapRowC(const uint16_t* r, const uint16_t* g, const uint16_t* b, int width, uint8_t* dst)
+{
+    for (int x = 0; x < width; x++) {
+        dst[0] = level(r, x);
+        dst[1] = level(g, x);
+        dst[2] = level(b, x);
+        dst[3] = 0xff;
+        dst += 4;
+    }
+}
+
+static void addCountsC(const uint16_t* src, int count, uint16_t* dst)
+{
+    for (int i = 0; i < count; i++) {
+        unsigned int sum = dst[i] + src[i];
+        dst[i] = sum < 0xffff? sum : 0xffff;
+    }
+}
+
+#ifdef SCOPE_KERNELS_X86
+
+__attribute__((target("sse2")))
+static void addCountsSse2(const uint16_t* src, int count, uint16_t* dst)
+{
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(dst + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_adds_epu16(a, b));
+    }
+    addCountsC(src + i, count - i, dst + i);
+}
+
+__attribute__((target("avx2")))
+static void addCountsAvx2(const uint16_t* src, int count, uint16_t* dst)
+{
+    int i = 0;
+    for (; i + 16 <= count; i += 16) {
+        __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+        __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(dst + i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), _mm256_adds_epu16(a, b));
+    }
+    addCountsSse2(src + i, count - i, dst + i);
+}
+
+__attribute__((target("sse2")))
+static inline __m128i levelsSse2(const uint16_t* counts)
+{
+    if (!counts)
+        return _mm_setzero_si128();
+    const __m128i maxCount = _mm_set1_epi16(kMaxCount);
+    const __m128i step = _mm_set1_epi16(kLevelStep);
+    __m128i lo = _mm_loadu_si128(reinterpret_cast<const __m128i*>(counts));
+    __m128i hi = _mm_loadu_si128(reinterpret_cast<const __m128i*>(counts + 8));
+    // min(count, kMaxCount) for unsigned 16-bit without SSE4.1
+    lo = _mm_sub_epi16(lo, _mm_subs_epu16(lo, maxCount));
+    hi = _mm_sub_epi16(hi, _mm_subs_epu16(hi, maxCount));
+    return _mm_packus_epi16(_mm_mullo_epi16(lo, step), _mm_mullo_epi16(hi, step));
+}
+
+__attribute__((target("sse2")))
+static void toneMapRowSse2(const uint16_t* r, const uint16_t* g, const uint16_t* b, int width, uint8_t* dst)
+{
+    const __m128i opaque = _mm_set1_epi8(char(0xff));
+    int x = 0;
+    for (; x + 16 <= width; x += 16) {
+        __m128i rv = levelsSse2(r? r + x : nullptr);
+        __m128i gv = levelsSse2(g? g + x : nullptr);
+        __m128i bv = levelsSse2(b? b + x : nullptr);
+        __m128i rgLo = _mm_unpacklo_epi8(rv, gv);
+        __m128i rgHi = _mm_unpackhi_epi8(rv, gv);
+        __m128i bxLo = _mm_unpacklo_epi8(bv, opaque);
+        __m128i bxHi = _mm_unpackhi_epi8(bv, opaque);
+        __m128i* out = reinterpret_cast<__m128i*>(dst + x * 4);
+        _mm_storeu_si128(out + 0, _mm_unpacklo_epi16(rgLo, bxLo));
+        _mm_storeu_si128(out + 1, _mm_unpackhi_epi16(rgLo, bxLo));
+        _mm_storeu_si128(out + 2, _mm_unpacklo_epi16(rgHi, bxHi));
+        _mm_storeu_si128(out + 3, _mm_unpackhi_epi16(rgHi, bxHi));
+    }
+    toneMapRowC(r? r + x : nullptr, g? g + x : nullptr, b? b + x : nullptr, width - x, dst + x * 4);
+}
+
+__attribute__((target("avx2")))
+static inline __m256i levelsAvx2(const uint16_t* counts)
+{
+    if (!counts)
+        return _mm256_setzero_si256();
+    const __m256i maxCount = _mm256_set1_epi16(kMaxCount);
+    const __m256i step = _mm256_set1_epi16(kLevelStep);
+    __m256i lo = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(counts));
+    __m256i hi = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(counts + 16));
+    lo = _mm256_mullo_epi16(_mm256_min_epu16(lo, maxCount), step);
+    hi = _mm256_mullo_epi16(_mm256_min_epu16(hi, maxCount), step);
+    // Packing works per 128-bit lane, so put the quadwords back in order.
+    return _mm256_permute4x64_epi64(_mm256_packus_epi16(lo, hi), 0xd8);
+}
+
+__attribute__((target("avx2")))
+static void toneMapRowAvx2(const uint16_t* r, const uint16_t* g, const uint16_t* b, int width, uint8_t* dst)
+{
+    const __m256i opaque = _mm256_set1_epi8(char(0xff));
+    int x = 0;
+    for (; x + 32 <= width; x += 32) {
+        __m256i rv = levelsAvx2(r? r + x : nullptr);
+        __m256i gv = levelsAvx2(g? g + x : nullptr);
+        __m256i bv = levelsAvx2(b? b + x : nullptr);
+        // Lane 0 holds pixels 0-15 and lane 1 pixels 16-31.
+        __m256i rgLo = _mm256_unpacklo_epi8(rv, gv);
+        __m256i rgHi = _mm256_unpackhi_epi8(rv, gv);
+        __m256i bxLo = _mm256_unpacklo_epi8(bv, opaque);
+        __m256i bxHi = _mm256_unpackhi_epi8(bv, opaque);
+        __m256i p0 = _mm256_unpacklo_epi16(rgLo, bxLo); // 0-3, 16-19
+        __m256i p1 = _mm256_unpackhi_epi16(rgLo, bxLo); // 4-7, 20-23
+        __m256i p2 = _mm256_unpacklo_epi16(rgHi, bxHi); // 8-11, 24-27
+        __m256i p3 = _mm256_unpackhi_epi16(rgHi, bxHi); // 12-15, 28-31
+        __m256i* out = reinterpret_cast<__m256i*>(dst + x * 4);
+        _mm256_storeu_si256(out + 0, _mm256_permute2x128_si256(p0, p1, 0x20));
+        _mm256_storeu_si256(out + 1, _mm256_permute2x128_si256(p2, p3, 0x20));
+        _mm256_storeu_si256(out + 2, _mm256_permute2x128_si256(p0, p1, 0x31));
+        _mm256_storeu_si256(out + 3, _mm256_permute2x128_si256(p2, p3, 0x31));
+    }
+    toneMapRowSse2(r? r + x : nullptr, g? g + x : nullptr, b? b + x : nullptr, width - x, dst + x * 4);
+}
+
+#endif // SCOPE_KERNELS_X86
+
+typedef void (*ToneMapRowFunction)(const uint16_t*, const uint16_t*, const uint16_t*, int, uint8_t*);
+typedef void (*AddCountsFunction)(const uint16_t*, int, uint16_t*);
+
+struct Dispatch
+{
+    ToneMapRowFunction toneMapRow;
+    AddCountsFunction addCounts;
+    const char* name;
+};
+
+static bool isSupported(ScopeKernels::InstructionSet instructionSet)
+{
+#ifdef SCOPE_KERNELS_X86
+    __builtin_cpu_init();
+    switch (instructionSet) {
+    case ScopeKernels::Avx2:
+        return __builtin_cpu_supports("avx2");
+    case ScopeKernels::Sse2:
+        return __builtin_cpu_supports("sse2");
+    case ScopeKernels::Portable:
+        return true;
+    }
+    return false;
+#else
+    return instructionSet == ScopeKernels::Portable;
+#endif
+}
+
+static Dispatch dispatchFor(ScopeKernels::InstructionSet instructionSet)
+{
+#ifdef SCOPE_KERNELS_X86
+    if (instructionSet == ScopeKernels::Avx2)
+        return {toneMapRowAvx2, addCountsAvx2, "avx2"};
+    if (instructionSet == ScopeKernels::Sse2)
+        return {toneMapRowSse2, addCountsSse2, "sse2"};
+#else
+    (void) instructionSet;
+#endif
+    return {toneMapRowC, addCountsC, "c"};
+}
+
+static Dispatch selectDispatch()
+{
+    if (isSupported(ScopeKernels::Avx2))
+        return dispatchFor(ScopeKernels::Avx2);
+    if (isSupported(ScopeKernels::Sse2))
+        return dispatchFor(ScopeKernels::Sse2);
+    return dispatchFor(ScopeKernels::Portable);
+}
+
+static Dispatch& dispatch()
+{
+    static Dispatch d = selectDispatch();
+    return d;
+}
+
+ScopeKernels::YuvToRgb ScopeKernels::yuvToRgb(int colorspace, bool fullRange)
+{
+    double kr = 0.299;
+    double kb = 0.114;
+    if (colorspace == 709) {
+        kr = 0.2126;
+        kb = 0.0722;
+    } else if (colorspace == 2020) {
+        kr = 0.2627;
+        kb = 0.0593;
+    }
+    double kg = 1.0 - kr - kb;
+    double yScale = fullRange? 1.0 : 255.0 / 219.0;
+    double cScale = fullRange? 1.0 : 255.0 / 224.0;
+    const double one = 65536.0;
+    YuvToRgb coefficients;
+    coefficients.y = int(std::lround(yScale * one));
+    coefficients.yOffset = fullRange? 0 : 16;
+    coefficients.rv = int(std::lround(2.0 * (1.0 - kr) * cScale * one));
+    coefficients.gu = int(std::lround(2.0 * kb * (1.0 - kb) / kg * cScale * one));
+    coefficients.gv = int(std::lround(2.0 * kr * (1.0 - kr) / kg * cScale * one));
+    coefficients.bu = int(std::lround(2.0 * (1.0 - kb) * cScale * one));
+    return coefficients;
+}
+
+static inline uint8_t clampToByte(int value)
+{
+    value >>= 16;
+    return value < 0? 0 : value > 255? 255 : value;
+}
+
+void ScopeKernels::yuv422ToRgbRow(const uint8_t* src, int x, int width, int step,
+                                  const YuvToRgb& coefficients, uint8_t* dst)
+{
+    for (int i = 0; i < width; i++, x += step) {
+        // Both pixels of a pair share the Cb and Cr after the first Y.
+        const uint8_t* pair = src + (x & ~1) * 2;
+        int y = (src[x * 2] - coefficients.yOffset) * coefficients.y + (1 << 15);
+        int u = pair[1] - 128;
+        int v = pair[3] - 128;
+        dst[0] = clampToByte(y + coefficients.rv * v);
+        dst[1] = clampToByte(y - coefficients.gu * u - coefficients.gv * v);
+        dst[2] = clampToByte(y + coefficients.bu * u);
+        dst += 3;
+    }
+}
+
+void ScopeKernels::histogramRow(const uint8_t* src, int width, int step, unsigned int* subBins)
+{
+    unsigned int* bins0 = subBins;
+    unsigned int* bins1 = subBins + 256;
+    unsigned int* bins2 = subBins + 512;
+    unsigned int* bins3 = subBins + 768;
+    int x = 0;
+    for (; x + 4 <= width; x += 4) {
+        bins0[src[0]]++;
+        bins1[src[step]]++;
+        bins2[src[step * 2]]++;
+        bins3[src[step * 3]]++;
+        src += step * 4;
+    }
+    for (; x < width; x++) {
+        bins0[*src]++;
+        src += step;
+    }
+}
+
+void ScopeKernels::reduceHistogram(const unsigned int* subBins, unsigned int* bins)
+{
+    for (int i = 0; i < 256; i++) {
+        bins[i] += subBins[i] + subBins[i + 256] + subBins[i + 512] + subBins[i + 768];
+    }
+}
+
+void ScopeKernels::waveformRow(const uint8_t* src, int width, int step, uint16_t* counts, int stride, int weight)
+{
+    for (int x = 0; x < width; x++) {
+        add(counts + (255 - *src) * stride + x, weight);
+        src += step;
+    }
+}
+
+void ScopeKernels::vectorscopeRow(const uint8_t* u, const uint8_t* v, int width, int step, uint16_t* counts, int weight)
+{
+    for (int x = 0; x < width; x++) {
+        add(counts + (255 - *v) * 256 + *u, weight);
+        u += step;
+        v += step;
+    }
+}
+
+void ScopeKernels::addCounts(const uint16_t* src, int count, uint16_t* dst)
+{
+    dispatch().addCounts(src, count, dst);
+}
+
+void ScopeKernels::toneMapRow(const uint16_t* r, const uint16_t* g, const uint16_t* b, int width, uint8_t* dst)
+{
+    dispatch().toneMapRow(r, g, b, width, dst);
+}
+
+const char* ScopeKernels::instructionSet()
+{
+    return dispatch().name;
+}
+
+bool ScopeKernels::setInstructionSet(InstructionSet instructionSet)
+{
+    if (!isSupported(instructionSet))
+        return false;
+    dispatch() = dispatchFor(instructionSet);
+    return true;
+}
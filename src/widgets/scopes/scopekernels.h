@@ -0,0 +1,120 @@
+/*
+ * Copyright (c) 2021 Meltytech, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SCOPEKERNELS_H
+#define SCOPEKERNELS_H
+
+#include <stdint.h>
+
+/*!
+  \class ScopeKernels
+  \brief The inner loops of the video scope analysis.
+
+  Histograms are counted into kSubHistograms interleaved tables of 256 bins
+  so that runs of equal values do not wait on their own previous store. The
+  density maps of the waveforms, parade and vectorscope are counted into
+  16-bit counters and turned into RGBX pixels once per frame by toneMapRow().
+
+  toneMapRow() and addCounts() have SSE2 and AVX2 versions that are selected
+  at run time from the CPU features, with a portable version for other CPUs.
+  The counting functions scatter their stores, which neither instruction set
+  can do, so they have only the portable version.
+
+  The counting functions take a step between samples so that they read the
+  planar and packed image formats in place. yuv422ToRgbRow() turns one row of
+  the player's packed 4:2:2 frames into RGB for the RGB scopes, so that a
+  frame does not need a whole RGB copy.
+*/
+
+class ScopeKernels
+{
+public:
+    enum { kSubHistograms = 4 };
+
+    enum InstructionSet {
+        Portable = 0,
+        Sse2,
+        Avx2
+    };
+
+    //! Y'CbCr to R'G'B' coefficients in 16.16 fixed point
+    struct YuvToRgb
+    {
+        int y;
+        int yOffset;
+        int rv;
+        int gu;
+        int gv;
+        int bu;
+    };
+
+    /*!
+      Returns the coefficients for the MLT \a colorspace (601, 709 or 2020)
+      in full or limited range.
+    */
+    static YuvToRgb yuvToRgb(int colorspace, bool fullRange);
+
+    /*!
+      Converts \a width pixels of packed 4:2:2 \a src (Y0 Cb Y1 Cr) into
+      RGB24 \a dst, starting at pixel \a x and taking every \a step-th pixel.
+    */
+    static void yuv422ToRgbRow(const uint8_t* src, int x, int width, int step,
+                               const YuvToRgb& coefficients, uint8_t* dst);
+
+    /*!
+      Counts \a width samples that are \a step bytes apart into \a subBins,
+      which holds kSubHistograms x 256 bins.
+    */
+    static void histogramRow(const uint8_t* src, int width, int step, unsigned int* subBins);
+
+    //! Adds the sub-histograms of \a subBins into the 256 \a bins.
+    static void reduceHistogram(const unsigned int* subBins, unsigned int* bins);
+
+    /*!
+      Adds \a weight for each of \a width samples that are \a step bytes
+      apart to 256 rows of \a counts that are \a stride counters apart, with
+      the value 255 in the first row. Counters saturate at 0xffff.
+    */
+    static void waveformRow(const uint8_t* src, int width, int step, uint16_t* counts, int stride, int weight);
+
+    /*!
+      Adds \a weight for each of \a width U/V pairs that are \a step bytes
+      apart to the 256 x 256 \a counts, with V = 255 in the first row.
+    */
+    static void vectorscopeRow(const uint8_t* u, const uint8_t* v, int width, int step, uint16_t* counts, int weight);
+
+    //! Adds \a count counters of \a src to \a dst, saturating at 0xffff.
+    static void addCounts(const uint16_t* src, int count, uint16_t* dst);
+
+    /*!
+      Converts \a width counters of each channel into RGBX pixels in \a dst.
+      A channel whose counters are null is black.
+    */
+    static void toneMapRow(const uint16_t* r, const uint16_t* g, const uint16_t* b, int width, uint8_t* dst);
+
+    //! Returns the name of the instruction set that is used.
+    static const char* instructionSet();
+
+    /*!
+      Uses the versions for \a instructionSet from now on and returns true,
+      or returns false if the CPU cannot run them. This is for tests and
+      benchmarks and must not be called while the kernels are in use.
+    */
+    static bool setInstructionSet(InstructionSet instructionSet);
+};
+
+#endif // SCOPEKERNELS_H
@@ -20,11 +20,44 @@
 #include <Logger.h>
 #include <QtConcurrent/QtConcurrent>
 
+ScopeStatistics::ScopeStatistics()
+    : framesReceived(0)
+    , framesDropped(0)
+    , refreshCount(0)
+    , totalRefreshNsecs(0)
+    , maxRefreshNsecs(0)
+    , refreshRate(0.0)
+{
+    for (int i = 0; i < DurationBinCount; i++)
+        durationBins[i] = 0;
+}
+
+int ScopeStatistics::durationBinLimit(int bin)
+{
+    return (bin < DurationBinCount - 1)? 1 << bin : 0;
+}
+
+QString ScopeStatistics::toString() const
+{
+    QStringList bins;
+    for (int i = 0; i < DurationBinCount; i++)
+        bins << QString::number(durationBins[i]);
+    double meanMs = refreshCount? totalRefreshNsecs / 1000000.0 / refreshCount : 0.0;
+    return QString("frames %1 dropped %2 refreshes %3 rate %4 Hz mean %5 ms max %6 ms histogram [%7]")
+            .arg(framesReceived).arg(framesDropped).arg(refreshCount)
+            .arg(refreshRate, 0, 'f', 1).arg(meanMs, 0, 'f', 2)
+            .arg(maxRefreshNsecs / 1000000.0, 0, 'f', 2).arg(bins.join(' '));
+}
+
 ScopeWidget::ScopeWidget(const QString& name)
   : QWidget()
-  , m_queue(3, DataQueue<SharedFrame>::OverflowModeDiscardOldest)
+  , m_queue(3, LockFreeDataQueue<SharedFrame>::OverflowModeDiscardOldest)
   , m_future()
   , m_refreshPending(false)
+  , m_refreshCount(0)
+  , m_framesReceived(0)
+  , m_framesDroppedBefore(0)
+  , m_refreshRate(0.0)
   , m_mutex(QMutex::NonRecursive)
   , m_forceRefresh(false)
   , m_size(0, 0)
@@ -38,8 +71,29 @@ ScopeWidget::~ScopeWidget()
 {
 }
 
+ScopeStatistics ScopeWidget::statistics()
+{
+    m_mutex.lock();
+    ScopeStatistics statistics = m_statistics;
+    m_mutex.unlock();
+    statistics.framesReceived = m_framesReceived;
+    statistics.framesDropped = m_queue.discardedCount() - m_framesDroppedBefore;
+    statistics.refreshRate = m_refreshRate;
+    return statistics;
+}
+
+void ScopeWidget::resetStatistics()
+{
+    m_mutex.lock();
+    m_statistics = ScopeStatistics();
+    m_mutex.unlock();
+    m_framesReceived = 0;
+    m_framesDroppedBefore = m_queue.discardedCount();
+}
+
 void ScopeWidget::onNewFrame(const SharedFrame& frame)
 {
+    m_framesReceived++;
     m_queue.push(frame);
     requestRefresh();
 }
@@ -66,7 +120,21 @@ void ScopeWidget::refreshInThread()
     m_mutex.unlock();
 
     m_refreshPending = false;
+    QElapsedTimer timer;
+    timer.start();
     refreshScope(size, full);
+    qint64 nsecs = timer.nsecsElapsed();
+
+    int bin = 0;
+    while (bin < ScopeStatistics::DurationBinCount - 1
+           && nsecs >= ScopeStatistics::durationBinLimit(bin) * 1000000LL)
+        bin++;
+    m_mutex.lock();
+    m_statistics.refreshCount++;
+    m_statistics.totalRefreshNsecs += nsecs;
+    m_statistics.maxRefreshNsecs = qMax(m_statistics.maxRefreshNsecs, nsecs);
+    m_statistics.durationBins[bin]++;
+    m_mutex.unlock();
     // Tell the GUI thread that the refresh is complete.
     QMetaObject::invokeMethod(this, "onRefreshThreadComplete", Qt::QueuedConnection);
 }
@@ -74,6 +142,17 @@ void ScopeWidget::refreshInThread()
 void ScopeWidget::onRefreshThreadComplete()
 {
     update();
+    m_refreshCount++;
+    qint64 elapsed = m_refreshRateTimer.isValid()? m_refreshRateTimer.elapsed() : 0;
+    if (!m_refreshRateTimer.isValid() || elapsed > 3000) {
+        // Do not count the time that the scope was idle.
+        m_refreshRateTimer.start();
+        m_refreshCount = 0;
+    } else if (elapsed >= 1000) {
+        m_refreshRate = m_refreshCount * 1000.0 / m_refreshRateTimer.restart();
+        emit refreshRateChanged(m_refreshRate);
+        m_refreshCount = 0;
+    }
     if (m_refreshPending) {
         requestRefresh();
     }
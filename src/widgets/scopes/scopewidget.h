@@ -23,10 +23,38 @@
 #include <QString>
 #include <Logger.h>
 #include <QThread>
+#include <QElapsedTimer>
 #include <QFuture>
 #include <QMutex>
 #include "sharedframe.h"
-#include "dataqueue.h"
+#include "lockfreedataqueue.h"
+
+/*!
+  \class ScopeStatistics
+  \brief Counters that tell how well a scope keeps up with the player.
+*/
+
+class ScopeStatistics
+{
+public:
+    //! Refreshes are counted in bins of up to 1, 2, 4, ... 64 ms and longer.
+    enum { DurationBinCount = 8 };
+
+    ScopeStatistics();
+
+    //! Returns the upper limit in ms of the duration \a bin, or 0 for the last.
+    static int durationBinLimit(int bin);
+    //! Returns the statistics in one line for the log.
+    QString toString() const;
+
+    quint64 framesReceived;
+    quint64 framesDropped; //!< discarded by a full queue before the scope got to them
+    quint64 refreshCount;
+    qint64 totalRefreshNsecs;
+    qint64 maxRefreshNsecs;
+    quint64 durationBins[DurationBinCount];
+    qreal refreshRate; //!< refreshes per second, as last reported
+};
 
 /*!
   \class ScopeWidget
@@ -38,8 +66,9 @@
   is the ability to trigger the "heavy lifting" to be done in a worker thread.
 
   Frames are received by the onNewFrame() slot. The ScopeWidget automatically
-  places new frames in the DataQueue (m_queue). Subclasses shall implement the
-  refreshScope() function and can check for new frames in m_queue.
+  places new frames in the LockFreeDataQueue (m_queue). Subclasses shall
+  implement the refreshScope() function and can check for new frames in
+  m_queue.
 
   refreshScope() is run from a separate thread. Therefore, any members that are
   accessed by both the worker thread (refreshScope) and the GUI thread
@@ -82,10 +111,18 @@ public:
     */
     virtual void setOrientation(Qt::Orientation) {};
 
+    //! Returns the counters since the scope was created or last reset.
+    ScopeStatistics statistics();
+    void resetStatistics();
+
 public slots:
     //! Provides a new frame to the scope. Should be called by the application.
     virtual void onNewFrame(const SharedFrame& frame) Q_DECL_FINAL;
 
+signals:
+    //! Reports about once a second how many refreshes per second were completed.
+    void refreshRateChanged(qreal fps);
+
 protected:
     /*!
       Triggers refreshScope() to be called in a new thread context.
@@ -109,7 +146,7 @@ protected:
       Subclasses should check this queue for new frames in the refreshScope()
       implementation.
     */
-    DataQueue<SharedFrame> m_queue;
+    LockFreeDataQueue<SharedFrame> m_queue;
 
     void resizeEvent(QResizeEvent*) Q_DECL_OVERRIDE;
     void changeEvent(QEvent*) Q_DECL_OVERRIDE;
@@ -119,11 +156,17 @@ private:
     virtual void refreshInThread() Q_DECL_FINAL;
     QFuture<void> m_future;
     bool m_refreshPending;
+    QElapsedTimer m_refreshRateTimer;
+    int m_refreshCount;
+    quint64 m_framesReceived;
+    int m_framesDroppedBefore;
+    qreal m_refreshRate;
 
     // Members accessed in multiple threads (mutex protected).
     QMutex m_mutex;
     bool m_forceRefresh;
     QSize m_size;
+    ScopeStatistics m_statistics;
 };
 
 #endif // SCOPEWIDGET_H
@@ -25,8 +25,9 @@
 const qreal IRE0 = 16;
 const qreal IRE100 = 235;
 
-VideoHistogramScopeWidget::VideoHistogramScopeWidget()
+VideoHistogramScopeWidget::VideoHistogramScopeWidget(VideoScopeAnalyzer* analyzer)
   : ScopeWidget("VideoHistogram")
+  , m_analyzer(analyzer)
   , m_frame()
   , m_mutex(QMutex::NonRecursive)
   , m_yBins()
@@ -48,33 +49,17 @@ void VideoHistogramScopeWidget::refreshScope(const QSize& size, bool full)
         m_frame = m_queue.pop();
     }
 
-    QVector<unsigned int> yBins(256, 0);
-    QVector<unsigned int> rBins(256, 0);
-    QVector<unsigned int> gBins(256, 0);
-    QVector<unsigned int> bBins(256, 0);
-
-    if (m_frame.is_valid() && m_frame.get_image_width() && m_frame.get_image_height()) {
-        const uint8_t* pYUV = m_frame.get_image(mlt_image_yuv420p);
-        const uint8_t* pRGB = m_frame.get_image(mlt_image_rgb24);
-        size_t count = m_frame.get_image_width() * m_frame.get_image_height();
-        unsigned int* pYbin = yBins.data();
-        unsigned int* pRbin = rBins.data();
-        unsigned int* pGbin = gBins.data();
-        unsigned int* pBbin = bBins.data();
-        while (count--)
-        {
-            pYbin[*pYUV++]++;
-            pRbin[*pRGB++]++;
-            pGbin[*pRGB++]++;
-            pBbin[*pRGB++]++;
-        }
+    VideoScopeAnalysis analysis = m_analyzer->analyze(m_frame,
+        VideoScopeAnalysis::LumaHistogram | VideoScopeAnalysis::RgbHistogram);
+    if (analysis.yBins.isEmpty() || analysis.rBins.isEmpty()) {
+        analysis.yBins = analysis.rBins = analysis.gBins = analysis.bBins = QVector<unsigned int>(256, 0);
     }
 
     m_mutex.lock();
-    m_yBins.swap(yBins);
-    m_rBins.swap(rBins);
-    m_gBins.swap(gBins);
-    m_bBins.swap(bBins);
+    m_yBins = analysis.yBins;
+    m_rBins = analysis.rBins;
+    m_gBins = analysis.gBins;
+    m_bBins = analysis.bBins;
     m_mutex.unlock();
 }
 
@@ -121,10 +106,10 @@ void VideoHistogramScopeWidget::paintEvent(QPaintEvent*)
     p.end();
 }
 
-void VideoHistogramScopeWidget::drawHistogram(QPainter& p, QString title, QColor color, QColor outline, QVector<unsigned int>& bins, QRect rect)
+void VideoHistogramScopeWidget::drawHistogram(QPainter& p, QString title, QColor color, QColor outline, const QVector<unsigned int>& bins, QRect rect)
 {
     unsigned int binCount = bins.size();
-    unsigned int* pBins = bins.data();
+    const unsigned int* pBins = bins.constData();
     QFontMetrics fm(p.font());
     int textpad = 3;
     qreal histHeight = rect.height() - fm.height() - textpad - textpad;
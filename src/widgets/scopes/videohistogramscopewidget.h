@@ -19,6 +19,7 @@
 #define VIDEOHISTOGRAMSCOPEWIDGET_H
 
 #include "scopewidget.h"
+#include "videoscopeanalyzer.h"
 #include <QMutex>
 #include <QVector>
 
@@ -27,15 +28,16 @@ class VideoHistogramScopeWidget Q_DECL_FINAL : public ScopeWidget
     Q_OBJECT
 
 public:
-    explicit VideoHistogramScopeWidget();
+    explicit VideoHistogramScopeWidget(VideoScopeAnalyzer* analyzer);
     QString getTitle() Q_DECL_OVERRIDE;
 
 private:
     void refreshScope(const QSize& size, bool full) Q_DECL_OVERRIDE;
     void paintEvent(QPaintEvent*) Q_DECL_OVERRIDE;
-    void drawHistogram(QPainter& p, QString title, QColor color, QColor outline, QVector<unsigned int>& bins, QRect rect);
+    void drawHistogram(QPainter& p, QString title, QColor color, QColor outline, const QVector<unsigned int>& bins, QRect rect);
     void mouseMoveEvent(QMouseEvent *event) Q_DECL_OVERRIDE;
 
+    VideoScopeAnalyzer* m_analyzer;
     SharedFrame m_frame;
 
     // Variables accessed from multiple threads (mutex protected)
@@ -22,12 +22,13 @@
 
 static const QColor TEXT_COLOR = {255, 255, 255, 127};
 
-VideoRgbParadeScopeWidget::VideoRgbParadeScopeWidget()
+VideoRgbParadeScopeWidget::VideoRgbParadeScopeWidget(VideoScopeAnalyzer* analyzer)
   : ScopeWidget("RgbParade")
+  , m_analyzer(analyzer)
   , m_frame()
-  , m_renderImg()
+  , m_display(new ScopeDensityDisplay(this))
   , m_mutex(QMutex::NonRecursive)
-  , m_displayImg()
+  , m_frameWidth(0)
 {
     LOG_DEBUG() << "begin";
     setMouseTracking(true);
@@ -37,69 +38,37 @@ VideoRgbParadeScopeWidget::VideoRgbParadeScopeWidget()
 
 void VideoRgbParadeScopeWidget::refreshScope(const QSize& size, bool full)
 {
-    Q_UNUSED(size)
     Q_UNUSED(full)
 
     while (m_queue.count() > 0) {
         m_frame = m_queue.pop();
     }
 
-    int width = m_frame.get_image_width();
-    int height = m_frame.get_image_height();
-
-    if (m_frame.is_valid() && width && height) {
-        int imgWidth = width * 3;
-        if (m_renderImg.width() != imgWidth) {
-            m_renderImg = QImage(imgWidth, 256, QImage::QImage::Format_RGBX8888);
-        }
-
-        QColor bgColor( 0, 0, 0 ,0xff );
-        m_renderImg.fill(bgColor);
-
-        const uint8_t* src = m_frame.get_image(mlt_image_rgb24);
-        uint8_t* dst = m_renderImg.scanLine(0);
-        size_t rOffset = 0;
-        size_t gOffset = rOffset + width;
-        size_t bOffset = gOffset + width;
-
-        for (int y = 0; y < height; y++) {
-            for (int x = 0; x < width; x++) {
-                uint8_t ry = 255 - src[0];
-                size_t rIndex = (ry * imgWidth + rOffset + x) * 4;
-                if (dst[rIndex] < 0xff) {
-                    dst[rIndex] += 0x0f;
-                }
-
-                uint8_t gy = 255 - src[1];
-                size_t gIndex = (gy * imgWidth + gOffset + x) * 4 + 1;
-                if (dst[gIndex] < 0xff) {
-                    dst[gIndex] += 0x0f;
-                }
-
-                uint8_t by = 255 - src[2];
-                size_t bIndex = (by * imgWidth + bOffset + x) * 4 + 2;
-                if (dst[bIndex] < 0xff) {
-                    dst[bIndex] += 0x0f;
-                }
-                src += 3;
-            }
-        }
-
-        QImage scaledImage = m_renderImg.scaled(size, Qt::IgnoreAspectRatio, Qt::SmoothTransformation).convertToFormat(QImage::Format_RGB32);
+    VideoScopeAnalysis analysis = m_analyzer->analyze(m_frame, VideoScopeAnalysis::RgbParade,
+                                                      qRound(size.width() * devicePixelRatioF()));
+
+    if (!analysis.rgbParade.isNull()) {
+        m_display->setDensity(analysis.rgbParade);
 
         m_mutex.lock();
-        m_displayImg.swap(m_renderImg);
+        m_frameWidth = analysis.frameWidth;
         m_mutex.unlock();
     }
 }
 
-void VideoRgbParadeScopeWidget::paintEvent(QPaintEvent*)
+void VideoRgbParadeScopeWidget::resizeEvent(QResizeEvent* event)
 {
-    if (!isVisible())
-        return;
+    ScopeWidget::resizeEvent(event);
+    m_display->setGeometry(rect());
+    drawGraticule();
+}
+
+void VideoRgbParadeScopeWidget::drawGraticule()
+{
+    QImage graticule = m_display->newGraticule();
 
     // Create the painter
-    QPainter p(this);
+    QPainter p(&graticule);
     p.setRenderHint(QPainter::Antialiasing, true);
     QFont font = QWidget::font();
     int fontSize = font.pointSize() - (font.pointSize() > 10? 2 : (font.pointSize() > 8? 1 : 0));
@@ -111,16 +80,6 @@ void VideoRgbParadeScopeWidget::paintEvent(QPaintEvent*)
     p.setPen(pen);
     p.setFont(font);
 
-    // draw the waveform data
-    m_mutex.lock();
-    if(!m_displayImg.isNull()) {
-        p.drawImage(rect(), m_displayImg, m_displayImg.rect());
-    } else
-    {
-        p.fillRect(rect(), QBrush(Qt::black, Qt::SolidPattern));
-    }
-    m_mutex.unlock();
-
     // Draw the graticule
     int textpad = 3;
     int textheight = fm.tightBoundingRect("0").height();
@@ -145,6 +104,9 @@ void VideoRgbParadeScopeWidget::paintEvent(QPaintEvent*)
     y = height();
     p.drawLine(0, y, width(), y);
     p.drawText(textpad, height() - textpad, tr("0"));
+
+    p.end();
+    m_display->setGraticule(graticule);
 }
 
 void VideoRgbParadeScopeWidget::mouseMoveEvent(QMouseEvent *event)
@@ -162,7 +124,7 @@ void VideoRgbParadeScopeWidget::mouseMoveEvent(QMouseEvent *event)
     }
 
     m_mutex.lock();
-    int frameWidth = m_displayImg.width() / 3;
+    int frameWidth = m_frameWidth;
     m_mutex.unlock();
 
     int value = 255 - (255 * event->pos().y() / height());
@@ -22,12 +22,13 @@
 
 static const QColor TEXT_COLOR = {255, 255, 255, 127};
 
-VideoRgbWaveformScopeWidget::VideoRgbWaveformScopeWidget()
+VideoRgbWaveformScopeWidget::VideoRgbWaveformScopeWidget(VideoScopeAnalyzer* analyzer)
   : ScopeWidget("RgbWaveform")
+  , m_analyzer(analyzer)
   , m_frame()
-  , m_renderImg()
+  , m_display(new ScopeDensityDisplay(this))
   , m_mutex(QMutex::NonRecursive)
-  , m_displayImg()
+  , m_frameWidth(0)
 {
     LOG_DEBUG() << "begin";
     setMouseTracking(true);
@@ -37,65 +38,37 @@ VideoRgbWaveformScopeWidget::VideoRgbWaveformScopeWidget()
 
 void VideoRgbWaveformScopeWidget::refreshScope(const QSize& size, bool full)
 {
-    Q_UNUSED(size)
     Q_UNUSED(full)
 
     while (m_queue.count() > 0) {
         m_frame = m_queue.pop();
     }
 
-    int width = m_frame.get_image_width();
-    int height = m_frame.get_image_height();
-
-    if (m_frame.is_valid() && width && height) {
-        if (m_renderImg.width() != width) {
-            m_renderImg = QImage(width, 256, QImage::QImage::Format_RGBX8888);
-        }
-
-        QColor bgColor( 0, 0, 0 ,0xff );
-        m_renderImg.fill(bgColor);
-
-        const uint8_t* src = m_frame.get_image(mlt_image_rgb24);
-        uint8_t* dst = m_renderImg.scanLine(0);
-
-        for (int y = 0; y < height; y++) {
-            for (int x = 0; x < width; x++) {
-                uint8_t ry = 255 - src[0];
-                size_t rIndex = (ry * width + x) * 4;
-                if (dst[rIndex] < 0xff) {
-                    dst[rIndex] += 0x0f;
-                }
-
-                uint8_t gy = 255 - src[1];
-                size_t gIndex = (gy * width + x) * 4 + 1;
-                if (dst[gIndex] < 0xff) {
-                    dst[gIndex] += 0x0f;
-                }
-
-                uint8_t by = 255 - src[2];
-                size_t bIndex = (by * width + x) * 4 + 2;
-                if (dst[bIndex] < 0xff) {
-                    dst[bIndex] += 0x0f;
-                }
-                src += 3;
-            }
-        }
-
-        QImage scaledImage = m_renderImg.scaled(size, Qt::IgnoreAspectRatio, Qt::SmoothTransformation).convertToFormat(QImage::Format_RGB32);
+    VideoScopeAnalysis analysis = m_analyzer->analyze(m_frame, VideoScopeAnalysis::RgbWaveform,
+                                                      qRound(size.width() * devicePixelRatioF()));
+
+    if (!analysis.rgbWaveform.isNull()) {
+        m_display->setDensity(analysis.rgbWaveform);
 
         m_mutex.lock();
-        m_displayImg.swap(m_renderImg);
+        m_frameWidth = analysis.frameWidth;
         m_mutex.unlock();
     }
 }
 
-void VideoRgbWaveformScopeWidget::paintEvent(QPaintEvent*)
+void VideoRgbWaveformScopeWidget::resizeEvent(QResizeEvent* event)
 {
-    if (!isVisible())
-        return;
+    ScopeWidget::resizeEvent(event);
+    m_display->setGeometry(rect());
+    drawGraticule();
+}
+
+void VideoRgbWaveformScopeWidget::drawGraticule()
+{
+    QImage graticule = m_display->newGraticule();
 
     // Create the painter
-    QPainter p(this);
+    QPainter p(&graticule);
     p.setRenderHint(QPainter::Antialiasing, true);
     QFont font = QWidget::font();
     int fontSize = font.pointSize() - (font.pointSize() > 10? 2 : (font.pointSize() > 8? 1 : 0));
@@ -107,16 +80,6 @@ void VideoRgbWaveformScopeWidget::paintEvent(QPaintEvent*)
     p.setPen(pen);
     p.setFont(font);
 
-    // draw the waveform data
-    m_mutex.lock();
-    if(!m_displayImg.isNull()) {
-        p.drawImage(rect(), m_displayImg, m_displayImg.rect());
-    } else
-    {
-        p.fillRect(rect(), QBrush(Qt::black, Qt::SolidPattern));
-    }
-    m_mutex.unlock();
-
     // Draw the graticule
     int textpad = 3;
     int textheight = fm.tightBoundingRect("0").height();
@@ -141,6 +104,9 @@ void VideoRgbWaveformScopeWidget::paintEvent(QPaintEvent*)
     y = height();
     p.drawLine(0, y, width(), y);
     p.drawText(textpad, height() - textpad, tr("0"));
+
+    p.end();
+    m_display->setGraticule(graticule);
 }
 
 void VideoRgbWaveformScopeWidget::mouseMoveEvent(QMouseEvent *event)
@@ -148,7 +114,7 @@ void VideoRgbWaveformScopeWidget::mouseMoveEvent(QMouseEvent *event)
     QString text;
 
     m_mutex.lock();
-    int frameWidth = m_displayImg.width();
+    int frameWidth = m_frameWidth;
     m_mutex.unlock();
 
     int value = 255 - (255 * event->pos().y() / height());
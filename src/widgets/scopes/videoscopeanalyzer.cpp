@@ -0,0 +1,574 @@
+/*
+ * Copyright (c) 2021 Meltytech, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "videoscopeanalyzer.h"
+#include "scopekernels.h"
+#include <Logger.h>
+#include <QMutexLocker>
+#include <QThreadPool>
+#include <QtConcurrent/QtConcurrent>
+
+typedef VideoScopeAnalysis::Features Features;
+
+static const Features kYuvFeatures = VideoScopeAnalysis::LumaHistogram
+        | VideoScopeAnalysis::LumaWaveform | VideoScopeAnalysis::Vectorscope;
+static const Features kRgbFeatures = VideoScopeAnalysis::RgbHistogram
+        | VideoScopeAnalysis::RgbWaveform | VideoScopeAnalysis::RgbParade;
+
+// Stripes are at least this many columns wide and start on a multiple of it
+// so that they do not share cache lines of the source rows.
+static const int kMinimumStripeWidth = 64;
+
+// Adaptive quality uses this share of the time between frames for the scopes.
+static const double kAdaptiveBudget = 0.75;
+// Analyses to average after a change before adapting again
+static const int kAdaptiveSamples = 8;
+
+static QThreadPool& stripeThreadPool()
+{
+    // The scopes refresh in the global pool and wait on each other in
+    // analyze(). Helpers must not queue behind them there.
+    static QThreadPool pool;
+    return pool;
+}
+
+// Draws \a width columns of the 256 rows of density counts into an RGBX
+// image that is \a imageWidth wide, starting at column \a offset. The counts
+// point at their first column and rows are \a stride counters apart. A
+// channel with null counts is black, and the same counts for all channels
+// draw gray.
+static void toneMap(const uint16_t* r, const uint16_t* g, const uint16_t* b, int stride,
+                    uint8_t* image, int imageWidth, int offset, int width)
+{
+    for (int y = 0; y < 256; y++) {
+        int countsOffset = y * stride;
+        ScopeKernels::toneMapRow(r? r + countsOffset : nullptr, g? g + countsOffset : nullptr,
+                                 b? b + countsOffset : nullptr, width,
+                                 image + (y * imageWidth + offset) * 4);
+    }
+}
+
+// Averages the 256 rows of \a width density counts, which are \a stride
+// counters apart, down to \a binCount columns in \a bins.
+static void binCounts(const uint16_t* counts, int stride, int width, int binCount, QVector<uint16_t>& bins)
+{
+    bins.resize(binCount * 256);
+    for (int y = 0; y < 256; y++) {
+        const uint16_t* src = counts + y * stride;
+        uint16_t* dst = bins.data() + y * binCount;
+        for (int bin = 0; bin < binCount; bin++) {
+            int first = bin * width / binCount;
+            int last = (bin + 1) * width / binCount;
+            unsigned int sum = 0;
+            for (int x = first; x < last; x++)
+                sum += src[x];
+            dst[bin] = sum / (last - first);
+        }
+    }
+}
+
+/*
+  One analysis of one frame.
+
+  The frame is cut into vertical stripes that are claimed one at a time by
+  the calling thread and by helpers in stripeThreadPool(). A stripe owns its
+  columns of the waveform and parade counters and images, so those need no
+  merging. Only the histograms and the vectorscope are counted per stripe and
+  added together at the end. Columns and stripes are counted after
+  decimation by the sample step. Density images that are narrower than
+  that are drawn from averaged columns once all stripes are done.
+
+  The player's packed yuv422 frames are read in place. The RGB scopes
+  convert them one stripe row at a time into a small buffer instead of
+  converting the whole frame. Other formats are converted by SharedFrame,
+  once per frame and format.
+*/
+class AnalysisPass
+{
+public:
+    AnalysisPass(const SharedFrame& frame, Features features, int step, VideoScopeAnalysis& analysis);
+    void setImageWidths(int lumaWaveform, int rgbWaveform, int rgbParade);
+    void run();
+
+private:
+    struct Stripe
+    {
+        int first;
+        int last;
+        QVector<unsigned int> ySubBins;
+        QVector<unsigned int> rSubBins;
+        QVector<unsigned int> gSubBins;
+        QVector<unsigned int> bSubBins;
+        QVector<uint16_t> uvCounts;
+        QVector<uint8_t> rgbRow;
+    };
+
+    void processStripes();
+    void processStripe(Stripe& stripe);
+
+    const SharedFrame& m_frame;
+    Features m_features;
+    VideoScopeAnalysis& m_analysis;
+    int m_step;
+    int m_width;
+    int m_height;
+    int m_outWidth;
+    int m_lumaWaveformWidth;
+    int m_rgbWaveformWidth;
+    int m_paradeChannelWidth;
+    const uint8_t* m_yuv;
+    bool m_isPackedYuv;
+    const uint8_t* m_rgb;
+    int m_rgbPixelSize;
+    const uint8_t* m_rgbFromYuv;
+    ScopeKernels::YuvToRgb m_yuvToRgb;
+    QVector<uint16_t> m_lumaCounts;
+    QVector<uint16_t> m_rCounts;
+    QVector<uint16_t> m_gCounts;
+    QVector<uint16_t> m_bCounts;
+    uint8_t* m_lumaWaveform;
+    uint8_t* m_rgbWaveform;
+    uint8_t* m_rgbParade;
+    QVector<Stripe> m_stripes;
+    QAtomicInt m_nextStripe;
+};
+
+AnalysisPass::AnalysisPass(const SharedFrame& frame, Features features, int step, VideoScopeAnalysis& analysis)
+    : m_frame(frame)
+    , m_features(features)
+    , m_analysis(analysis)
+    , m_step(step)
+    , m_width(frame.get_image_width())
+    , m_height(frame.get_image_height())
+    , m_outWidth((m_width + step - 1) / step)
+    , m_lumaWaveformWidth(m_outWidth)
+    , m_rgbWaveformWidth(m_outWidth)
+    , m_paradeChannelWidth(m_outWidth)
+    , m_yuv(nullptr)
+    , m_isPackedYuv(false)
+    , m_rgb(nullptr)
+    , m_rgbPixelSize(3)
+    , m_rgbFromYuv(nullptr)
+    , m_lumaWaveform(nullptr)
+    , m_rgbWaveform(nullptr)
+    , m_rgbParade(nullptr)
+    , m_nextStripe(0)
+{
+}
+
+// A width of 0 keeps the width of the analysis.
+void AnalysisPass::setImageWidths(int lumaWaveform, int rgbWaveform, int rgbParade)
+{
+    if (lumaWaveform > 0)
+        m_lumaWaveformWidth = qMin(lumaWaveform, m_outWidth);
+    if (rgbWaveform > 0)
+        m_rgbWaveformWidth = qMin(rgbWaveform, m_outWidth);
+    if (rgbParade > 0)
+        m_paradeChannelWidth = qBound(1, rgbParade / 3, m_outWidth);
+}
+
+void AnalysisPass::run()
+{
+    // Read the native image where the kernels can. Otherwise convert only
+    // if some scope needs the format. SharedFrame keeps the conversions, so
+    // the player and the zoom scope reuse them too.
+    mlt_image_format nativeFormat = m_frame.get_image_format();
+    if (m_features & kYuvFeatures) {
+        // Packed rows of an odd width do not hold a whole number of chroma pairs.
+        if (nativeFormat == mlt_image_yuv422 && !(m_width & 1)) {
+            m_yuv = m_frame.get_image(mlt_image_yuv422);
+            m_isPackedYuv = true;
+        } else {
+            m_yuv = m_frame.get_image(mlt_image_yuv420p);
+        }
+        if (!m_yuv) {
+            m_features &= ~kYuvFeatures;
+        }
+    }
+    if (m_features & kRgbFeatures) {
+        if (nativeFormat == mlt_image_yuv422 && !(m_width & 1)) {
+            m_rgbFromYuv = m_frame.get_image(mlt_image_yuv422);
+            m_yuvToRgb = ScopeKernels::yuvToRgb(m_frame.get_int("colorspace"),
+                                                m_frame.get_int("full_luma"));
+        } else if (nativeFormat == mlt_image_rgb24a) {
+            m_rgb = m_frame.get_image(mlt_image_rgb24a);
+            m_rgbPixelSize = 4;
+        } else {
+            m_rgb = m_frame.get_image(mlt_image_rgb24);
+        }
+        if (!m_rgb && !m_rgbFromYuv) {
+            m_features &= ~kRgbFeatures;
+        }
+    }
+
+    // Allocate everything the stripes share up front. The images are only
+    // written through their bits so that no thread detaches them.
+    if (m_features & VideoScopeAnalysis::LumaWaveform) {
+        m_lumaCounts.fill(0, m_outWidth * 256);
+        m_analysis.lumaWaveform = QImage(m_lumaWaveformWidth, 256, QImage::Format_RGBX8888);
+        m_lumaWaveform = m_analysis.lumaWaveform.bits();
+    }
+    // The RGB waveform and parade are drawn from the same counts.
+    if (m_features & (VideoScopeAnalysis::RgbWaveform | VideoScopeAnalysis::RgbParade)) {
+        m_rCounts.fill(0, m_outWidth * 256);
+        m_gCounts.fill(0, m_outWidth * 256);
+        m_bCounts.fill(0, m_outWidth * 256);
+    }
+    if (m_features & VideoScopeAnalysis::RgbWaveform) {
+        m_analysis.rgbWaveform = QImage(m_rgbWaveformWidth, 256, QImage::Format_RGBX8888);
+        m_rgbWaveform = m_analysis.rgbWaveform.bits();
+    }
+    if (m_features & VideoScopeAnalysis::RgbParade) {
+        m_analysis.rgbParade = QImage(m_paradeChannelWidth * 3, 256, QImage::Format_RGBX8888);
+        m_rgbParade = m_analysis.rgbParade.bits();
+    }
+
+    int threadCount = QThread::idealThreadCount();
+    int stripeCount = qBound(1, m_outWidth / kMinimumStripeWidth, 2 * threadCount);
+    int stripeWidth = (m_outWidth / stripeCount) & ~(kMinimumStripeWidth - 1);
+    stripeWidth = qMax(stripeWidth, kMinimumStripeWidth);
+    for (int x = 0; x < m_outWidth; x += stripeWidth) {
+        Stripe stripe;
+        stripe.first = x;
+        stripe.last = (m_outWidth - x < stripeWidth * 2)? m_outWidth : x + stripeWidth;
+        m_stripes << stripe;
+        if (stripe.last == m_outWidth)
+            break;
+    }
+
+    // Claim the stripes from here and from a helper per other core, so that a
+    // busy core only delays the stripes it has already taken.
+    QList<QFuture<void>> helpers;
+    stripeThreadPool().setMaxThreadCount(qMax(1, threadCount - 1));
+    for (int i = 1; i < qMin(m_stripes.size(), threadCount); i++)
+        helpers << QtConcurrent::run(&stripeThreadPool(), this, &AnalysisPass::processStripes);
+    processStripes();
+    foreach (QFuture<void> future, helpers)
+        future.waitForFinished();
+
+    // Draw the narrower density images from averaged columns.
+    QVector<uint16_t> rBins, gBins, bBins;
+    if (m_lumaWaveform && m_lumaWaveformWidth < m_outWidth) {
+        int width = m_lumaWaveformWidth;
+        binCounts(m_lumaCounts.constData(), m_outWidth, m_outWidth, width, rBins);
+        const uint16_t* counts = rBins.constData();
+        toneMap(counts, counts, counts, width, m_lumaWaveform, width, 0, width);
+    }
+    if (m_rgbWaveform && m_rgbWaveformWidth < m_outWidth) {
+        int width = m_rgbWaveformWidth;
+        binCounts(m_rCounts.constData(), m_outWidth, m_outWidth, width, rBins);
+        binCounts(m_gCounts.constData(), m_outWidth, m_outWidth, width, gBins);
+        binCounts(m_bCounts.constData(), m_outWidth, m_outWidth, width, bBins);
+        toneMap(rBins.constData(), gBins.constData(), bBins.constData(), width, m_rgbWaveform, width, 0, width);
+    }
+    if (m_rgbParade && m_paradeChannelWidth < m_outWidth) {
+        int width = m_paradeChannelWidth;
+        int imageWidth = width * 3;
+        binCounts(m_rCounts.constData(), m_outWidth, m_outWidth, width, rBins);
+        binCounts(m_gCounts.constData(), m_outWidth, m_outWidth, width, gBins);
+        binCounts(m_bCounts.constData(), m_outWidth, m_outWidth, width, bBins);
+        toneMap(rBins.constData(), nullptr, nullptr, width, m_rgbParade, imageWidth, 0, width);
+        toneMap(nullptr, gBins.constData(), nullptr, width, m_rgbParade, imageWidth, width, width);
+        toneMap(nullptr, nullptr, bBins.constData(), width, m_rgbParade, imageWidth, width * 2, width);
+    }
+
+    // Reduce the stripes.
+    if (m_features & VideoScopeAnalysis::LumaHistogram) {
+        m_analysis.yBins.fill(0, 256);
+        for (const Stripe& stripe : m_stripes)
+            ScopeKernels::reduceHistogram(stripe.ySubBins.constData(), m_analysis.yBins.data());
+    }
+    if (m_features & VideoScopeAnalysis::RgbHistogram) {
+        m_analysis.rBins.fill(0, 256);
+        m_analysis.gBins.fill(0, 256);
+        m_analysis.bBins.fill(0, 256);
+        for (const Stripe& stripe : m_stripes) {
+            ScopeKernels::reduceHistogram(stripe.rSubBins.constData(), m_analysis.rBins.data());
+            ScopeKernels::reduceHistogram(stripe.gSubBins.constData(), m_analysis.gBins.data());
+            ScopeKernels::reduceHistogram(stripe.bSubBins.constData(), m_analysis.bBins.data());
+        }
+    }
+    if (m_features & VideoScopeAnalysis::Vectorscope) {
+        QVector<uint16_t> uvCounts = m_stripes.first().uvCounts;
+        for (int i = 1; i < m_stripes.size(); i++)
+            ScopeKernels::addCounts(m_stripes.at(i).uvCounts.constData(), uvCounts.size(), uvCounts.data());
+        m_analysis.vectorscope = QImage(256, 256, QImage::Format_RGBX8888);
+        const uint16_t* counts = uvCounts.constData();
+        toneMap(counts, counts, counts, 256, m_analysis.vectorscope.bits(), 256, 0, 256);
+    }
+
+    m_analysis.features |= m_features;
+    m_analysis.frameWidth = m_width;
+    m_analysis.frameHeight = m_height;
+    m_analysis.sampleStep = m_step;
+}
+
+void AnalysisPass::processStripes()
+{
+    // Do not iterate a copy of m_stripes; that would detach it.
+    for (int i = m_nextStripe.fetchAndAddOrdered(1); i < m_stripes.size();
+         i = m_nextStripe.fetchAndAddOrdered(1)) {
+        processStripe(m_stripes[i]);
+    }
+}
+
+void AnalysisPass::processStripe(Stripe& stripe)
+{
+    const int kSubBins = ScopeKernels::kSubHistograms * 256;
+    int first = stripe.first;
+    int width = stripe.last - stripe.first;
+    uint16_t* lumaCounts = m_lumaCounts.isEmpty()? nullptr : m_lumaCounts.data() + first;
+    uint16_t* rCounts = m_rCounts.isEmpty()? nullptr : m_rCounts.data() + first;
+    uint16_t* gCounts = m_gCounts.isEmpty()? nullptr : m_gCounts.data() + first;
+    uint16_t* bCounts = m_bCounts.isEmpty()? nullptr : m_bCounts.data() + first;
+
+    if (m_features & VideoScopeAnalysis::LumaHistogram) {
+        stripe.ySubBins.fill(0, kSubBins);
+    }
+    if (m_features & VideoScopeAnalysis::RgbHistogram) {
+        stripe.rSubBins.fill(0, kSubBins);
+        stripe.gSubBins.fill(0, kSubBins);
+        stripe.bSubBins.fill(0, kSubBins);
+    }
+    if (m_features & VideoScopeAnalysis::Vectorscope) {
+        stripe.uvCounts.fill(0, 256 * 256);
+    }
+    if (m_rgbFromYuv) {
+        stripe.rgbRow.resize(width * 3);
+    }
+
+    // The stripe's source columns start at first * m_step. The chroma has
+    // half the horizontal resolution and is sampled with the same step,
+    // starting at the matching chroma column. Packed yuv422 has chroma on
+    // every row, but only every other row is counted, as for yuv420p, so
+    // that the vectorscope looks the same for both.
+    int x = first * m_step;
+    const uint8_t* uSrc = m_yuv;
+    const uint8_t* vSrc = m_yuv;
+    int lumaStep = m_step;
+    int chromaStep = m_step;
+    if (m_isPackedYuv) {
+        uSrc = m_yuv + 1;
+        vSrc = m_yuv + 3;
+        lumaStep = m_step * 2;
+        chromaStep = m_step * 4;
+    } else if (m_yuv) {
+        uSrc = m_yuv + m_width * m_height;
+        vSrc = uSrc + m_width * m_height / 4;
+    }
+    int cWidth = m_width / 2;
+    int cHeight = m_height / 2;
+    int cFirst = x / 2;
+    int cLast = qMin(stripe.last * m_step / 2, cWidth);
+    int cStripeWidth = qMax(0, (cLast - cFirst + m_step - 1) / m_step);
+    // Fewer samples per column and chroma pixel make a fainter density.
+    int waveformWeight = m_step;
+    int vectorscopeWeight = m_step * m_step;
+
+    // Walk the stripe once, a row at a time, and let every scope take what
+    // it needs from the row while it is still in the cache.
+    for (int y = 0; y < m_height; y += m_step) {
+        if (m_yuv) {
+            const uint8_t* luma = m_isPackedYuv? m_yuv + (y * m_width + x) * 2 : m_yuv + y * m_width + x;
+            if (!stripe.ySubBins.isEmpty())
+                ScopeKernels::histogramRow(luma, width, lumaStep, stripe.ySubBins.data());
+            if (lumaCounts)
+                ScopeKernels::waveformRow(luma, width, lumaStep, lumaCounts, m_outWidth, waveformWeight);
+            if (!stripe.uvCounts.isEmpty() && !(y % (2 * m_step)) && (m_isPackedYuv || y / 2 < cHeight)) {
+                int offset = m_isPackedYuv? y * m_width * 2 + cFirst * 4 : y / 2 * cWidth + cFirst;
+                ScopeKernels::vectorscopeRow(uSrc + offset, vSrc + offset, cStripeWidth, chromaStep,
+                                             stripe.uvCounts.data(), vectorscopeWeight);
+            }
+        }
+        const uint8_t* row = nullptr;
+        int step = m_step * m_rgbPixelSize;
+        if (m_rgbFromYuv) {
+            ScopeKernels::yuv422ToRgbRow(m_rgbFromYuv + y * m_width * 2, x, width, m_step,
+                                         m_yuvToRgb, stripe.rgbRow.data());
+            row = stripe.rgbRow.constData();
+            step = 3;
+        } else if (m_rgb) {
+            row = m_rgb + (y * m_width + x) * m_rgbPixelSize;
+        }
+        if (row) {
+            if (!stripe.rSubBins.isEmpty()) {
+                ScopeKernels::histogramRow(row, width, step, stripe.rSubBins.data());
+                ScopeKernels::histogramRow(row + 1, width, step, stripe.gSubBins.data());
+                ScopeKernels::histogramRow(row + 2, width, step, stripe.bSubBins.data());
+            }
+            if (rCounts) {
+                ScopeKernels::waveformRow(row, width, step, rCounts, m_outWidth, waveformWeight);
+                ScopeKernels::waveformRow(row + 1, width, step, gCounts, m_outWidth, waveformWeight);
+                ScopeKernels::waveformRow(row + 2, width, step, bCounts, m_outWidth, waveformWeight);
+            }
+        }
+    }
+
+    // Draw this stripe's columns of the density images that are as wide as
+    // the analysis.
+    if (m_lumaWaveform && m_lumaWaveformWidth == m_outWidth) {
+        toneMap(lumaCounts, lumaCounts, lumaCounts, m_outWidth, m_lumaWaveform, m_outWidth, first, width);
+    }
+    if (m_rgbWaveform && m_rgbWaveformWidth == m_outWidth) {
+        toneMap(rCounts, gCounts, bCounts, m_outWidth, m_rgbWaveform, m_outWidth, first, width);
+    }
+    if (m_rgbParade && m_paradeChannelWidth == m_outWidth) {
+        int imageWidth = m_outWidth * 3;
+        toneMap(rCounts, nullptr, nullptr, m_outWidth, m_rgbParade, imageWidth, first, width);
+        toneMap(nullptr, gCounts, nullptr, m_outWidth, m_rgbParade, imageWidth, m_outWidth + first, width);
+        toneMap(nullptr, nullptr, bCounts, m_outWidth, m_rgbParade, imageWidth, m_outWidth * 2 + first, width);
+    }
+}
+
+VideoScopeAnalyzer::VideoScopeAnalyzer()
+    : m_mutex(QMutex::NonRecursive)
+    , m_busy(false)
+    , m_requestedFeatures(VideoScopeAnalysis::NoFeatures)
+    , m_previousFeatures(VideoScopeAnalysis::NoFeatures)
+    , m_lumaWaveformWidth(0)
+    , m_rgbWaveformWidth(0)
+    , m_rgbParadeWidth(0)
+    , m_quality(FullQuality)
+    , m_sampleStep(1)
+    , m_frameInterval(0.0)
+    , m_analysisTime(0.0)
+    , m_analysisCount(0)
+{
+    LOG_INFO() << "scope kernels" << ScopeKernels::instructionSet();
+}
+
+VideoScopeAnalysis VideoScopeAnalyzer::analyze(const SharedFrame& frame, Features features, int imageWidth)
+{
+    if (!frame.is_valid() || !frame.get_image_width() || !frame.get_image_height()) {
+        return VideoScopeAnalysis();
+    }
+
+    QMutexLocker locker(&m_mutex);
+    while (m_busy) {
+        m_idleCondition.wait(&m_mutex);
+    }
+
+    // Remember the width of each scope for the frames that are analyzed
+    // ahead of its request.
+    if (features & VideoScopeAnalysis::LumaWaveform)
+        m_lumaWaveformWidth = imageWidth;
+    if (features & VideoScopeAnalysis::RgbWaveform)
+        m_rgbWaveformWidth = imageWidth;
+    if (features & VideoScopeAnalysis::RgbParade)
+        m_rgbParadeWidth = imageWidth;
+
+    VideoScopeAnalysis analysis;
+    Features missing = features;
+    bool isNewFrame = m_frame != frame;
+    if (!isNewFrame) {
+        m_requestedFeatures |= features;
+        missing &= ~m_analysis.features;
+        if (!missing) {
+            return m_analysis;
+        }
+        // A scope that was not asking before. Add its part to the result.
+        analysis = m_analysis;
+    } else {
+        // Also compute what the other scopes asked for in the last two
+        // frames so that they find their part ready when they get here.
+        missing |= m_requestedFeatures | m_previousFeatures;
+        m_previousFeatures = m_requestedFeatures;
+        m_requestedFeatures = features;
+    }
+    m_busy = true;
+    int step = m_sampleStep.load();
+    AnalysisPass pass(frame, missing, step, analysis);
+    pass.setImageWidths(m_lumaWaveformWidth, m_rgbWaveformWidth, m_rgbParadeWidth);
+    locker.unlock();
+
+    QElapsedTimer timer;
+    timer.start();
+    pass.run();
+    qint64 analysisTime = timer.nsecsElapsed();
+
+    locker.relock();
+    adaptSampleStep(analysisTime, isNewFrame);
+    m_frame = frame;
+    m_analysis = analysis;
+    m_busy = false;
+    m_idleCondition.wakeAll();
+    return analysis;
+}
+
+void VideoScopeAnalyzer::setQuality(Quality quality)
+{
+    QMutexLocker locker(&m_mutex);
+    m_quality = quality;
+    switch (quality) {
+    case FullQuality:
+    case AdaptiveQuality:
+        m_sampleStep = 1;
+        break;
+    case HalfQuality:
+        m_sampleStep = 2;
+        break;
+    case QuarterQuality:
+        m_sampleStep = 4;
+        break;
+    }
+    m_analysisCount = 0;
+}
+
+VideoScopeAnalyzer::Quality VideoScopeAnalyzer::quality() const
+{
+    return Quality(m_quality.load());
+}
+
+int VideoScopeAnalyzer::sampleStep() const
+{
+    return m_sampleStep.load();
+}
+
+// Called with m_mutex locked.
+void VideoScopeAnalyzer::adaptSampleStep(qint64 analysisTime, bool isNewFrame)
+{
+    if (isNewFrame) {
+        // Pauses and seeks are not playback; only average shorter intervals.
+        qint64 interval = m_frameTimer.isValid()? m_frameTimer.restart() : -1;
+        if (!m_frameTimer.isValid())
+            m_frameTimer.start();
+        if (interval > 0 && interval < 1000) {
+            double ns = interval * 1000000.0;
+            m_frameInterval = m_frameInterval > 0.0? 0.9 * m_frameInterval + 0.1 * ns : ns;
+        }
+    }
+    if (m_quality.load() != AdaptiveQuality || m_frameInterval <= 0.0)
+        return;
+
+    m_analysisTime = m_analysisCount? 0.8 * m_analysisTime + 0.2 * analysisTime : analysisTime;
+    if (++m_analysisCount < kAdaptiveSamples)
+        return;
+
+    // Each step up or down changes the number of pixels four times. Only go
+    // back up when that is sure to fit, so that the step does not flip-flop.
+    int step = m_sampleStep.load();
+    double budget = kAdaptiveBudget * m_frameInterval;
+    if (m_analysisTime > budget && step < 4) {
+        m_sampleStep = step * 2;
+        m_analysisCount = 0;
+        LOG_DEBUG() << "video scope sample step" << step * 2;
+    } else if (m_analysisTime * 4.0 < budget * 0.5 && step > 1) {
+        m_sampleStep = step / 2;
+        m_analysisCount = 0;
+        LOG_DEBUG() << "video scope sample step" << step / 2;
+    }
+}
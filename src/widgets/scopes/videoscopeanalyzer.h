@@ -0,0 +1,148 @@
+/*
+ * Copyright (c) 2021 Meltytech, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef VIDEOSCOPEANALYZER_H
+#define VIDEOSCOPEANALYZER_H
+
+#include "sharedframe.h"
+#include <QAtomicInt>
+#include <QElapsedTimer>
+#include <QFlags>
+#include <QImage>
+#include <QMutex>
+#include <QVector>
+#include <QWaitCondition>
+
+/*!
+  \class VideoScopeAnalysis
+  \brief The data computed for the video scopes from one frame.
+
+  All members are implicitly shared, so copies are cheap and a scope may keep
+  its part after the analyzer has moved on to another frame. Members for
+  features that were not computed are empty or null.
+*/
+
+class VideoScopeAnalysis
+{
+public:
+    enum Feature {
+        NoFeatures    = 0,
+        LumaHistogram = 1 << 0, //!< yBins
+        RgbHistogram  = 1 << 1, //!< rBins, gBins and bBins
+        LumaWaveform  = 1 << 2, //!< lumaWaveform
+        RgbWaveform   = 1 << 3, //!< rgbWaveform
+        RgbParade     = 1 << 4, //!< rgbParade
+        Vectorscope   = 1 << 5, //!< vectorscope
+        AllFeatures   = (1 << 6) - 1
+    };
+    Q_DECLARE_FLAGS(Features, Feature)
+
+    VideoScopeAnalysis()
+        : features(NoFeatures)
+        , frameWidth(0)
+        , frameHeight(0)
+        , sampleStep(1)
+    {}
+
+    Features features;
+    int frameWidth;
+    int frameHeight;
+    int sampleStep; //!< only every sampleStep-th row and column was analyzed
+    QVector<unsigned int> yBins;
+    QVector<unsigned int> rBins;
+    QVector<unsigned int> gBins;
+    QVector<unsigned int> bBins;
+    QImage lumaWaveform; //!< up to frame width x 256 luma density
+    QImage rgbWaveform;  //!< up to frame width x 256 overlaid R, G and B density
+    QImage rgbParade;    //!< up to 3 x frame width x 256 side by side R, G and B density
+    QImage vectorscope;  //!< 256 x 256 U/V density with V increasing upwards
+};
+
+Q_DECLARE_OPERATORS_FOR_FLAGS(VideoScopeAnalysis::Features)
+
+/*!
+  \class VideoScopeAnalyzer
+  \brief Computes the data for all of the video scopes in one pass per frame.
+
+  \threadsafe
+
+  The video scopes call analyze() from their refresh threads. The first call
+  for a frame converts the image at most once per format and fills in the
+  features of every scope that asked for the previous frame, walking the
+  image only once. The image is cut into vertical stripes that are analyzed
+  in parallel. The other scopes wait for that result and take their part of
+  it instead of reading the frame themselves.
+
+  The quality sets how many pixels are analyzed. Below full quality only
+  every second or fourth row and column is read, and the density of the
+  waveforms and vectorscope is weighted to look the same. Adaptive quality
+  starts at full and halves the resolution while the analysis takes most of
+  the time between frames, then goes back up once there is room again.
+
+  The columns of the waveform and parade images are averaged down to the
+  width that their scope shows them at, so that no column is left out when
+  the display shrinks a wide frame and the images stay small to upload.
+*/
+
+class VideoScopeAnalyzer
+{
+public:
+    enum Quality {
+        FullQuality = 0,
+        HalfQuality,
+        QuarterQuality,
+        AdaptiveQuality
+    };
+
+    VideoScopeAnalyzer();
+
+    void setQuality(Quality quality);
+    Quality quality() const;
+    //! Returns the row and column step that the quality currently results in.
+    int sampleStep() const;
+
+    /*!
+      Returns the analysis of \a frame with at least \a features computed.
+      The density images of \a features are made at most \a imageWidth
+      pixels wide, or as wide as the analysis if it is 0.
+      This blocks while another scope's analysis is in progress.
+    */
+    VideoScopeAnalysis analyze(const SharedFrame& frame, VideoScopeAnalysis::Features features,
+                               int imageWidth = 0);
+
+private:
+    void adaptSampleStep(qint64 analysisTime, bool isNewFrame);
+
+    QMutex m_mutex;
+    QWaitCondition m_idleCondition;
+    bool m_busy;
+    SharedFrame m_frame;
+    VideoScopeAnalysis m_analysis;
+    VideoScopeAnalysis::Features m_requestedFeatures;
+    VideoScopeAnalysis::Features m_previousFeatures;
+    int m_lumaWaveformWidth;
+    int m_rgbWaveformWidth;
+    int m_rgbParadeWidth;
+    QAtomicInt m_quality;
+    QAtomicInt m_sampleStep;
+    QElapsedTimer m_frameTimer;
+    double m_frameInterval;
+    double m_analysisTime;
+    int m_analysisCount;
+};
+
+#endif // VIDEOSCOPEANALYZER_H
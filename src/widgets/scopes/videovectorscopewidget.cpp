@@ -28,16 +28,16 @@
 
 static const QColor LINE_COLOR = {255, 255, 255, 127};
 
-VideoVectorScopeWidget::VideoVectorScopeWidget()
+VideoVectorScopeWidget::VideoVectorScopeWidget(VideoScopeAnalyzer* analyzer)
   : ScopeWidget("VideoVector")
+  , m_analyzer(analyzer)
   , m_frame()
-  , m_renderImg()
-  , m_mutex(QMutex::NonRecursive)
-  , m_displayImg()
-  , m_profileChanged(false)
+  , m_display(new ScopeDensityDisplay(this))
 {
     LOG_DEBUG() << "begin";
     setMouseTracking(true);
+    // Use "plus" composition so that light points will stand out on top of a graticule line.
+    m_display->setCompositionMode(ScopeDensityDisplay::CompositionModePlus);
     profileChanged();
     connect(&QmlProfile::singleton(), SIGNAL(profileChanged()), this, SLOT(profileChanged()));
     LOG_DEBUG() << "end";
@@ -55,100 +55,54 @@ QString VideoVectorScopeWidget::getTitle()
 
 void VideoVectorScopeWidget::refreshScope(const QSize& size, bool full)
 {
+    Q_UNUSED(size)
     Q_UNUSED(full)
 
-    qreal side = qMin(size.width(), size.height());
-    QSize squareSize = QSize(side, side);
-
-    if (m_graticuleImg.size() != size || m_profileChanged) {
-
-        m_graticuleImg = QImage(squareSize, QImage::Format_RGB32);
-        m_graticuleImg.fill(0);
-        QPainter p(&m_graticuleImg);
-        p.setRenderHint(QPainter::Antialiasing, true);
-
-        // Convert the coordinate system to match the U/V coordinate system
-        // 256x256 going up from the bottom
-        p.translate(0, side);
-        p.scale(side / 256.0, -1.0 * side / 256.0);
-
-        m_mutex.lock();
-
-        drawGraticuleLines(p, devicePixelRatioF());
-
-        drawGraticuleMark(p, m_points[BLUE_100], Qt::blue, devicePixelRatioF() * 2, 8);
-        drawGraticuleMark(p, m_points[CYAN_100], Qt::cyan, devicePixelRatioF() * 2, 8);
-        drawGraticuleMark(p, m_points[GREEN_100], Qt::green, devicePixelRatioF() * 2, 8);
-        drawGraticuleMark(p, m_points[YELLOW_100], Qt::yellow, devicePixelRatioF() * 2, 8);
-        drawGraticuleMark(p, m_points[RED_100], Qt::red, devicePixelRatioF() * 2, 8);
-        drawGraticuleMark(p, m_points[MAGENTA_100], Qt::magenta, devicePixelRatioF() * 2, 8);
-        drawGraticuleMark(p, m_points[BLUE_75], Qt::blue, devicePixelRatioF(), 5);
-        drawGraticuleMark(p, m_points[CYAN_75], Qt::cyan, devicePixelRatioF(), 5);
-        drawGraticuleMark(p, m_points[GREEN_75], Qt::green, devicePixelRatioF(), 5);
-        drawGraticuleMark(p, m_points[YELLOW_75], Qt::yellow, devicePixelRatioF(), 5);
-        drawGraticuleMark(p, m_points[RED_75], Qt::red, devicePixelRatioF(), 5);
-        drawGraticuleMark(p, m_points[MAGENTA_75], Qt::magenta, devicePixelRatioF(), 5);
-
-        drawSkinToneLine(p, devicePixelRatioF());
-
-        m_profileChanged = false;
-        p.end();
-
-        m_mutex.unlock();
-    }
-
     while (m_queue.count() > 0) {
         m_frame = m_queue.pop();
     }
 
-    int width = m_frame.get_image_width();
-    int height = m_frame.get_image_height();
-
-    if (m_frame.is_valid() && width && height) {
-        if (m_renderImg.width() != 256) {
-            m_renderImg = QImage(256, 256, QImage::Format_RGBX8888);
-        }
-        m_renderImg.fill(0);
+    VideoScopeAnalysis analysis = m_analyzer->analyze(m_frame, VideoScopeAnalysis::Vectorscope);
 
-        const uint8_t* src = m_frame.get_image(mlt_image_yuv420p);
-        const uint8_t* uSrc = src + (width * height);
-        const uint8_t* vSrc = uSrc + (width * height / 4);
-        uint8_t* dst = m_renderImg.scanLine(0);
-        int cHeight = height / 2;
-        int cWidth = width / 2;
+    if (!analysis.vectorscope.isNull()) {
+        m_display->setDensity(analysis.vectorscope);
+    }
+}
 
-        for (int y = 0; y < cHeight; y++) {
-            for (int x = 0; x < cWidth; x++) {
-                uint8_t dx = *uSrc;
-                uint8_t dy = 255 - *vSrc;
-                size_t dIndex = (dy * 256 + dx) * 4;
-                if (dst[dIndex] < 0xff) {
-                    dst[dIndex] += 0x0f;
-                    dst[dIndex + 1] += 0x0f;
-                    dst[dIndex + 2] += 0x0f;
-                }
-                uSrc++;
-                vSrc++;
-            }
-        }
+void VideoVectorScopeWidget::drawGraticule()
+{
+    if (m_display->size().isEmpty())
+        return;
 
-        QImage newDisplayImage = m_graticuleImg.copy();
-        QPainter p(&newDisplayImage);
-        // Use "plus" composition so that light points will stand out on top of a graticule line.
-        p.setCompositionMode(QPainter::CompositionMode_Plus);
-        p.setRenderHint(QPainter::SmoothPixmapTransform, true);
-        p.setRenderHint(QPainter::Antialiasing, true);
-        p.drawImage(newDisplayImage.rect(), m_renderImg, m_renderImg.rect());
-        p.end();
+    qreal side = m_display->width();
+    QImage graticule = m_display->newGraticule();
+    QPainter p(&graticule);
+    p.setRenderHint(QPainter::Antialiasing, true);
 
-        m_mutex.lock();
-        m_displayImg.swap(newDisplayImage);
-        m_mutex.unlock();
-    } else {
-        m_mutex.lock();
-        m_displayImg = m_graticuleImg.copy();
-        m_mutex.unlock();
-    }
+    // Convert the coordinate system to match the U/V coordinate system
+    // 256x256 going up from the bottom
+    p.translate(0, side);
+    p.scale(side / 256.0, -1.0 * side / 256.0);
+
+    drawGraticuleLines(p, devicePixelRatioF());
+
+    drawGraticuleMark(p, m_points[BLUE_100], Qt::blue, devicePixelRatioF() * 2, 8);
+    drawGraticuleMark(p, m_points[CYAN_100], Qt::cyan, devicePixelRatioF() * 2, 8);
+    drawGraticuleMark(p, m_points[GREEN_100], Qt::green, devicePixelRatioF() * 2, 8);
+    drawGraticuleMark(p, m_points[YELLOW_100], Qt::yellow, devicePixelRatioF() * 2, 8);
+    drawGraticuleMark(p, m_points[RED_100], Qt::red, devicePixelRatioF() * 2, 8);
+    drawGraticuleMark(p, m_points[MAGENTA_100], Qt::magenta, devicePixelRatioF() * 2, 8);
+    drawGraticuleMark(p, m_points[BLUE_75], Qt::blue, devicePixelRatioF(), 5);
+    drawGraticuleMark(p, m_points[CYAN_75], Qt::cyan, devicePixelRatioF(), 5);
+    drawGraticuleMark(p, m_points[GREEN_75], Qt::green, devicePixelRatioF(), 5);
+    drawGraticuleMark(p, m_points[YELLOW_75], Qt::yellow, devicePixelRatioF(), 5);
+    drawGraticuleMark(p, m_points[RED_75], Qt::red, devicePixelRatioF(), 5);
+    drawGraticuleMark(p, m_points[MAGENTA_75], Qt::magenta, devicePixelRatioF(), 5);
+
+    drawSkinToneLine(p, devicePixelRatioF());
+
+    p.end();
+    m_display->setGraticule(graticule);
 }
 
 void VideoVectorScopeWidget::drawGraticuleLines(QPainter& p, qreal lineWidth)
@@ -206,26 +160,11 @@ void VideoVectorScopeWidget::drawGraticuleMark(QPainter& p, const QPoint& point,
     p.drawLine(angleline);
 }
 
-void VideoVectorScopeWidget::paintEvent(QPaintEvent*)
+void VideoVectorScopeWidget::resizeEvent(QResizeEvent* event)
 {
-    if (!isVisible())
-        return;
-
-    QRect squareRect = getCenteredSquare();
-
-    // Create the painter
-    QPainter p(this);
-    p.setRenderHint(QPainter::Antialiasing, true);
-    p.setRenderHint(QPainter::SmoothPixmapTransform, true);
-
-    // draw the vector image
-    m_mutex.lock();
-    if(!m_displayImg.isNull()) {
-        p.drawImage(squareRect, m_displayImg, m_displayImg.rect());
-    } else {
-        p.fillRect(squareRect, QBrush(Qt::black, Qt::SolidPattern));
-    }
-    m_mutex.unlock();
+    ScopeWidget::resizeEvent(event);
+    m_display->setGeometry(getCenteredSquare());
+    drawGraticule();
 }
 
 void VideoVectorScopeWidget::mouseMoveEvent(QMouseEvent *event)
@@ -260,7 +199,6 @@ QRect VideoVectorScopeWidget::getCenteredSquare()
 void VideoVectorScopeWidget::profileChanged()
 {
     LOG_DEBUG() << MLT.profile().colorspace();
-    m_mutex.lock();
     switch (MLT.profile().colorspace())
     {
     case 601:
@@ -293,7 +231,5 @@ void VideoVectorScopeWidget::profileChanged()
         m_points[MAGENTA_100] = QPoint(214, 230);
         break;
     }
-    m_profileChanged = true;
-    m_mutex.unlock();
-    requestRefresh();
+    drawGraticule();
 }
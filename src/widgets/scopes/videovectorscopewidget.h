@@ -19,15 +19,15 @@
 #define VIDEOVECTORSCOPEWIDGET_H
 
 #include "scopewidget.h"
-#include <QMutex>
-#include <QImage>
+#include "scopedensitydisplay.h"
+#include "videoscopeanalyzer.h"
 
 class VideoVectorScopeWidget Q_DECL_FINAL : public ScopeWidget
 {
     Q_OBJECT
 
 public:
-    explicit VideoVectorScopeWidget();
+    explicit VideoVectorScopeWidget(VideoScopeAnalyzer* analyzer);
     virtual ~VideoVectorScopeWidget();
     QString getTitle() Q_DECL_OVERRIDE;
 
@@ -51,25 +51,24 @@ private:
 
     // Called in scope thread
     void refreshScope(const QSize& size, bool full) Q_DECL_OVERRIDE;
+
+    // Called in UI thread
+    void drawGraticule();
     void drawGraticuleLines(QPainter& p, qreal lineWidth);
     void drawSkinToneLine(QPainter& p, qreal lineWidth);
     void drawGraticuleMark(QPainter& p, const QPoint& point, QColor color, qreal lineWidth, qreal LineLength);
 
-    // Called in UI thread
-    void paintEvent(QPaintEvent*) Q_DECL_OVERRIDE;
+    void resizeEvent(QResizeEvent*) Q_DECL_OVERRIDE;
     void mouseMoveEvent(QMouseEvent *event) Q_DECL_OVERRIDE;
     QRect getCenteredSquare();
 
     // Only accessed by the scope thread
+    VideoScopeAnalyzer* m_analyzer;
     SharedFrame m_frame;
-    QImage m_renderImg;
-    QImage m_graticuleImg;
 
-    // Variables accessed from multiple threads (mutex protected)
-    QMutex m_mutex;
-    QImage m_displayImg;
+    // Only accessed by the UI thread, except for m_display->setDensity()
+    ScopeDensityDisplay* m_display;
     QPoint m_points[COLOR_POINT_COUNT];
-    bool m_profileChanged;
 
 private slots:
     void profileChanged();
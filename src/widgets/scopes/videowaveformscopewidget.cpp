@@ -26,12 +26,13 @@ static const qreal IRE100 = 235;
 static const QColor TEXT_COLOR = {255, 255, 255, 127};
 
 
-VideoWaveformScopeWidget::VideoWaveformScopeWidget()
+VideoWaveformScopeWidget::VideoWaveformScopeWidget(VideoScopeAnalyzer* analyzer)
   : ScopeWidget("VideoWaveform")
+  , m_analyzer(analyzer)
   , m_frame()
-  , m_renderImg()
+  , m_display(new ScopeDensityDisplay(this))
   , m_mutex(QMutex::NonRecursive)
-  , m_displayImg()
+  , m_frameWidth(0)
 {
     LOG_DEBUG() << "begin";
     setMouseTracking(true);
@@ -41,55 +42,37 @@ VideoWaveformScopeWidget::VideoWaveformScopeWidget()
 
 void VideoWaveformScopeWidget::refreshScope(const QSize& size, bool full)
 {
-    Q_UNUSED(size)
     Q_UNUSED(full)
 
     while (m_queue.count() > 0) {
         m_frame = m_queue.pop();
     }
 
-    int width = m_frame.get_image_width();
-    int height = m_frame.get_image_height();
+    VideoScopeAnalysis analysis = m_analyzer->analyze(m_frame, VideoScopeAnalysis::LumaWaveform,
+                                                      qRound(size.width() * devicePixelRatioF()));
 
-    if (m_frame.is_valid() && width && height) {
-        if (m_renderImg.width() != width) {
-            m_renderImg = QImage(width, 256, QImage::Format_RGBX8888);
-        }
-
-        QColor bgColor( 0, 0, 0 ,0xff );
-        m_renderImg.fill(bgColor);
-
-        const uint8_t* src = m_frame.get_image(mlt_image_yuv420p);
-        uint8_t* dst = m_renderImg.scanLine(0);
-
-        for (int y = 0; y < height; y++) {
-            for (int x = 0; x < width; x++) {
-                uint8_t dy = 255 - src[0];
-                size_t dIndex = (dy * width + x) * 4;
-                if (dst[dIndex] < 0xff) {
-                    dst[dIndex] += 0x0f;
-                    dst[dIndex + 1] += 0x0f;
-                    dst[dIndex + 2] += 0x0f;
-                }
-                src ++;
-            }
-        }
-
-        QImage scaledImage = m_renderImg.scaled(size, Qt::IgnoreAspectRatio, Qt::SmoothTransformation).convertToFormat(QImage::Format_RGB32);
+    if (!analysis.lumaWaveform.isNull()) {
+        m_display->setDensity(analysis.lumaWaveform);
 
         m_mutex.lock();
-        m_displayImg.swap(scaledImage);
+        m_frameWidth = analysis.frameWidth;
         m_mutex.unlock();
     }
 }
 
-void VideoWaveformScopeWidget::paintEvent(QPaintEvent*)
+void VideoWaveformScopeWidget::resizeEvent(QResizeEvent* event)
+{
+    ScopeWidget::resizeEvent(event);
+    m_display->setGeometry(rect());
+    drawGraticule();
+}
+
+void VideoWaveformScopeWidget::drawGraticule()
 {
-    if (!isVisible())
-        return;
+    QImage graticule = m_display->newGraticule();
 
     // Create the painter
-    QPainter p(this);
+    QPainter p(&graticule);
     p.setRenderHint(QPainter::Antialiasing, true);
     QFont font = QWidget::font();
     int fontSize = font.pointSize() - (font.pointSize() > 10? 2 : (font.pointSize() > 8? 1 : 0));
@@ -101,16 +84,6 @@ void VideoWaveformScopeWidget::paintEvent(QPaintEvent*)
     p.setPen(pen);
     p.setFont(font);
 
-    // draw the waveform data
-    m_mutex.lock();
-    if(!m_displayImg.isNull()) {
-        p.drawImage(rect(), m_displayImg, m_displayImg.rect());
-    } else
-    {
-        p.fillRect(rect(), QBrush(Qt::black, Qt::SolidPattern));
-    }
-    m_mutex.unlock();
-
     // Add IRE lines
     int textpad = 3;
     // 100
@@ -124,6 +97,7 @@ void VideoWaveformScopeWidget::paintEvent(QPaintEvent*)
     p.drawText(textpad, ire0y + textRect.height() + textpad, tr("0"));
 
     p.end();
+    m_display->setGraticule(graticule);
 }
 
 void VideoWaveformScopeWidget::mouseMoveEvent(QMouseEvent *event)
@@ -135,7 +109,7 @@ void VideoWaveformScopeWidget::mouseMoveEvent(QMouseEvent *event)
     int ire = (ire0y - event->pos().y()) / ireStep;
 
     m_mutex.lock();
-    int frameWidth = m_displayImg.width();
+    int frameWidth = m_frameWidth;
     m_mutex.unlock();
 
     if(frameWidth != 0)
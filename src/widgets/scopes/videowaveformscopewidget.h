@@ -19,28 +19,31 @@
 #define VIDEOWAVEFORMSCOPEWIDGET_H
 
 #include "scopewidget.h"
+#include "scopedensitydisplay.h"
+#include "videoscopeanalyzer.h"
 #include <QMutex>
-#include <QImage>
 
 class VideoWaveformScopeWidget Q_DECL_FINAL : public ScopeWidget
 {
     Q_OBJECT
     
 public:
-    explicit VideoWaveformScopeWidget();
+    explicit VideoWaveformScopeWidget(VideoScopeAnalyzer* analyzer);
     QString getTitle() Q_DECL_OVERRIDE;
 
 private:
     void refreshScope(const QSize& size, bool full) Q_DECL_OVERRIDE;
-    void paintEvent(QPaintEvent*) Q_DECL_OVERRIDE;
+    void resizeEvent(QResizeEvent*) Q_DECL_OVERRIDE;
     void mouseMoveEvent(QMouseEvent *event) Q_DECL_OVERRIDE;
+    void drawGraticule();
 
+    VideoScopeAnalyzer* m_analyzer;
     SharedFrame m_frame;
-    QImage m_renderImg;
+    ScopeDensityDisplay* m_display;
 
     // Variables accessed from multiple threads (mutex protected)
     QMutex m_mutex;
-    QImage m_displayImg;
+    int m_frameWidth;
 };
 
 #endif // VIDEOWAVEFORMSCOPEWIDGET_H
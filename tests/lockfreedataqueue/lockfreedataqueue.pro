@@ -0,0 +1,7 @@
+include(../tests.pri)
+
+TARGET = tst_lockfreedataqueue
+
+SOURCES += tst_lockfreedataqueue.cpp
+HEADERS += $$SRC/dataqueue.h \
+    $$SRC/lockfreedataqueue.h
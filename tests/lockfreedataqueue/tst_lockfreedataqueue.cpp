@@ -0,0 +1,102 @@
+/*
+ * Copyright (c) 2021 Meltytech, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "dataqueue.h"
+#include "lockfreedataqueue.h"
+#include <QtTest>
+#include <QThread>
+
+// Items passed per iteration, split among the producers
+static const int kItems = 100000;
+static const int kQueueSize = 16;
+
+// Passes the numbers 1 to itemsPerThread from each of \a pairs producer
+// threads to as many consumer threads and returns the sum they received.
+template <class Queue>
+static quint64 passItems(int pairs, int itemsPerThread)
+{
+    Queue queue(kQueueSize, Queue::OverflowModeWait);
+    QAtomicInteger<quint64> sum(0);
+    QVector<QThread*> threads;
+    for (int i = 0; i < pairs; i++) {
+        threads << QThread::create([&queue, itemsPerThread]() {
+            for (int n = 1; n <= itemsPerThread; n++)
+                queue.push(n);
+        });
+        threads << QThread::create([&queue, &sum, itemsPerThread]() {
+            quint64 received = 0;
+            for (int n = 0; n < itemsPerThread; n++)
+                received += queue.pop();
+            sum.fetchAndAddOrdered(received);
+        });
+    }
+    for (QThread* thread : threads)
+        thread->start();
+    for (QThread* thread : threads) {
+        thread->wait();
+        delete thread;
+    }
+    return sum.load();
+}
+
+class BenchLockFreeDataQueue : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void passItems_data()
+    {
+        QTest::addColumn<bool>("isLockFree");
+        QTest::addColumn<int>("pairs");
+        for (int pairs : {1, 4, 16}) {
+            QTest::newRow(qPrintable(QString("DataQueue %1 pairs").arg(pairs))) << false << pairs;
+            QTest::newRow(qPrintable(QString("LockFreeDataQueue %1 pairs").arg(pairs))) << true << pairs;
+        }
+    }
+
+    void passItems()
+    {
+        QFETCH(bool, isLockFree);
+        QFETCH(int, pairs);
+        int itemsPerThread = kItems / pairs;
+        quint64 expected = quint64(pairs) * itemsPerThread * (itemsPerThread + 1) / 2;
+        quint64 sum = 0;
+        QBENCHMARK {
+            if (isLockFree)
+                sum = ::passItems<LockFreeDataQueue<int>>(pairs, itemsPerThread);
+            else
+                sum = ::passItems<DataQueue<int>>(pairs, itemsPerThread);
+        }
+        QCOMPARE(sum, expected);
+    }
+
+    void discardOldest()
+    {
+        LockFreeDataQueue<int> queue(3, LockFreeDataQueue<int>::OverflowModeDiscardOldest);
+        for (int n = 1; n <= 5; n++)
+            queue.push(n);
+        QCOMPARE(queue.count(), 3);
+        QCOMPARE(queue.discardedCount(), 2);
+        QCOMPARE(queue.pop(), 3);
+        QCOMPARE(queue.pop(), 4);
+        QCOMPARE(queue.pop(), 5);
+    }
+};
+
+QTEST_APPLESS_MAIN(BenchLockFreeDataQueue)
+
+#include "tst_lockfreedataqueue.moc"
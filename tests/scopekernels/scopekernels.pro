@@ -0,0 +1,8 @@
+include(../tests.pri)
+
+TARGET = tst_scopekernels
+INCLUDEPATH += $$SRC/widgets/scopes
+
+SOURCES += tst_scopekernels.cpp \
+    $$SRC/widgets/scopes/scopekernels.cpp
+HEADERS += $$SRC/widgets/scopes/scopekernels.h
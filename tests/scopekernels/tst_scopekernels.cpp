@@ -0,0 +1,205 @@
+/*
+ * Copyright (c) 2021 Meltytech, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "scopekernels.h"
+#include <QtTest>
+#include <QRandomGenerator>
+#include <QVector>
+
+Q_DECLARE_METATYPE(ScopeKernels::InstructionSet)
+
+// Straightforward versions of the kernels to compare against.
+
+static uint8_t referenceLevel(const uint16_t* counts, int i)
+{
+    return counts? qMin<int>(counts[i], 17) * 15 : 0;
+}
+
+static void referenceToneMapRow(const uint16_t* r, const uint16_t* g, const uint16_t* b, int width, uint8_t* dst)
+{
+    for (int x = 0; x < width; x++) {
+        dst[x * 4 + 0] = referenceLevel(r, x);
+        dst[x * 4 + 1] = referenceLevel(g, x);
+        dst[x * 4 + 2] = referenceLevel(b, x);
+        dst[x * 4 + 3] = 0xff;
+    }
+}
+
+static void referenceAdd(uint16_t& counter, int weight)
+{
+    counter = qMin(counter + weight, 0xffff);
+}
+
+// Counts that cover every tone level, the saturation point and the largest
+// values, so that the SIMD versions are caught on signed arithmetic.
+static QVector<uint16_t> randomCounts(QRandomGenerator& random, int count)
+{
+    static const uint16_t kSpecial[] = {0, 1, 16, 17, 18, 0x7fff, 0x8000, 0xfffe, 0xffff};
+    QVector<uint16_t> counts(count);
+    for (auto& c : counts) {
+        if (random.bounded(4) == 0)
+            c = kSpecial[random.bounded(int(sizeof(kSpecial) / sizeof(kSpecial[0])))];
+        else
+            c = random.bounded(24);
+    }
+    return counts;
+}
+
+static QVector<uint8_t> randomBytes(QRandomGenerator& random, int count)
+{
+    QVector<uint8_t> bytes(count);
+    for (auto& b : bytes)
+        b = random.bounded(256);
+    return bytes;
+}
+
+class TestScopeKernels : public QObject
+{
+    Q_OBJECT
+
+private:
+    void addInstructionSets()
+    {
+        QTest::addColumn<ScopeKernels::InstructionSet>("instructionSet");
+        QTest::newRow("c") << ScopeKernels::Portable;
+        QTest::newRow("sse2") << ScopeKernels::Sse2;
+        QTest::newRow("avx2") << ScopeKernels::Avx2;
+    }
+
+    void useInstructionSet()
+    {
+        QFETCH(ScopeKernels::InstructionSet, instructionSet);
+        if (!ScopeKernels::setInstructionSet(instructionSet))
+            QSKIP("The CPU does not support this instruction set");
+    }
+
+private slots:
+    void toneMapRow_data()
+    {
+        addInstructionSets();
+    }
+
+    void toneMapRow()
+    {
+        useInstructionSet();
+        QRandomGenerator random(1);
+        // Odd widths leave a tail after the vector loops.
+        for (int width : {1, 7, 8, 15, 16, 17, 31, 32, 33, 63, 257, 1921}) {
+            QVector<uint16_t> r = randomCounts(random, width);
+            QVector<uint16_t> g = randomCounts(random, width);
+            QVector<uint16_t> b = randomCounts(random, width);
+            const uint16_t* channels[][3] = {
+                {r.constData(), g.constData(), b.constData()},
+                {r.constData(), r.constData(), r.constData()},
+                {r.constData(), nullptr, nullptr},
+                {nullptr, g.constData(), nullptr},
+                {nullptr, nullptr, b.constData()},
+            };
+            for (const auto& c : channels) {
+                // One extra pixel catches writes past the end.
+                QVector<uint8_t> expected(width * 4 + 4, 0xaa);
+                QVector<uint8_t> actual(width * 4 + 4, 0xaa);
+                referenceToneMapRow(c[0], c[1], c[2], width, expected.data());
+                ScopeKernels::toneMapRow(c[0], c[1], c[2], width, actual.data());
+                QCOMPARE(actual, expected);
+            }
+        }
+    }
+
+    void addCounts_data()
+    {
+        addInstructionSets();
+    }
+
+    void addCounts()
+    {
+        useInstructionSet();
+        QRandomGenerator random(2);
+        for (int count : {1, 7, 8, 9, 15, 16, 17, 31, 33, 100, 256 * 256}) {
+            QVector<uint16_t> src = randomCounts(random, count);
+            QVector<uint16_t> expected = randomCounts(random, count + 1);
+            QVector<uint16_t> actual = expected;
+            for (int i = 0; i < count; i++)
+                referenceAdd(expected[i], src[i]);
+            ScopeKernels::addCounts(src.constData(), count, actual.data());
+            QCOMPARE(actual, expected);
+        }
+    }
+
+    void histogram_data()
+    {
+        QTest::addColumn<int>("step");
+        QTest::newRow("planar") << 1;
+        QTest::newRow("packed") << 2;
+        QTest::newRow("rgb") << 3;
+        QTest::newRow("rgba") << 4;
+    }
+
+    void histogram()
+    {
+        QFETCH(int, step);
+        QRandomGenerator random(3);
+        for (int width : {1, 3, 4, 5, 255, 1921}) {
+            QVector<uint8_t> src = randomBytes(random, width * step);
+            QVector<unsigned int> expected(256, 7);
+            for (int x = 0; x < width; x++)
+                expected[src[x * step]]++;
+            QVector<unsigned int> subBins(ScopeKernels::kSubHistograms * 256, 0);
+            ScopeKernels::histogramRow(src.constData(), width, step, subBins.data());
+            QVector<unsigned int> actual(256, 7);
+            ScopeKernels::reduceHistogram(subBins.constData(), actual.data());
+            QCOMPARE(actual, expected);
+        }
+    }
+
+    void waveform()
+    {
+        QRandomGenerator random(4);
+        for (int width : {1, 3, 17, 1921}) {
+            for (int weight : {1, 4, 0x7fff}) {
+                int stride = width + 5;
+                QVector<uint8_t> src = randomBytes(random, width * 2);
+                QVector<uint16_t> expected = randomCounts(random, stride * 256);
+                QVector<uint16_t> actual = expected;
+                for (int x = 0; x < width; x++)
+                    referenceAdd(expected[(255 - src[x * 2]) * stride + x], weight);
+                ScopeKernels::waveformRow(src.constData(), width, 2, actual.data(), stride, weight);
+                QCOMPARE(actual, expected);
+            }
+        }
+    }
+
+    void vectorscope()
+    {
+        QRandomGenerator random(5);
+        for (int width : {1, 3, 17, 961}) {
+            for (int weight : {1, 16, 0x7fff}) {
+                QVector<uint8_t> src = randomBytes(random, width * 4);
+                QVector<uint16_t> expected = randomCounts(random, 256 * 256);
+                QVector<uint16_t> actual = expected;
+                for (int x = 0; x < width; x++)
+                    referenceAdd(expected[(255 - src[x * 4 + 2]) * 256 + src[x * 4]], weight);
+                ScopeKernels::vectorscopeRow(src.constData(), src.constData() + 2, width, 4, actual.data(), weight);
+                QCOMPARE(actual, expected);
+            }
+        }
+    }
+};
+
+QTEST_APPLESS_MAIN(TestScopeKernels)
+
+#include "tst_scopekernels.moc"
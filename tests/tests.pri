@@ -0,0 +1,27 @@
+# Settings shared by the unit tests and benchmarks. Each one compiles the few
+# sources it tests from src instead of linking the application.
+
+QT += testlib
+QT -= gui
+CONFIG += testcase console
+CONFIG -= app_bundle
+
+SRC = $$PWD/../src
+INCLUDEPATH += $$SRC
+
+# Add shotcut_logger or shotcut_mlt to CONFIG before including this file to
+# link CuteLogger or MLT like the application does.
+shotcut_logger {
+    INCLUDEPATH += $$PWD/../CuteLogger/include
+    debug_and_release {
+        build_pass:CONFIG(debug, debug|release) {
+            LIBS += -L$$OUT_PWD/../../CuteLogger/debug
+        } else {
+            LIBS += -L$$OUT_PWD/../../CuteLogger/release
+        }
+    } else {
+        LIBS += -L$$OUT_PWD/../../CuteLogger
+    }
+    LIBS += -lCuteLogger
+}
+shotcut_mlt: include($$SRC/mlt.pri)
@@ -0,0 +1,140 @@
+/*
+ * Copyright (c) 2021 Meltytech, LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "scopekernels.h"
+#include "videoscopeanalyzer.h"
+#include <Mlt.h>
+#include <QtTest>
+
+Q_DECLARE_METATYPE(ScopeKernels::InstructionSet)
+Q_DECLARE_METATYPE(VideoScopeAnalysis::Features)
+
+// Makes a packed yuv422 frame with gradients and some noise so that the
+// histograms do not see long runs of equal values.
+static Mlt::Frame makeFrame(int width, int height)
+{
+    int size = width * height * 2;
+    uint8_t* image = static_cast<uint8_t*>(mlt_pool_alloc(size));
+    uint32_t noise = 2463534242u;
+    for (int y = 0; y < height; y++) {
+        uint8_t* row = image + y * width * 2;
+        for (int x = 0; x < width; x += 2) {
+            noise ^= noise << 13;
+            noise ^= noise >> 17;
+            noise ^= noise << 5;
+            int luma = 16 + (x * 219 / width + (noise & 0x1f)) % 220;
+            row[x * 2 + 0] = luma;
+            row[x * 2 + 1] = 16 + (y * 224 / height + (noise >> 8 & 0x0f)) % 225;
+            row[x * 2 + 2] = qMin(235, luma + int(noise >> 16 & 0x07));
+            row[x * 2 + 3] = 240 - (x * 224 / width + (noise >> 24 & 0x0f)) % 225;
+        }
+    }
+    mlt_frame init = mlt_frame_init(nullptr);
+    Mlt::Frame frame(init);
+    mlt_frame_close(init);
+    frame.set("image", image, size, mlt_pool_release);
+    frame.set("format", mlt_image_yuv422);
+    frame.set("width", width);
+    frame.set("height", height);
+    frame.set("colorspace", 709);
+    frame.set("full_luma", 0);
+    return frame;
+}
+
+class BenchVideoScopeAnalyzer : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase()
+    {
+        QVERIFY(Mlt::Factory::init());
+    }
+
+    void cleanupTestCase()
+    {
+        ScopeKernels::setInstructionSet(ScopeKernels::Portable);
+        m_frames.clear();
+        Mlt::Factory::close();
+    }
+
+    void analyze_data()
+    {
+        QTest::addColumn<QSize>("size");
+        QTest::addColumn<ScopeKernels::InstructionSet>("instructionSet");
+        QTest::addColumn<VideoScopeAnalysis::Features>("features");
+
+        const struct { const char* name; QSize size; } sizes[] = {
+            {"1080p", QSize(1920, 1080)},
+            {"4K", QSize(3840, 2160)},
+            {"8K", QSize(7680, 4320)},
+        };
+        const struct { const char* name; ScopeKernels::InstructionSet instructionSet; } instructionSets[] = {
+            {"c", ScopeKernels::Portable},
+            {"sse2", ScopeKernels::Sse2},
+            {"avx2", ScopeKernels::Avx2},
+        };
+        const struct { const char* name; VideoScopeAnalysis::Features features; } features[] = {
+            {"luma histogram", VideoScopeAnalysis::LumaHistogram},
+            {"rgb histogram", VideoScopeAnalysis::RgbHistogram},
+            {"luma waveform", VideoScopeAnalysis::LumaWaveform},
+            {"rgb waveform", VideoScopeAnalysis::RgbWaveform},
+            {"rgb parade", VideoScopeAnalysis::RgbParade},
+            {"vectorscope", VideoScopeAnalysis::Vectorscope},
+            {"all", VideoScopeAnalysis::AllFeatures},
+        };
+        for (const auto& s : sizes) {
+            for (const auto& i : instructionSets) {
+                for (const auto& f : features) {
+                    QTest::newRow(QString("%1 %2 %3").arg(s.name, i.name, f.name).toLatin1().constData())
+                            << s.size << i.instructionSet << f.features;
+                }
+            }
+        }
+    }
+
+    void analyze()
+    {
+        QFETCH(QSize, size);
+        QFETCH(ScopeKernels::InstructionSet, instructionSet);
+        QFETCH(VideoScopeAnalysis::Features, features);
+        if (!ScopeKernels::setInstructionSet(instructionSet))
+            QSKIP("The CPU does not support this instruction set");
+        auto it = m_frames.find(size.width());
+        if (it == m_frames.end())
+            it = m_frames.insert(size.width(), makeFrame(size.width(), size.height()));
+        Mlt::Frame& frame = it.value();
+
+        // A new analyzer per row computes only the features of the row, and
+        // a new SharedFrame per iteration is not found in its cache.
+        VideoScopeAnalyzer analyzer;
+        VideoScopeAnalysis analysis;
+        QBENCHMARK {
+            analysis = analyzer.analyze(SharedFrame(frame), features);
+        }
+        QCOMPARE(analysis.features & features, features);
+        QCOMPARE(analysis.frameWidth, size.width());
+    }
+
+private:
+    // Frames by width
+    QMap<int, Mlt::Frame> m_frames;
+};
+
+QTEST_GUILESS_MAIN(BenchVideoScopeAnalyzer)
+
+#include "tst_videoscopeanalyzer.moc"
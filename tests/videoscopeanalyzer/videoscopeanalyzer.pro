@@ -0,0 +1,15 @@
+CONFIG += shotcut_logger shotcut_mlt
+include(../tests.pri)
+
+QT += gui concurrent
+
+TARGET = tst_videoscopeanalyzer
+INCLUDEPATH += $$SRC/widgets/scopes
+
+SOURCES += tst_videoscopeanalyzer.cpp \
+    $$SRC/sharedframe.cpp \
+    $$SRC/widgets/scopes/scopekernels.cpp \
+    $$SRC/widgets/scopes/videoscopeanalyzer.cpp
+HEADERS += $$SRC/sharedframe.h \
+    $$SRC/widgets/scopes/scopekernels.h \
+    $$SRC/widgets/scopes/videoscopeanalyzer.h